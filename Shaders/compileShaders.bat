@@ -1,3 +1,22 @@
-C:/dev/VisualStudio/VulkanApp/VulkanApp/ExternalDependencies/VulkanSDK/Bin/glslc.exe shader.vert -o vert.spv
-C:/dev/VisualStudio/VulkanApp/VulkanApp/ExternalDependencies/VulkanSDK/Bin/glslc.exe shader.frag -o frag.spv
-pause
\ No newline at end of file
+@echo off
+rem Compiles the shaders into the .spv files that the shader directory override reads, and into the lists of words in
+rem Generated that are embedded into the executable. Run it after changing a shader and commit its output, glslc comes
+rem from the Vulkan SDK if it is installed and from the path otherwise
+cd /d "%~dp0"
+set GLSLC=glslc
+if defined VULKAN_SDK set GLSLC="%VULKAN_SDK%\Bin\glslc.exe"
+if not exist Generated mkdir Generated
+
+call :compile shader.vert vert.spv || goto :failed
+call :compile shader.frag frag.spv || goto :failed
+call :compile cull.comp cull.spv || goto :failed
+exit /b 0
+
+:compile
+%GLSLC% %1 -o %2 || exit /b 1
+%GLSLC% %1 -mfmt=num -o Generated\%1.inc || exit /b 1
+exit /b 0
+
+:failed
+echo Compiling the shaders failed
+exit /b 1
\ No newline at end of file
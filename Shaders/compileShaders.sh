@@ -0,0 +1,21 @@
+#!/bin/sh
+# Compiles the shaders into the .spv files that the shader directory override reads, and into the lists of words in
+# Generated that are embedded into the executable. Run it after changing a shader and commit its output, glslc comes
+# from the Vulkan SDK if it is installed and from the path otherwise
+set -e
+cd "$(dirname "$0")"
+GLSLC=glslc
+if [ -n "$VULKAN_SDK" ]; then
+	GLSLC="$VULKAN_SDK/bin/glslc"
+fi
+mkdir -p Generated
+
+compile()
+{
+	"$GLSLC" "$1" -o "$2"
+	"$GLSLC" "$1" -mfmt=num -o "Generated/$1.inc"
+}
+
+compile shader.vert vert.spv
+compile shader.frag frag.spv
+compile cull.comp cull.spv
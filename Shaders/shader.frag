@@ -1,9 +1,30 @@
 #version 450
 
 layout (location = 0) out vec4 outColor;
-layout (location = 0) in vec3 fragColor;
+layout (location = 0) in vec4 fragColor;
+
+//The constants of the frame, bound with a dynamic offset into the frame constant ring
+layout (set = 0, binding = 0) uniform FrameUniforms
+{
+    vec4 colorScale;
+    vec2 resolution;
+    float time;
+} frame;
+
+//The material handle of the draw, after the view transform that only the vertex shader reads
+layout (push_constant) uniform DrawConstants
+{
+    layout (offset = 16) uint materialHandle;
+} draw;
+
+//Every buffer of the bindless resource table, the size of the array depends on the graphics card
+layout (constant_id = 0) const uint BINDLESS_BUFFER_COUNT = 4096;
+layout (set = 1, binding = 0) readonly buffer MaterialBuffer
+{
+    vec4 color;
+} materials[BINDLESS_BUFFER_COUNT];
 
 void main()
 {
-    outColor = vec4(fragColor, 1.0f);
+    outColor = fragColor * frame.colorScale * materials[draw.materialHandle].color;
 }
\ No newline at end of file
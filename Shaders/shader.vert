@@ -1,23 +1,25 @@
 #version 450
 
-vec2 positions[3] = vec2[]
-(
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout (location = 0) in vec2 inPosition;
+layout (location = 1) in vec3 inColor;
 
-vec3 color[3] = vec3[]
-(
-    vec3(1.0f, 0.0f, 0.0f),
-    vec3(0.0f, 1.0f, 0.0f),
-    vec3(0.0f, 0.0f, 1.0f)
-);
+//Per instance attributes, the transform holds the offset in xy, the scale in z and the rotation in radians in w
+layout (location = 2) in vec4 inInstanceTransform;
+layout (location = 3) in vec4 inInstanceColor;
 
-layout (location = 0) out vec3 fragColor;
+layout (location = 0) out vec4 fragColor;
+
+//The view transform of the draw, the offset is in xy and the scale in zw
+layout (push_constant) uniform DrawConstants
+{
+    vec4 viewTransform;
+} draw;
 
 void main() 
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = color[gl_VertexIndex];
+    float s = sin(inInstanceTransform.w);
+    float c = cos(inInstanceTransform.w);
+    vec2 position = mat2(c, s, -s, c) * (inPosition * inInstanceTransform.z) + inInstanceTransform.xy;
+    gl_Position = vec4(position * draw.viewTransform.zw + draw.viewTransform.xy, 0.0, 1.0);
+    fragColor = vec4(inColor, 1.0) * inInstanceColor;
 }
\ No newline at end of file
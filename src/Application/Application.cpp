@@ -1,7 +1,8 @@
 #include "Application.h"
 
 Application::Application()
-	:m_window(), m_graphics()
+	:m_window(), m_graphics(), m_onDemandRendering(false), m_renderThreadEnabled(true), m_renderThread(), 
+	m_renderCommands(), m_renderWakeMutex(), m_renderWake(), m_renderThreadIdle(false)
 {
 
 }
@@ -15,11 +16,171 @@ void Application::Run()
 {
 	m_window.Init();
 	m_graphics.Init(m_window);
+	if (m_renderThreadEnabled)
+	{
+		RunWithRenderThread();
+	}
+	else
+	{
+		RunSingleThreaded();
+	}
+}
+
+void Application::RunSingleThreaded()
+{
 	while (!m_window.ShouldClose())
 	{
+		m_graphics.SetWindowState(m_window.GetState());
+		//With nothing new to draw the application sleeps until an event (or the idle timeout) wakes it up to check again
+		if (m_onDemandRendering && !m_graphics.NeedsRedraw())
+		{
+			m_window.WaitForEvents(ON_DEMAND_IDLE_TIMEOUT);
+			continue;
+		}
+		//Any waiting the frame pacing asks for happens before the input of the frame is polled
+		m_graphics.WaitForNextFrame();
 		m_window.MainLoop();
+		m_graphics.SetWindowState(m_window.GetState());
 		m_graphics.MainLoop();
 	}
 	m_window.Cleanup();
 	m_graphics.Cleanup();
+}
+
+void Application::RunWithRenderThread()
+{
+	//The graphics were initialized on this thread, starting the render thread makes everything they did visible to it
+	WindowState windowState = m_window.GetState();
+	m_renderThread = std::thread(&Application::RenderThreadLoop, this, windowState);
+
+	//The event thread sleeps until the window system has something for it, it never waits on the GPU
+	while (!m_window.ShouldClose())
+	{
+		m_window.WaitForEvents(0.0);
+		WindowState newWindowState = m_window.GetState();
+		if (newWindowState.resizeCount != windowState.resizeCount || newWindowState.damageCount != windowState.damageCount)
+		{
+			windowState = newWindowState;
+			RenderCommand command{};
+			command.type = RenderCommandType::WindowChanged;
+			command.windowState = windowState;
+			PostRenderCommand(command);
+		}
+	}
+
+	RenderCommand quitCommand{};
+	quitCommand.type = RenderCommandType::Quit;
+	PostRenderCommand(quitCommand);
+	m_renderThread.join();
+	//The surface is destroyed with the graphics, before the window it was created for
+	m_graphics.Cleanup();
+	m_window.Cleanup();
+}
+
+void Application::RenderThreadLoop(WindowState windowState)
+{
+	bool running = true;
+	while (running)
+	{
+		RenderCommand command;
+		while (running && m_renderCommands.TryPop(command))
+		{
+			if (command.type == RenderCommandType::WindowChanged)
+			{
+				windowState = command.windowState;
+			}
+			running = ApplyRenderCommand(command);
+		}
+		if (!running)
+		{
+			break;
+		}
+
+		/* A minimized window has nothing to render to, and rendering on demand has nothing to render while nothing changed.
+		   Either way the render thread sleeps until the event thread sends it something, or the idle timeout passes */
+		if (windowState.IsMinimized() || (m_onDemandRendering && !m_graphics.NeedsRedraw()))
+		{
+			std::unique_lock<std::mutex> lock(m_renderWakeMutex);
+			m_renderThreadIdle = true;
+			m_renderWake.wait_for(lock, std::chrono::duration<double>(ON_DEMAND_IDLE_TIMEOUT), 
+				[this]() { return !m_renderCommands.IsEmpty(); });
+			m_renderThreadIdle = false;
+			continue;
+		}
+		m_graphics.WaitForNextFrame();
+		m_graphics.MainLoop();
+	}
+}
+
+bool Application::ApplyRenderCommand(const RenderCommand& command)
+{
+	switch (command.type)
+	{
+	case RenderCommandType::WindowChanged:
+		m_graphics.SetWindowState(command.windowState);
+		break;
+	case RenderCommandType::SetFramePacing:
+		m_graphics.SetFramePacing(command.framePacing);
+		break;
+	case RenderCommandType::SetInstanceCount:
+		m_graphics.SetInstanceCount(command.instanceCount);
+		break;
+	case RenderCommandType::Quit:
+		return false;
+	}
+	return true;
+}
+
+void Application::PostRenderCommand(const RenderCommand& command)
+{
+	//The queue only fills up if the render thread is stalled, the command is not dropped but waits for room instead
+	while (!m_renderCommands.TryPush(command))
+	{
+		std::this_thread::yield();
+	}
+	/* The fence orders the push before reading the idle flag, pairing with the render thread setting the flag before it
+	   checks the queue, so at least one of the two sides sees the other. Locking the mutex before notifying makes sure the 
+	   render thread is either still before its check or already waiting */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_renderThreadIdle)
+	{
+		std::lock_guard<std::mutex> lock(m_renderWakeMutex);
+		m_renderWake.notify_one();
+	}
+}
+
+void Application::SetFramePacing(const FramePacingSettings& framePacing)
+{
+	if (!m_renderThread.joinable())
+	{
+		m_graphics.SetFramePacing(framePacing);
+		return;
+	}
+	RenderCommand command{};
+	command.type = RenderCommandType::SetFramePacing;
+	command.framePacing = framePacing;
+	PostRenderCommand(command);
+}
+
+void Application::SetInstanceCount(uint32_t instanceCount)
+{
+	if (!m_renderThread.joinable())
+	{
+		m_graphics.SetInstanceCount(instanceCount);
+		return;
+	}
+	RenderCommand command{};
+	command.type = RenderCommandType::SetInstanceCount;
+	command.instanceCount = instanceCount;
+	PostRenderCommand(command);
+}
+
+void Application::RunHeadless(uint32_t width, uint32_t height, uint32_t frameCount)
+{
+	m_graphics.InitHeadless(width, height);
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		m_graphics.MainLoop();
+	}
+	m_graphics.Cleanup();
 }
\ No newline at end of file
@@ -1,6 +1,34 @@
 #pragma once
 
 #include "Graphics/Vulkan/VulkanGraphics.h"
+#include "SpscQueue.h"
+#include <atomic>
+
+/* How long rendering on demand sleeps in the window system before checking again if anything changed, in seconds. Changes
+   that arrive without an event (like an upload or a pipeline finishing) are picked up at the latest after this long */
+constexpr double ON_DEMAND_IDLE_TIMEOUT = 0.25;
+
+//The amount of commands the event thread can queue for the render thread before it has to wait for it
+constexpr uint32_t RENDER_COMMAND_QUEUE_CAPACITY = 256;
+
+enum class RenderCommandType
+{
+	//The window's events changed its state, the graphics get the new state before their next frame
+	WindowChanged,
+	SetFramePacing,
+	SetInstanceCount,
+	//Stops the render thread once it has applied the commands before it
+	Quit
+};
+
+//An event or a scene update that the event thread sends to the render thread, only the fields of its type are used
+struct RenderCommand
+{
+	RenderCommandType type;
+	WindowState windowState;
+	FramePacingSettings framePacing;
+	uint32_t instanceCount;
+};
 
 class Application
 {
@@ -10,7 +38,54 @@ public:
 	~Application();
 
 	void Run();
+
+	//Renders the given amount of frames offscreen, without creating a window
+	void RunHeadless(uint32_t width, uint32_t height, uint32_t frameCount);
+
+	/* Sets how the frames are paced against the display, see VulkanGraphics::SetFramePacing. While the render thread is
+	   running this is sent to it through the render command queue, like any other change to the scene */
+	void SetFramePacing(const FramePacingSettings& framePacing);
+
+	//Lays out the amount of instances passed in a grid, see VulkanGraphics::SetInstanceCount
+	void SetInstanceCount(uint32_t instanceCount);
+
+	/* Only draws a frame when something marked it dirty (the scene, the window or an animation) and sleeps in the window 
+	   system otherwise, instead of drawing the same image as fast as possible */
+	inline void SetOnDemandRendering(bool enabled) { m_onDemandRendering = enabled; }
+
+	/* Runs the graphics on their own thread, so that stalls in processing the window's events (like dragging or resizing
+	   it) don't hold back frames and waiting on the GPU doesn't hold back the events. Enabled by default, needs to be 
+	   called before Run to take effect */
+	inline void SetRenderThread(bool enabled) { m_renderThreadEnabled = enabled; }
+private:
+	//Polls the window's events and draws the frames on the calling thread
+	void RunSingleThreaded();
+
+	/* The calling thread owns the window and only waits for and processes its events, sending the changes to the render 
+	   thread. The window is destroyed only after the render thread has stopped and the graphics have been cleaned up */
+	void RunWithRenderThread();
+
+	/* Draws frames on the render thread, applying the commands that the event thread queued before each one. The state of 
+	   the window is passed in when the thread starts, after that it only arrives through the queue */
+	void RenderThreadLoop(WindowState windowState);
+
+	//Called by the render thread, returns false for the command that stops it
+	bool ApplyRenderCommand(const RenderCommand& command);
+
+	//Called by the event thread, wakes the render thread if it is sleeping because there was nothing to draw
+	void PostRenderCommand(const RenderCommand& command);
+
 private:
 	WindowHandle m_window;
 	VulkanGraphics m_graphics;
+	bool m_onDemandRendering;
+
+	/* The render thread is the only one that touches the graphics while it runs. The queue itself never locks, the mutex 
+	   and condition variable are only used to wake the render thread up when it went to sleep with nothing to draw */
+	bool m_renderThreadEnabled;
+	std::thread m_renderThread;
+	SpscQueue<RenderCommand, RENDER_COMMAND_QUEUE_CAPACITY> m_renderCommands;
+	std::mutex m_renderWakeMutex;
+	std::condition_variable m_renderWake;
+	std::atomic<bool> m_renderThreadIdle;
 };
\ No newline at end of file
@@ -1,8 +1,43 @@
 #include "Application.h"
+#include <cstring>
+#include <cstdlib>
 
-int main()
+int main(int argc, char** argv)
 {
 	Application* main = new Application();
-	main->Run();
+	//Passing --single-thread draws the frames on the same thread that processes the window's events
+	if (argc > 1 && !strcmp(argv[1], "--single-thread"))
+	{
+		main->SetRenderThread(false);
+		main->Run();
+	}
+	//Passing --on-demand only renders when something changed, which keeps static content from using the CPU and the GPU
+	else if (argc > 1 && !strcmp(argv[1], "--on-demand"))
+	{
+		main->SetOnDemandRendering(true);
+		main->Run();
+	}
+	/* Passing --low-latency [fps] paces the frames for the lowest input latency, optionally with a frame limiter, and
+	   --throughput renders frames as fast as possible */
+	else if (argc > 1 && !strcmp(argv[1], "--low-latency"))
+	{
+		main->SetFramePacing(LowLatencyFramePacing(argc > 2 ? atof(argv[2]) : 0.0));
+		main->Run();
+	}
+	else if (argc > 1 && !strcmp(argv[1], "--throughput"))
+	{
+		main->SetFramePacing(ThroughputFramePacing());
+		main->Run();
+	}
+	//Passing --headless [frames] renders offscreen, without a window or a swapchain
+	else if (argc > 1 && !strcmp(argv[1], "--headless"))
+	{
+		uint32_t frameCount = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1000;
+		main->RunHeadless(720, 560, frameCount);
+	}
+	else
+	{
+		main->Run();
+	}
 	delete main;
 }
\ No newline at end of file
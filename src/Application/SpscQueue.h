@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/* A fixed size ring that one thread pushes to and one other thread pops from without locking. The producer only writes
+   the tail and the consumer only writes the head, each one publishing its slot with a release store that the other side
+   reads with an acquire load. The head and tail are kept on separate cache lines so the two threads don't keep taking
+   the line from each other */
+template<typename T, uint32_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "The capacity of the queue needs to be a power of 2");
+public:
+	SpscQueue()
+		:m_items(), m_head(0), m_tail(0)
+	{
+
+	}
+
+	//Called only by the producer, returns false without pushing if the queue is full
+	bool TryPush(const T& item)
+	{
+		uint32_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		m_items[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//Called only by the consumer, returns false if there was nothing to pop
+	bool TryPop(T& item)
+	{
+		uint32_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		item = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool IsEmpty() const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+
+private:
+	T m_items[Capacity];
+	alignas(64) std::atomic<uint32_t> m_head;
+	alignas(64) std::atomic<uint32_t> m_tail;
+};
\ No newline at end of file
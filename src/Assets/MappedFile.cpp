@@ -0,0 +1,124 @@
+#include "MappedFile.h"
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	:m_data(nullptr), m_size(0)
+#ifdef _WIN32
+	, m_fileHandle(nullptr), m_mappingHandle(nullptr)
+#endif
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	:MappedFile()
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+#ifdef _WIN32
+		std::swap(m_fileHandle, other.m_fileHandle);
+		std::swap(m_mappingHandle, other.m_mappingHandle);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	//A mapping can't be created for an empty file
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	int file = open(filename, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat fileStatus;
+	if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+	void* data = mmap(nullptr, static_cast<size_t>(fileStatus.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	//The mapping keeps its own reference to the file
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	m_size = static_cast<size_t>(fileStatus.st_size);
+	madvise(data, m_size, MADV_SEQUENTIAL);
+#endif
+	m_data = static_cast<const unsigned char*>(data);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!m_data)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mappingHandle);
+	CloseHandle(m_fileHandle);
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+#else
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+
+/* Maps a whole file into the address space read only, so it can be read straight out of the page cache without copying
+   it into memory of our own. The pages are only read in from disk when they are first touched, and the system can drop 
+   them again under memory pressure since the file backs them */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/* Maps the file, closing the file that was mapped before. The pages are expected to be read from start to end once, 
+	   which lets the system read ahead of them. Returns false if the file can't be opened or mapped */
+	bool Open(const char* filename);
+
+	//Unmaps the file, the pointers into it are no longer valid
+	void Close();
+
+	inline const unsigned char* GetData() const { return m_data; }
+
+	inline size_t GetSize() const { return m_size; }
+
+	inline bool IsOpen() const { return m_data != nullptr; }
+
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	//The file and mapping handles of the view, they stay open for as long as the view is mapped
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "MeshFile.h"
+#include <fstream>
+#include <utility>
+
+//The zeros written after a section to pad the next one to the section alignment
+static const char SECTION_PADDING[MESH_FILE_SECTION_ALIGNMENT] = {};
+
+static uint64_t AlignSectionOffset(uint64_t offset)
+{
+	return (offset + MESH_FILE_SECTION_ALIGNMENT - 1) & ~(MESH_FILE_SECTION_ALIGNMENT - 1);
+}
+
+uint64_t ComputeMeshFileChecksum(const void* data, uint64_t size)
+{
+	//The sections start on a page, so the words can be read in place
+	const uint32_t* words = static_cast<const uint32_t*>(data);
+	uint64_t wordCount = size / sizeof(uint32_t);
+	uint64_t sum = 0;
+	uint64_t sumOfSums = 0;
+	for (uint64_t i = 0; i < wordCount; ++i)
+	{
+		sum += words[i];
+		sumOfSums += sum;
+	}
+	return (sumOfSums << 32) ^ sum;
+}
+
+//Returns false if any of the indices is outside of the vertices, the draws would read past the end of the vertex buffer
+static bool AreIndicesInRange(const uint32_t* indices, uint32_t indexCount, uint32_t vertexCount)
+{
+	for (uint32_t i = 0; i < indexCount; ++i)
+	{
+		if (indices[i] >= vertexCount)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool WriteMeshFile(const char* filename, uint32_t vertexFormat, const void* vertices, uint32_t vertexStride, 
+	uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, float boundingRadius)
+{
+	if (vertexStride % sizeof(uint32_t) != 0 || !AreIndicesInRange(indices, indexCount, vertexCount))
+	{
+		return false;
+	}
+	std::ofstream meshFile(filename, std::ios::binary | std::ios::trunc);
+	if (!meshFile.is_open())
+	{
+		return false;
+	}
+
+	MeshFileHeader header{};
+	header.magic = MESH_FILE_MAGIC;
+	header.version = MESH_FILE_VERSION;
+	header.vertexFormat = vertexFormat;
+	header.vertexStride = vertexStride;
+	header.vertexCount = vertexCount;
+	header.indexCount = indexCount;
+	header.boundingRadius = boundingRadius;
+	header.vertices.offset = AlignSectionOffset(sizeof(MeshFileHeader));
+	header.vertices.size = static_cast<uint64_t>(vertexStride) * vertexCount;
+	header.vertices.checksum = ComputeMeshFileChecksum(vertices, header.vertices.size);
+	header.indices.offset = AlignSectionOffset(header.vertices.offset + header.vertices.size);
+	header.indices.size = sizeof(uint32_t) * static_cast<uint64_t>(indexCount);
+	header.indices.checksum = ComputeMeshFileChecksum(indices, header.indices.size);
+
+	meshFile.write(reinterpret_cast<const char*>(&header), sizeof(MeshFileHeader));
+	meshFile.write(SECTION_PADDING, header.vertices.offset - sizeof(MeshFileHeader));
+	meshFile.write(static_cast<const char*>(vertices), header.vertices.size);
+	meshFile.write(SECTION_PADDING, header.indices.offset - header.vertices.offset - header.vertices.size);
+	meshFile.write(reinterpret_cast<const char*>(indices), header.indices.size);
+	return meshFile.good();
+}
+
+MeshFile::MeshFile()
+	:m_file(), m_header(nullptr)
+{
+
+}
+
+MeshFile::~MeshFile()
+{
+
+}
+
+MeshFile::MeshFile(MeshFile&& other) noexcept
+	:MeshFile()
+{
+	*this = std::move(other);
+}
+
+MeshFile& MeshFile::operator=(MeshFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_file = std::move(other.m_file);
+		m_header = other.m_header;
+		other.m_header = nullptr;
+	}
+	return *this;
+}
+
+bool MeshFile::Open(const char* filename)
+{
+	Close();
+	if (!m_file.Open(filename))
+	{
+		return false;
+	}
+	if (m_file.GetSize() < sizeof(MeshFileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	//The mapping starts on a page, so the header can be read in place
+	m_header = reinterpret_cast<const MeshFileHeader*>(m_file.GetData());
+	if (!ValidateHeader(*m_header, m_file.GetSize()) ||
+		ComputeMeshFileChecksum(GetVertexData(), m_header->vertices.size) != m_header->vertices.checksum ||
+		ComputeMeshFileChecksum(GetIndexData(), m_header->indices.size) != m_header->indices.checksum ||
+		!AreIndicesInRange(GetIndexData(), m_header->indexCount, m_header->vertexCount))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MeshFile::Close()
+{
+	m_file.Close();
+	m_header = nullptr;
+}
+
+bool MeshFile::ValidateHeader(const MeshFileHeader& header, uint64_t fileSize)
+{
+	if (header.magic != MESH_FILE_MAGIC || header.version != MESH_FILE_VERSION || header.vertexStride == 0 ||
+		header.vertexStride % sizeof(uint32_t) != 0)
+	{
+		return false;
+	}
+	//The sizes are checked against the counts, and the ranges against the file, so nothing is read outside of the file
+	if (header.vertices.size != static_cast<uint64_t>(header.vertexStride) * header.vertexCount ||
+		header.indices.size != sizeof(uint32_t) * static_cast<uint64_t>(header.indexCount))
+	{
+		return false;
+	}
+	const MeshFileSection* sections[] = { &header.vertices, &header.indices };
+	for (const MeshFileSection* section : sections)
+	{
+		if (section->offset % MESH_FILE_SECTION_ALIGNMENT != 0 || section->offset > fileSize || 
+			section->size > fileSize - section->offset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include "MappedFile.h"
+
+/* The binary mesh container. A fixed header is followed by the vertex and the index sections, each one starting on its 
+   own page so that the pages of a section can be copied straight out of a mapping of the file. Everything is stored 
+   little endian, exactly as the vertex and index buffers expect it, so nothing needs to be converted when loading */
+constexpr uint32_t MESH_FILE_MAGIC = 0x48534D56; //"VMSH"
+constexpr uint32_t MESH_FILE_VERSION = 2;
+constexpr uint64_t MESH_FILE_SECTION_ALIGNMENT = 4096;
+
+//Where a section is in the file, its size in bytes without the padding after it and the checksum of those bytes
+struct MeshFileSection
+{
+	uint64_t offset;
+	uint64_t size;
+	uint64_t checksum;
+};
+
+struct MeshFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	//The layout of the vertices (which the renderer defines) and their size in bytes, the indices are always 32 bits
+	uint32_t vertexFormat;
+	uint32_t vertexStride;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	//The distance of the farthest vertex from the origin of the mesh, stored so that loading doesn't need to compute it
+	float boundingRadius;
+	uint32_t reserved;
+	MeshFileSection vertices;
+	MeshFileSection indices;
+};
+static_assert(sizeof(MeshFileHeader) == 80, "The mesh file header needs to have the same layout everywhere");
+
+/* A checksum of 32 bit words in the style of Fletcher's, the second sum makes it depend on the order of the words. The 
+   size needs to be a multiple of 4 bytes */
+uint64_t ComputeMeshFileChecksum(const void* data, uint64_t size);
+
+/* Writes the vertices and indices into a mesh file. The vertex stride needs to be a multiple of 4 bytes and the indices 
+   need to be less than the vertex count. Returns false if the file can't be written */
+bool WriteMeshFile(const char* filename, uint32_t vertexFormat, const void* vertices, uint32_t vertexStride, 
+	uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount, float boundingRadius);
+
+/* A mesh file that is mapped into memory, its sections are read straight out of the mapping. The sections are only 
+   valid while the file is open */
+class MeshFile
+{
+public:
+	MeshFile();
+	~MeshFile();
+
+	MeshFile(const MeshFile&) = delete;
+	MeshFile& operator=(const MeshFile&) = delete;
+	//The mesh file moved from is left closed, its header pointed into the mapping that moved
+	MeshFile(MeshFile&& other) noexcept;
+	MeshFile& operator=(MeshFile&& other) noexcept;
+
+	/* Maps the file and checks its header, that the sections are inside the file, that their checksums match and that 
+	   every index refers to a vertex of the file. Returns false (and leaves the mesh file closed) if any of it fails */
+	bool Open(const char* filename);
+
+	void Close();
+
+	inline const MeshFileHeader& GetHeader() const { return *m_header; }
+
+	inline const void* GetVertexData() const { return m_file.GetData() + m_header->vertices.offset; }
+
+	inline const uint32_t* GetIndexData() const 
+	{ 
+		return reinterpret_cast<const uint32_t*>(m_file.GetData() + m_header->indices.offset); 
+	}
+
+	inline bool IsOpen() const { return m_file.IsOpen(); }
+
+	//Checks a header that was read from a file of the size passed, without checking the checksums of the sections
+	static bool ValidateHeader(const MeshFileHeader& header, uint64_t fileSize);
+
+private:
+	MappedFile m_file;
+	const MeshFileHeader* m_header;
+};
\ No newline at end of file
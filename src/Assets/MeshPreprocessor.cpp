@@ -0,0 +1,302 @@
+#include "MeshPreprocessor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+//The size of the cache that the vertex cache optimization simulates, the scores fall off over it
+constexpr uint32_t OPTIMIZER_CACHE_SIZE = 32;
+
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+	/* A vertex is in the cache if it was added less than the cache size of misses ago, which is what first in first out
+	   replacement comes down to */
+	std::vector<uint32_t> addedAtMiss(vertexCount, 0);
+	uint32_t misses = 0;
+	uint32_t usedVertices = 0;
+	for (uint32_t index : indices)
+	{
+		if (addedAtMiss[index] == 0)
+		{
+			++usedVertices;
+		}
+		else if (misses - addedAtMiss[index] < cacheSize)
+		{
+			continue;
+		}
+		addedAtMiss[index] = ++misses;
+	}
+
+	VertexCacheStatistics statistics{};
+	statistics.misses = misses;
+	statistics.acmr = indices.size() >= 3 ? static_cast<double>(misses) / (indices.size() / 3) : 0.0;
+	statistics.atvr = usedVertices ? static_cast<double>(misses) / usedVertices : 0.0;
+	return statistics;
+}
+
+//Vertices with more triangles left than this share the score of this amount, which is already close to 0
+constexpr uint32_t OPTIMIZER_MAX_VALENCE = 32;
+
+/* The scores of Forsyth's algorithm, computed once since they only depend on the cache position and on the amount of 
+   triangles left. Vertices of the last triangle get a fixed score so that the next triangle doesn't just reuse all of 
+   them, the rest of the cache scores higher the more recently it was used, and vertices with few triangles left score 
+   higher so that they are finished off instead of being left behind */
+struct VertexScoreTables
+{
+	float cache[OPTIMIZER_CACHE_SIZE];
+	float valence[OPTIMIZER_MAX_VALENCE + 1];
+
+	VertexScoreTables()
+	{
+		for (uint32_t position = 0; position < 3; ++position)
+		{
+			cache[position] = 0.75f;
+		}
+		for (uint32_t position = 3; position < OPTIMIZER_CACHE_SIZE; ++position)
+		{
+			float falloff = 1.0f - static_cast<float>(position - 3) / (OPTIMIZER_CACHE_SIZE - 3);
+			cache[position] = std::pow(falloff, 1.5f);
+		}
+		valence[0] = 0.0f;
+		for (uint32_t triangles = 1; triangles <= OPTIMIZER_MAX_VALENCE; ++triangles)
+		{
+			valence[triangles] = 2.0f / std::sqrt(static_cast<float>(triangles));
+		}
+	}
+};
+
+static float VertexScore(const VertexScoreTables& tables, int32_t cachePosition, uint32_t remainingTriangles)
+{
+	if (remainingTriangles == 0)
+	{
+		return -1.0f;
+	}
+	return (cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f) + 
+		tables.valence[std::min(remainingTriangles, OPTIMIZER_MAX_VALENCE)];
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+	uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	//The triangles of every vertex, the triangles of a vertex are a range that shrinks as they are emitted
+	std::vector<uint32_t> remainingTriangles(vertexCount, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; ++i)
+	{
+		++remainingTriangles[indices[i]];
+	}
+	std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		triangleOffsets[vertex + 1] = triangleOffsets[vertex] + remainingTriangles[vertex];
+	}
+	std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+	std::vector<uint32_t> fillCounts(vertexCount, 0);
+	for (uint32_t triangle = 0; triangle < triangleCount; ++triangle)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = indices[triangle * 3 + corner];
+			vertexTriangles[triangleOffsets[vertex] + fillCounts[vertex]++] = triangle;
+		}
+	}
+
+	const VertexScoreTables scoreTables;
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		vertexScores[vertex] = VertexScore(scoreTables, -1, remainingTriangles[vertex]);
+	}
+	std::vector<bool> emitted(triangleCount, false);
+	//The step at which a vertex was last put in the next cache, so that it isn't put in twice
+	std::vector<uint32_t> cachedAtStep(vertexCount, UINT32_MAX);
+
+	//The cache holds 3 more entries while it is updated, since the vertices of the new triangle go in first
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+	nextCache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+	std::vector<uint32_t> optimizedIndices;
+	optimizedIndices.reserve(triangleCount * 3);
+	uint32_t scanCursor = 0;
+	int64_t bestTriangle = -1;
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		//No triangle of the cache is left, the next one is the first triangle that hasn't been emitted
+		if (bestTriangle < 0)
+		{
+			while (emitted[scanCursor])
+			{
+				++scanCursor;
+			}
+			bestTriangle = scanCursor;
+		}
+		uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+		const uint32_t* corners = &indices[triangle * 3];
+		optimizedIndices.insert(optimizedIndices.end(), corners, corners + 3);
+		emitted[triangle] = true;
+
+		//Removing the triangle from its vertices and moving them to the front of the cache
+		nextCache.clear();
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			uint32_t vertex = corners[corner];
+			uint32_t* triangles = &vertexTriangles[triangleOffsets[vertex]];
+			uint32_t* triangleEnd = triangles + remainingTriangles[vertex];
+			*std::find(triangles, triangleEnd, triangle) = *(triangleEnd - 1);
+			--remainingTriangles[vertex];
+			if (cachedAtStep[vertex] != emittedCount)
+			{
+				cachedAtStep[vertex] = emittedCount;
+				nextCache.push_back(vertex);
+			}
+		}
+		for (uint32_t vertex : cache)
+		{
+			if (cachedAtStep[vertex] != emittedCount)
+			{
+				cachedAtStep[vertex] = emittedCount;
+				nextCache.push_back(vertex);
+			}
+		}
+
+		//The vertices that fell out of the cache lose their cache score, the rest are scored by their new position
+		for (size_t position = 0; position < nextCache.size(); ++position)
+		{
+			uint32_t vertex = nextCache[position];
+			cachePositions[vertex] = position < OPTIMIZER_CACHE_SIZE ? static_cast<int32_t>(position) : -1;
+			vertexScores[vertex] = VertexScore(scoreTables, cachePositions[vertex], remainingTriangles[vertex]);
+		}
+		if (nextCache.size() > OPTIMIZER_CACHE_SIZE)
+		{
+			nextCache.resize(OPTIMIZER_CACHE_SIZE);
+		}
+		std::swap(cache, nextCache);
+
+		//Only the triangles of the vertices whose score changed can become the best one
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (uint32_t vertex : cache)
+		{
+			for (uint32_t i = 0; i < remainingTriangles[vertex]; ++i)
+			{
+				uint32_t candidate = vertexTriangles[triangleOffsets[vertex] + i];
+				const uint32_t* candidateCorners = &indices[candidate * 3];
+				float score = vertexScores[candidateCorners[0]] + vertexScores[candidateCorners[1]] + 
+					vertexScores[candidateCorners[2]];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestTriangle = candidate;
+				}
+			}
+		}
+	}
+	indices.swap(optimizedIndices);
+}
+
+uint32_t OptimizeVertexFetch(void* vertices, uint32_t vertexStride, uint32_t vertexCount, std::vector<uint32_t>& indices)
+{
+	std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+	uint32_t nextVertex = 0;
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == UINT32_MAX)
+		{
+			remap[index] = nextVertex++;
+		}
+		index = remap[index];
+	}
+
+	//The vertices are copied out first, since moving them in place would overwrite the ones that haven't moved yet
+	unsigned char* vertexData = static_cast<unsigned char*>(vertices);
+	std::vector<unsigned char> originalVertices(vertexData, vertexData + static_cast<size_t>(vertexStride) * vertexCount);
+	for (uint32_t vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		if (remap[vertex] != UINT32_MAX)
+		{
+			std::memcpy(vertexData + static_cast<size_t>(remap[vertex]) * vertexStride, 
+				originalVertices.data() + static_cast<size_t>(vertex) * vertexStride, vertexStride);
+		}
+	}
+	return nextVertex;
+}
+
+uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(float));
+	uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+
+	//Infinity stays infinite and NaN keeps a mantissa bit so that it stays NaN
+	if (magnitude >= 0x7F800000)
+	{
+		return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+	}
+	//65520 and above round past the largest half (65504)
+	if (magnitude >= 0x477FF000)
+	{
+		return sign | 0x7C00;
+	}
+	//Below the smallest normal half (2^-14) the value becomes subnormal, and below half the smallest subnormal it is 0
+	if (magnitude < 0x38800000)
+	{
+		if (magnitude < 0x33000000)
+		{
+			return sign;
+		}
+		uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+		uint32_t shift = 126 - (magnitude >> 23);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+		{
+			++half;
+		}
+		return sign | static_cast<uint16_t>(half);
+	}
+	//Rebiasing the exponent from 127 to 15, rounding up can carry into the exponent, which is still the right value
+	uint32_t half = (magnitude - 0x38000000) >> 13;
+	uint32_t remainder = magnitude & 0x1FFF;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		++half;
+	}
+	return sign | static_cast<uint16_t>(half);
+}
+
+float HalfToFloat(uint16_t half)
+{
+	uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+	uint32_t bits;
+	if (exponent == 0x1F)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else
+	{
+		//Subnormal halves are a multiple of 2^-24, which is a normal float
+		float value = std::ldexp(static_cast<float>(mantissa), -24);
+		return sign ? -value : value;
+	}
+	float value;
+	std::memcpy(&value, &bits, sizeof(float));
+	return value;
+}
+
+uint8_t FloatToUnorm8(float value)
+{
+	return static_cast<uint8_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
\ No newline at end of file
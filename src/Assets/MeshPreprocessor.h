@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/* Prepares meshes so that the GPU fetches and transforms as few vertices as possible. It works on indices and on vertices
+   of any layout, so it can run offline before a mesh file is written or online before a mesh is set:
+   - OptimizeVertexCache reorders the triangles so that their vertices are still in the post transform cache
+   - OptimizeVertexFetch then reorders the vertices in the order the triangles first use them, so that fetching them
+     reads the vertex buffer mostly front to back
+   The attributes are quantized by the renderer, which knows the formats of its vertex inputs, with the helpers below */
+
+//How well an index order uses a post transform cache with first in first out replacement
+struct VertexCacheStatistics
+{
+	//Average cache miss ratio, the vertices transformed per triangle. 3 is the worst, about 0.5 the best for a grid
+	double acmr;
+	//Average transform to vertex ratio, the times each vertex is transformed. 1 is the best
+	double atvr;
+	uint32_t misses;
+};
+
+//Simulates a cache of the size passed, the indices need to form triangles of vertices below the vertex count
+VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+
+/* Reorders the triangles with Tom Forsyth's linear speed vertex cache optimization, which greedily picks the next triangle
+   from the ones whose vertices are in a simulated cache. The triangles themselves keep their winding */
+void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+/* Reorders the vertices, which are vertexStride bytes apart, in the order the indices first reference them and remaps the
+   indices to match. Vertices that no index references are dropped, returns the amount of vertices that is left */
+uint32_t OptimizeVertexFetch(void* vertices, uint32_t vertexStride, uint32_t vertexCount, std::vector<uint32_t>& indices);
+
+//Runs both optimizations in order, the vertex vector shrinks if some vertices weren't referenced
+template<typename VertexType>
+void OptimizeMesh(std::vector<VertexType>& vertices, std::vector<uint32_t>& indices)
+{
+	OptimizeVertexCache(indices, static_cast<uint32_t>(vertices.size()));
+	vertices.resize(OptimizeVertexFetch(vertices.data(), sizeof(VertexType), static_cast<uint32_t>(vertices.size()), 
+		indices));
+}
+
+//Converts to an IEEE half float, rounding to the nearest even value. Values beyond the range of a half become infinite
+uint16_t FloatToHalf(float value);
+
+float HalfToFloat(uint16_t half);
+
+//Maps 0 to 1 onto 0 to 255, values outside of the range are clamped
+uint8_t FloatToUnorm8(float value);
\ No newline at end of file
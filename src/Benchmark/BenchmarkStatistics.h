@@ -0,0 +1,27 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+//The percentiles of a set of times measured by a benchmark, in milliseconds
+struct FrameTimePercentiles
+{
+	double p50;
+	double p95;
+	double p99;
+};
+
+//Computes the percentiles over a sorted copy of the times, they are all 0 if there are no times
+inline FrameTimePercentiles ComputePercentiles(std::vector<double> frameTimes)
+{
+	FrameTimePercentiles percentiles{};
+	if (frameTimes.empty())
+	{
+		return percentiles;
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	percentiles.p50 = frameTimes[(frameTimes.size() - 1) * 50 / 100];
+	percentiles.p95 = frameTimes[(frameTimes.size() - 1) * 95 / 100];
+	percentiles.p99 = frameTimes[(frameTimes.size() - 1) * 99 / 100];
+	return percentiles;
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include "BenchmarkStatistics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* Drives VulkanGraphics for a fixed amount of frames (or seconds) under a configurable scenario and writes the results
+   as json, so that performance regressions can be caught automatically. Runs headless by default, which works on
+   machines without a GPU or a display (lavapipe).
+   With --static the draws are recorded once into static command buffers instead of every frame. --low-latency, 
+   --image-count and --fps-cap configure the frame pacing, which only changes anything when running --windowed.
+   --msaa renders with the samples per pixel passed, the results report the amount the graphics card settled on.
+   Usage: FrameBenchmark [--frames N] [--seconds S] [--warmup N] [--instances N] [--frames-in-flight N]
+                         [--present-mode fifo|mailbox|immediate] [--image-count N] [--fps-cap F] [--low-latency]
+                         [--windowed] [--static] [--msaa 1|2|4|8] [--width W] [--height H] [--output file] */
+
+struct BenchmarkScenario
+{
+	uint32_t frameCount = 1000;
+	double seconds = 0.0;
+	uint32_t warmupFrames = 60;
+	uint32_t instanceCount = 1;
+	uint32_t framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+	VkPresentModeKHR vk_presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+	const char* presentModeName = "immediate";
+	uint32_t swapchainImageCount = 0;
+	double fpsCap = 0.0;
+	bool lowLatency = false;
+	bool windowed = false;
+	bool staticCommandBuffers = false;
+	uint32_t msaaSamples = 1;
+	uint32_t width = 720;
+	uint32_t height = 560;
+	const char* outputFilename = nullptr;
+};
+
+static bool ParseArguments(int argc, char** argv, BenchmarkScenario& scenario)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* argument = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(argument, "--windowed"))
+		{
+			scenario.windowed = true;
+			continue;
+		}
+		if (!strcmp(argument, "--static"))
+		{
+			scenario.staticCommandBuffers = true;
+			continue;
+		}
+		if (!strcmp(argument, "--low-latency"))
+		{
+			scenario.lowLatency = true;
+			continue;
+		}
+		if (!value)
+		{
+			fprintf(stderr, "Missing value for %s\n", argument);
+			return false;
+		}
+		++i;
+		if (!strcmp(argument, "--frames")) scenario.frameCount = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--seconds")) scenario.seconds = atof(value);
+		else if (!strcmp(argument, "--warmup")) scenario.warmupFrames = static_cast<uint32_t>(atoi(value));
+		//--triangles is the older name of --instances, from before the triangle was drawn with instancing
+		else if (!strcmp(argument, "--instances") || !strcmp(argument, "--triangles"))
+			scenario.instanceCount = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--frames-in-flight")) scenario.framesInFlight = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--width")) scenario.width = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--height")) scenario.height = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--output")) scenario.outputFilename = value;
+		else if (!strcmp(argument, "--image-count")) scenario.swapchainImageCount = static_cast<uint32_t>(atoi(value));
+		else if (!strcmp(argument, "--fps-cap")) scenario.fpsCap = atof(value);
+		else if (!strcmp(argument, "--msaa"))
+		{
+			//The sample counts are the powers of two up to 64
+			scenario.msaaSamples = static_cast<uint32_t>(atoi(value));
+			if (!scenario.msaaSamples || scenario.msaaSamples > 64 || (scenario.msaaSamples & (scenario.msaaSamples - 1)))
+			{
+				fprintf(stderr, "Invalid sample count %s\n", value);
+				return false;
+			}
+		}
+		else if (!strcmp(argument, "--present-mode"))
+		{
+			scenario.presentModeName = value;
+			if (!strcmp(value, "fifo")) scenario.vk_presentMode = VK_PRESENT_MODE_FIFO_KHR;
+			else if (!strcmp(value, "mailbox")) scenario.vk_presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+			else if (!strcmp(value, "immediate")) scenario.vk_presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+			else
+			{
+				fprintf(stderr, "Unknown present mode %s\n", value);
+				return false;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unknown argument %s\n", argument);
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchmarkScenario scenario;
+	if (!ParseArguments(argc, argv, scenario))
+	{
+		return 1;
+	}
+
+	WindowHandle window;
+	VulkanGraphics graphics;
+	graphics.SetFramesInFlight(scenario.framesInFlight);
+	graphics.SetFramePacing({ scenario.vk_presentMode, scenario.swapchainImageCount, scenario.fpsCap, scenario.lowLatency });
+	graphics.SetInstanceCount(scenario.instanceCount);
+	graphics.SetStaticCommandBuffers(scenario.staticCommandBuffers);
+	graphics.SetMsaaSamples(static_cast<VkSampleCountFlagBits>(scenario.msaaSamples));
+
+	std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now();
+	if (scenario.windowed)
+	{
+		window.Init();
+		graphics.Init(window);
+	}
+	else
+	{
+		graphics.InitHeadless(scenario.width, scenario.height);
+	}
+	double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+	//The first frames would otherwise only clear the render target while the pipelines are still compiling
+	graphics.WaitForPipelines();
+
+	//The first frames are not measured, they include driver warm up and filling the frame ring
+	for (uint32_t i = 0; i < scenario.warmupFrames; ++i)
+	{
+		if (scenario.windowed)
+		{
+			window.MainLoop();
+			graphics.SetWindowState(window.GetState());
+		}
+		graphics.WaitForNextFrame();
+		graphics.MainLoop();
+	}
+
+	std::vector<double> cpuFrameTimes;
+	std::vector<double> recordingTimes;
+	std::vector<double> gpuFrameTimes;
+	cpuFrameTimes.reserve(scenario.frameCount);
+	recordingTimes.reserve(scenario.frameCount);
+	gpuFrameTimes.reserve(scenario.frameCount);
+
+	/* The GPU time of a frame is read back the readback latency amount of frames after it, so the time that arrives after
+	   the call to MainLoop with the number passed belongs to that many frames before. Only the times of the measured 
+	   frames are kept, so that the GPU times cover the same frames as the CPU times */
+	const VulkanGpuProfiler& profiler = graphics.GetGpuProfiler();
+	uint32_t readbackLatency = profiler.GetReadbackLatency();
+	uint64_t gpuReadbackCount = 0;
+	double gpuFrameMs = 0.0;
+	profiler.GetLastScopeSample("Frame", gpuFrameMs, gpuReadbackCount);
+	auto collectGpuFrameTime = [&](size_t frameNumber)
+		{
+			uint64_t readbackCount = 0;
+			if (profiler.GetLastScopeSample("Frame", gpuFrameMs, readbackCount) && readbackCount != gpuReadbackCount)
+			{
+				gpuReadbackCount = readbackCount;
+				if (frameNumber >= readbackLatency && frameNumber - readbackLatency < cpuFrameTimes.size())
+				{
+					gpuFrameTimes.push_back(gpuFrameMs);
+				}
+			}
+		};
+	std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+	double elapsedSeconds = 0.0;
+	while (scenario.seconds > 0.0 ? elapsedSeconds < scenario.seconds : cpuFrameTimes.size() < scenario.frameCount)
+	{
+		//The pacing wait is left out of the frame time, like it would be spent idle in the application
+		graphics.WaitForNextFrame();
+		if (scenario.windowed)
+		{
+			window.MainLoop();
+			if (window.ShouldClose())
+			{
+				break;
+			}
+			graphics.SetWindowState(window.GetState());
+		}
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		graphics.MainLoop();
+		std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+		cpuFrameTimes.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+		recordingTimes.push_back(graphics.GetLastFrameRecordingMs());
+		collectGpuFrameTime(cpuFrameTimes.size() - 1);
+		elapsedSeconds = std::chrono::duration<double>(frameEnd - runStart).count();
+	}
+	//The GPU times of the last measured frames are only read back by the frames after them, which are not measured
+	for (size_t frameNumber = cpuFrameTimes.size(); frameNumber < cpuFrameTimes.size() + readbackLatency; ++frameNumber)
+	{
+		graphics.WaitForNextFrame();
+		graphics.MainLoop();
+		collectGpuFrameTime(frameNumber);
+	}
+	graphics.Cleanup();
+
+	//The GPU times come from the profiler's "Frame" scope, read back for each of the measured frames
+	double gpuAverage = 0.0;
+	for (double gpuFrameTime : gpuFrameTimes)
+	{
+		gpuAverage += gpuFrameTime / gpuFrameTimes.size();
+	}
+	FrameTimePercentiles gpuPercentiles = ComputePercentiles(gpuFrameTimes);
+	FrameTimePercentiles cpuPercentiles = ComputePercentiles(cpuFrameTimes);
+	FrameTimePercentiles recordingPercentiles = ComputePercentiles(recordingTimes);
+	double framesPerSecond = elapsedSeconds > 0.0 ? cpuFrameTimes.size() / elapsedSeconds : 0.0;
+
+	FILE* output = scenario.outputFilename ? fopen(scenario.outputFilename, "w") : stdout;
+	if (!output)
+	{
+		fprintf(stderr, "Could not open %s\n", scenario.outputFilename);
+		return 1;
+	}
+	fprintf(output, "{\n");
+	fprintf(output, "  \"scenario\": { \"mode\": \"%s\", \"instances\": %u, \"framesInFlight\": %u, \"presentMode\": \"%s\", "
+		"\"imageCount\": %u, \"fpsCap\": %.1f, \"lowLatency\": %s, \"static\": %s, \"msaa\": %u, \"width\": %u, "
+		"\"height\": %u },\n", 
+		scenario.windowed ? "windowed" : "headless", scenario.instanceCount, scenario.framesInFlight, scenario.presentModeName, 
+		scenario.swapchainImageCount, scenario.fpsCap, scenario.lowLatency ? "true" : "false", 
+		scenario.staticCommandBuffers ? "true" : "false", static_cast<uint32_t>(graphics.GetMsaaSamples()), scenario.width, 
+		scenario.height);
+	fprintf(output, "  \"startupMs\": %.3f,\n", startupMs);
+	fprintf(output, "  \"frames\": %zu,\n", cpuFrameTimes.size());
+	fprintf(output, "  \"seconds\": %.3f,\n", elapsedSeconds);
+	fprintf(output, "  \"framesPerSecond\": %.2f,\n", framesPerSecond);
+	fprintf(output, "  \"cpuFrameMs\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f },\n", cpuPercentiles.p50, 
+		cpuPercentiles.p95, cpuPercentiles.p99);
+	fprintf(output, "  \"recordingMs\": { \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f },\n", recordingPercentiles.p50, 
+		recordingPercentiles.p95, recordingPercentiles.p99);
+	fprintf(output, "  \"gpuFrameMs\": { \"frames\": %zu, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f }\n", 
+		gpuFrameTimes.size(), gpuAverage, gpuPercentiles.p50, gpuPercentiles.p95, gpuPercentiles.p99);
+	fprintf(output, "}\n");
+	if (output != stdout)
+	{
+		fclose(output);
+	}
+
+	if (scenario.windowed)
+	{
+		window.Cleanup();
+	}
+	return 0;
+}
\ No newline at end of file
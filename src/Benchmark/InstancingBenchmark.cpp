@@ -0,0 +1,140 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include "BenchmarkStatistics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* Measures the instanced draw path with an increasing amount of instances (1K, 100K and 1M by default), each with its own
+   headless graphics so the runs do not affect each other. With --animate every instance is rotated on every frame, which
+   also measures writing the instances into the persistently mapped instance buffers.
+   Usage: InstancingBenchmark [--frames N] [--warmup N] [--counts 1000,100000,1000000] [--animate] [--output file] */
+
+struct InstancingResult
+{
+	uint32_t instanceCount;
+	double framesPerSecond;
+	double cpuFrameP50Ms;
+	double cpuFrameP95Ms;
+	double gpuFrameAvgMs;
+	double gpuFrameP50Ms;
+};
+
+static InstancingResult RunInstanceCount(uint32_t instanceCount, uint32_t frameCount, uint32_t warmupFrames, bool animate)
+{
+	VulkanGraphics graphics;
+	graphics.SetInstanceCount(instanceCount);
+	graphics.InitHeadless(720, 560);
+	graphics.WaitForPipelines();
+
+	std::vector<double> cpuFrameTimes;
+	cpuFrameTimes.reserve(frameCount);
+	std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < warmupFrames + frameCount; ++i)
+	{
+		if (i == warmupFrames)
+		{
+			runStart = std::chrono::steady_clock::now();
+		}
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		if (animate)
+		{
+			InstanceData* instances = graphics.EditInstances();
+			for (uint32_t j = 0; j < instanceCount; ++j)
+			{
+				instances[j].rotation += 0.01f;
+			}
+		}
+		graphics.MainLoop();
+		if (i >= warmupFrames)
+		{
+			cpuFrameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - 
+				frameStart).count());
+		}
+	}
+	double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+	graphics.Cleanup();
+
+	InstancingResult result{};
+	result.instanceCount = instanceCount;
+	result.framesPerSecond = elapsedSeconds > 0.0 ? frameCount / elapsedSeconds : 0.0;
+	FrameTimePercentiles cpuPercentiles = ComputePercentiles(cpuFrameTimes);
+	result.cpuFrameP95Ms = cpuPercentiles.p95;
+	result.cpuFrameP50Ms = cpuPercentiles.p50;
+	std::vector<GpuScopeStatistics> scopeStatistics;
+	graphics.GetGpuProfiler().GetScopeStatistics(scopeStatistics);
+	for (const GpuScopeStatistics& statistics : scopeStatistics)
+	{
+		if (statistics.name == "Frame")
+		{
+			result.gpuFrameAvgMs = statistics.avgMs;
+			result.gpuFrameP50Ms = statistics.p50Ms;
+		}
+	}
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frameCount = 300;
+	uint32_t warmupFrames = 30;
+	bool animate = false;
+	const char* outputFilename = nullptr;
+	std::vector<uint32_t> instanceCounts = { 1000, 100000, 1000000 };
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(argv[i], "--animate")) animate = true;
+		else if (!strcmp(argv[i], "--frames") && value) frameCount = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--warmup") && value) warmupFrames = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--output") && value) outputFilename = argv[++i];
+		else if (!strcmp(argv[i], "--counts") && value)
+		{
+			//The counts are separated by commas, strtoul stops at each comma and the loop moves past it
+			instanceCounts.clear();
+			char* count = argv[++i];
+			while (*count)
+			{
+				char* countEnd;
+				instanceCounts.push_back(static_cast<uint32_t>(strtoul(count, &countEnd, 10)));
+				if (countEnd == count)
+				{
+					break;
+				}
+				count = *countEnd == ',' ? countEnd + 1 : countEnd;
+			}
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	FILE* output = outputFilename ? fopen(outputFilename, "w") : stdout;
+	if (!output)
+	{
+		fprintf(stderr, "Could not open %s\n", outputFilename);
+		return 1;
+	}
+	fprintf(output, "{\n");
+	fprintf(output, "  \"frames\": %u,\n", frameCount);
+	fprintf(output, "  \"animate\": %s,\n", animate ? "true" : "false");
+	fprintf(output, "  \"results\": [\n");
+	for (size_t i = 0; i < instanceCounts.size(); ++i)
+	{
+		InstancingResult result = RunInstanceCount(instanceCounts[i], frameCount, warmupFrames, animate);
+		fprintf(output, "    { \"instances\": %u, \"framesPerSecond\": %.2f, \"instancesPerSecond\": %.0f, "
+			"\"cpuFrameMs\": { \"p50\": %.4f, \"p95\": %.4f }, \"gpuFrameMs\": { \"avg\": %.4f, \"p50\": %.4f } }%s\n",
+			result.instanceCount, result.framesPerSecond, result.framesPerSecond * result.instanceCount, 
+			result.cpuFrameP50Ms, result.cpuFrameP95Ms, result.gpuFrameAvgMs, result.gpuFrameP50Ms,
+			i + 1 < instanceCounts.size() ? "," : "");
+	}
+	fprintf(output, "  ]\n");
+	fprintf(output, "}\n");
+	if (output != stdout)
+	{
+		fclose(output);
+	}
+	return 0;
+}
\ No newline at end of file
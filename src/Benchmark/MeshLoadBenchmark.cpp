@@ -0,0 +1,203 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* Measures loading a large mesh file by mapping it (LoadMesh), against reading and parsing it with an ifstream into
+   vectors that are then handed to SetMesh. The file is a grid mesh that is written before the runs, unless an existing
+   file is passed. Each load is timed until the call returns (load) and until the upload of the mesh has been submitted
+   (uploaded), the frames in between stream the mesh through the staging ring. The intermediate bytes are the CPU copies
+   of the mesh that the method allocates itself, on top of the staging ring and of what the upload queue copies. Runs 
+   headless, the methods take turns on one device.
+   Usage: MeshLoadBenchmark [--grid N] [--runs N] [--file path] [--method mapped|ifstream|both] */
+
+struct MeshLoadResult
+{
+	double loadMs;
+	double uploadedMs;
+	uint32_t frames;
+	uint64_t intermediateBytes;
+};
+
+//A grid of side by side vertices over the whole view, two triangles per cell
+static void WriteGridMeshFile(const char* filename, uint32_t side)
+{
+	std::vector<Vertex> vertices(static_cast<size_t>(side) * side);
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			float u = static_cast<float>(x) / (side - 1);
+			float v = static_cast<float>(y) / (side - 1);
+			vertices[static_cast<size_t>(y) * side + x] = { { u * 2.0f - 1.0f, v * 2.0f - 1.0f }, { u, v, 1.0f - u } };
+		}
+	}
+	std::vector<uint32_t> indices;
+	indices.reserve(static_cast<size_t>(side - 1) * (side - 1) * 6);
+	for (uint32_t y = 0; y + 1 < side; ++y)
+	{
+		for (uint32_t x = 0; x + 1 < side; ++x)
+		{
+			uint32_t corner = y * side + x;
+			indices.insert(indices.end(), { corner, corner + 1, corner + side, corner + 1, corner + side + 1, corner + side });
+		}
+	}
+	if (!WriteMeshFile(filename, static_cast<uint32_t>(VertexFormat::Float), vertices.data(), sizeof(Vertex), 
+		static_cast<uint32_t>(vertices.size()), indices.data(), static_cast<uint32_t>(indices.size()), std::sqrt(2.0f)))
+	{
+		fprintf(stderr, "Could not write %s\n", filename);
+		exit(1);
+	}
+}
+
+//Renders frames until the upload of the mesh has been submitted, returns the amount of frames it took
+static uint32_t WaitForMeshUpload(VulkanGraphics& graphics)
+{
+	uint32_t frames = 0;
+	while (!graphics.IsMeshUploaded())
+	{
+		graphics.MainLoop();
+		++frames;
+	}
+	return frames;
+}
+
+static MeshLoadResult LoadMapped(VulkanGraphics& graphics, const char* filename)
+{
+	MeshLoadResult result{};
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+	if (!graphics.LoadMesh(filename))
+	{
+		fprintf(stderr, "Could not load %s\n", filename);
+		exit(1);
+	}
+	result.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	result.frames = WaitForMeshUpload(graphics);
+	result.uploadedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	return result;
+}
+
+//Reads the sections into vectors the way a loader without mapping would, with the same checks as the mapped path
+static MeshLoadResult LoadIfstream(VulkanGraphics& graphics, const char* filename)
+{
+	MeshLoadResult result{};
+	std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+	std::ifstream meshFile(filename, std::ios::ate | std::ios::binary);
+	MeshFileHeader header{};
+	uint64_t fileSize = meshFile.is_open() ? static_cast<uint64_t>(meshFile.tellg()) : 0;
+	meshFile.seekg(0);
+	meshFile.read(reinterpret_cast<char*>(&header), sizeof(MeshFileHeader));
+	if (!meshFile || !MeshFile::ValidateHeader(header, fileSize) || 
+		header.vertexFormat != static_cast<uint32_t>(VertexFormat::Float) || header.vertexStride != sizeof(Vertex))
+	{
+		fprintf(stderr, "Could not read %s\n", filename);
+		exit(1);
+	}
+	std::vector<Vertex> vertices(header.vertexCount);
+	std::vector<uint32_t> indices(header.indexCount);
+	meshFile.seekg(header.vertices.offset);
+	meshFile.read(reinterpret_cast<char*>(vertices.data()), header.vertices.size);
+	meshFile.seekg(header.indices.offset);
+	meshFile.read(reinterpret_cast<char*>(indices.data()), header.indices.size);
+	if (!meshFile || ComputeMeshFileChecksum(vertices.data(), header.vertices.size) != header.vertices.checksum ||
+		ComputeMeshFileChecksum(indices.data(), header.indices.size) != header.indices.checksum)
+	{
+		fprintf(stderr, "The sections of %s are corrupted\n", filename);
+		exit(1);
+	}
+	graphics.SetMesh(vertices, indices);
+	result.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	result.intermediateBytes = header.vertices.size + header.indices.size;
+	//SetMesh keeps its own copy of what does not fit in the staging ring, so a caller can free the vectors once it returns
+	vertices = std::vector<Vertex>();
+	indices = std::vector<uint32_t>();
+	result.frames = WaitForMeshUpload(graphics);
+	result.uploadedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+	return result;
+}
+
+static void AddRun(MeshLoadResult& average, const MeshLoadResult& run, uint32_t runs)
+{
+	average.loadMs += run.loadMs / runs;
+	average.uploadedMs += run.uploadedMs / runs;
+	average.frames = std::max(average.frames, run.frames);
+	average.intermediateBytes = std::max(average.intermediateBytes, run.intermediateBytes);
+}
+
+static void PrintResult(const char* name, const MeshLoadResult& result, bool last)
+{
+	printf("    \"%s\": { \"loadMs\": %.3f, \"uploadedMs\": %.3f, \"maxFrames\": %u, \"intermediateMB\": %.2f }%s\n", name,
+		result.loadMs, result.uploadedMs, result.frames, result.intermediateBytes / (1024.0 * 1024.0), last ? "" : ",");
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t gridSide = 2048;
+	uint32_t runs = 5;
+	const char* filename = nullptr;
+	bool runMapped = true;
+	bool runIfstream = true;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(argv[i], "--grid") && value) gridSide = std::max(2u, static_cast<uint32_t>(atoi(argv[++i])));
+		else if (!strcmp(argv[i], "--runs") && value) runs = std::max(1u, static_cast<uint32_t>(atoi(argv[++i])));
+		else if (!strcmp(argv[i], "--file") && value) filename = argv[++i];
+		else if (!strcmp(argv[i], "--method") && value)
+		{
+			//Running a single method lets an outside tool measure the peak memory of that method alone
+			const char* method = argv[++i];
+			runMapped = !strcmp(method, "mapped") || !strcmp(method, "both");
+			runIfstream = !strcmp(method, "ifstream") || !strcmp(method, "both");
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+	const char* generatedFilename = "mesh_benchmark.vmsh";
+	if (!filename)
+	{
+		filename = generatedFilename;
+		WriteGridMeshFile(filename, gridSide);
+	}
+
+	//Both methods load the vertices as they are in the file, without quantizing them on the way
+	VulkanGraphics graphics;
+	graphics.SetVertexFormat(VertexFormat::Float);
+	graphics.InitHeadless(720, 560);
+	graphics.WaitForPipelines();
+	MeshLoadResult mappedResult{};
+	MeshLoadResult ifstreamResult{};
+	for (uint32_t i = 0; i < runs; ++i)
+	{
+		if (runMapped)
+		{
+			AddRun(mappedResult, LoadMapped(graphics, filename), runs);
+		}
+		if (runIfstream)
+		{
+			AddRun(ifstreamResult, LoadIfstream(graphics, filename), runs);
+		}
+	}
+	graphics.Cleanup();
+	if (filename == generatedFilename)
+	{
+		std::remove(generatedFilename);
+	}
+
+	printf("{\n  \"runs\": %u,\n  \"file\": \"%s\",\n  \"meshLoad\": {\n", runs, filename);
+	if (runMapped)
+	{
+		PrintResult("mapped", mappedResult, !runIfstream);
+	}
+	if (runIfstream)
+	{
+		PrintResult("ifstream", ifstreamResult, true);
+	}
+	printf("  }\n}\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+/* Measures what the mesh preprocessing gains on a grid mesh: the bytes per vertex of the float and quantized vertex 
+   formats, and the average cache miss ratio (ACMR) and transform to vertex ratio (ATVR) of the index order before and 
+   after the vertex cache and fetch optimizations, for FIFO caches of 16 and 32 vertices. The grid is measured in scan 
+   order, which is how generated meshes usually come, and with its triangles shuffled, which is close to the worst case. 
+   With --output the preprocessed and quantized grid is written to a mesh file, which is the offline path of LoadMesh.
+   Usage: MeshPreprocessBenchmark [--grid N] [--seed N] [--output file] */
+
+struct PreprocessResult
+{
+	VertexCacheStatistics before16;
+	VertexCacheStatistics before32;
+	VertexCacheStatistics after16;
+	VertexCacheStatistics after32;
+	double optimizeMs;
+};
+
+static void CreateGridMesh(uint32_t side, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	vertices.resize(static_cast<size_t>(side) * side);
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			float u = static_cast<float>(x) / (side - 1);
+			float v = static_cast<float>(y) / (side - 1);
+			vertices[static_cast<size_t>(y) * side + x] = { { u * 2.0f - 1.0f, v * 2.0f - 1.0f }, { u, v, 1.0f - u } };
+		}
+	}
+	indices.clear();
+	indices.reserve(static_cast<size_t>(side - 1) * (side - 1) * 6);
+	for (uint32_t y = 0; y + 1 < side; ++y)
+	{
+		for (uint32_t x = 0; x + 1 < side; ++x)
+		{
+			uint32_t corner = y * side + x;
+			indices.insert(indices.end(), { corner, corner + 1, corner + side, corner + 1, corner + side + 1, corner + side });
+		}
+	}
+}
+
+//Shuffles the order of the triangles, each one keeps its corners in order so its winding stays the same
+static void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed)
+{
+	std::vector<uint32_t> triangles(indices.size() / 3);
+	for (uint32_t i = 0; i < triangles.size(); ++i)
+	{
+		triangles[i] = i;
+	}
+	std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+	std::vector<uint32_t> shuffledIndices(indices.size());
+	for (size_t i = 0; i < triangles.size(); ++i)
+	{
+		std::copy_n(&indices[triangles[i] * 3], 3, &shuffledIndices[i * 3]);
+	}
+	indices.swap(shuffledIndices);
+}
+
+static PreprocessResult Preprocess(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	PreprocessResult result{};
+	uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+	result.before16 = AnalyzeVertexCache(indices, vertexCount, 16);
+	result.before32 = AnalyzeVertexCache(indices, vertexCount, 32);
+	std::chrono::steady_clock::time_point optimizeStart = std::chrono::steady_clock::now();
+	OptimizeMesh(vertices, indices);
+	result.optimizeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - 
+		optimizeStart).count();
+	vertexCount = static_cast<uint32_t>(vertices.size());
+	result.after16 = AnalyzeVertexCache(indices, vertexCount, 16);
+	result.after32 = AnalyzeVertexCache(indices, vertexCount, 32);
+	return result;
+}
+
+static void PrintCacheStatistics(const char* name, const VertexCacheStatistics& cache16, 
+	const VertexCacheStatistics& cache32, bool last)
+{
+	printf("      \"%s\": { \"acmr16\": %.4f, \"atvr16\": %.4f, \"acmr32\": %.4f, \"atvr32\": %.4f }%s\n", name, 
+		cache16.acmr, cache16.atvr, cache32.acmr, cache32.atvr, last ? "" : ",");
+}
+
+static void PrintResult(const char* name, const PreprocessResult& result, bool last)
+{
+	printf("    \"%s\": {\n", name);
+	PrintCacheStatistics("before", result.before16, result.before32, false);
+	PrintCacheStatistics("after", result.after16, result.after32, false);
+	printf("      \"optimizeMs\": %.3f\n    }%s\n", result.optimizeMs, last ? "" : ",");
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t gridSide = 512;
+	uint32_t seed = 1;
+	const char* outputFilename = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(argv[i], "--grid") && value) gridSide = std::max(2u, static_cast<uint32_t>(atoi(argv[++i])));
+		else if (!strcmp(argv[i], "--seed") && value) seed = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--output") && value) outputFilename = argv[++i];
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateGridMesh(gridSide, vertices, indices);
+	PreprocessResult scanOrder = Preprocess(vertices, indices);
+	CreateGridMesh(gridSide, vertices, indices);
+	ShuffleTriangles(indices, seed);
+	PreprocessResult shuffled = Preprocess(vertices, indices);
+
+	//The largest distance between a position and the position that the vertex shader reads after quantizing it
+	std::vector<QuantizedVertex> quantizedVertices;
+	QuantizeVertices(vertices, quantizedVertices);
+	float maxPositionError = 0.0f;
+	float boundingRadius = 0.0f;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		float x = HalfToFloat(quantizedVertices[i].position[0].bits);
+		float y = HalfToFloat(quantizedVertices[i].position[1].bits);
+		maxPositionError = std::max({ maxPositionError, std::fabs(x - vertices[i].position[0]), 
+			std::fabs(y - vertices[i].position[1]) });
+		boundingRadius = std::max(boundingRadius, std::sqrt(x * x + y * y));
+	}
+	if (outputFilename && !WriteMeshFile(outputFilename, static_cast<uint32_t>(VertexFormat::Quantized), 
+		quantizedVertices.data(), sizeof(QuantizedVertex), static_cast<uint32_t>(quantizedVertices.size()), indices.data(),
+		static_cast<uint32_t>(indices.size()), boundingRadius))
+	{
+		fprintf(stderr, "Could not write %s\n", outputFilename);
+		return 1;
+	}
+
+	printf("{\n  \"vertices\": %zu,\n  \"triangles\": %zu,\n", vertices.size(), indices.size() / 3);
+	printf("  \"bytesPerVertex\": { \"float\": %u, \"quantized\": %u },\n", GetVertexLayout(VertexFormat::Float).stride,
+		GetVertexLayout(VertexFormat::Quantized).stride);
+	printf("  \"maxPositionError\": %g,\n", maxPositionError);
+	printf("  \"vertexCache\": {\n");
+	PrintResult("scanOrder", scanOrder, false);
+	PrintResult("shuffled", shuffled, true);
+	printf("  }\n}\n");
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include "BenchmarkStatistics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* Measures how recording the render pass scales with the amount of worker threads. The instances are drawn with a draw 
+   each (or with the amount of instances per draw passed), which makes the CPU cost of recording the bottleneck. The run 
+   with 0 threads records the same draws on the main thread, the rest go from 1 thread up to the hardware threads in 
+   powers of two. The speedup is relative to recording with a single worker thread.
+   Usage: RecordingBenchmark [--frames N] [--warmup N] [--instances N] [--instances-per-draw N] [--max-threads N] 
+   [--output file] */
+
+struct RecordingResult
+{
+	uint32_t threadCount;
+	double recordingP50Ms;
+	double recordingP95Ms;
+	double cpuFrameP50Ms;
+	double gpuFrameAvgMs;
+};
+
+static RecordingResult RunThreadCount(uint32_t threadCount, uint32_t instanceCount, uint32_t instancesPerDraw, 
+	uint32_t frameCount, uint32_t warmupFrames)
+{
+	VulkanGraphics graphics;
+	graphics.SetInstanceCount(instanceCount);
+	graphics.SetParallelRecording(threadCount, instancesPerDraw);
+	//The split draws bypass the culling anyway, so its pipeline doesn't need to be compiled either
+	graphics.SetGpuCulling(false);
+	graphics.InitHeadless(720, 560);
+	graphics.WaitForPipelines();
+
+	std::vector<double> recordingTimes;
+	std::vector<double> cpuFrameTimes;
+	recordingTimes.reserve(frameCount);
+	cpuFrameTimes.reserve(frameCount);
+	for (uint32_t i = 0; i < warmupFrames + frameCount; ++i)
+	{
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+		graphics.MainLoop();
+		if (i >= warmupFrames)
+		{
+			cpuFrameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - 
+				frameStart).count());
+			recordingTimes.push_back(graphics.GetLastFrameRecordingMs());
+		}
+	}
+	graphics.Cleanup();
+
+	RecordingResult result{};
+	result.threadCount = threadCount;
+	FrameTimePercentiles recordingPercentiles = ComputePercentiles(recordingTimes);
+	result.recordingP95Ms = recordingPercentiles.p95;
+	result.recordingP50Ms = recordingPercentiles.p50;
+	result.cpuFrameP50Ms = ComputePercentiles(cpuFrameTimes).p50;
+	std::vector<GpuScopeStatistics> scopeStatistics;
+	graphics.GetGpuProfiler().GetScopeStatistics(scopeStatistics);
+	for (const GpuScopeStatistics& statistics : scopeStatistics)
+	{
+		if (statistics.name == "Frame")
+		{
+			result.gpuFrameAvgMs = statistics.avgMs;
+		}
+	}
+	return result;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t frameCount = 200;
+	uint32_t warmupFrames = 20;
+	uint32_t instanceCount = 100000;
+	uint32_t instancesPerDraw = 1;
+	uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const char* outputFilename = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (!strcmp(argv[i], "--frames") && value) frameCount = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--warmup") && value) warmupFrames = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--instances") && value) instanceCount = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--instances-per-draw") && value) instancesPerDraw = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--max-threads") && value) maxThreads = static_cast<uint32_t>(atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--output") && value) outputFilename = argv[++i];
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::vector<uint32_t> threadCounts = { 0 };
+	for (uint32_t threadCount = 1; threadCount < maxThreads; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	if (maxThreads)
+	{
+		threadCounts.push_back(maxThreads);
+	}
+
+	FILE* output = outputFilename ? fopen(outputFilename, "w") : stdout;
+	if (!output)
+	{
+		fprintf(stderr, "Could not open %s\n", outputFilename);
+		return 1;
+	}
+	fprintf(output, "{\n");
+	fprintf(output, "  \"frames\": %u,\n", frameCount);
+	fprintf(output, "  \"instances\": %u,\n", instanceCount);
+	fprintf(output, "  \"instancesPerDraw\": %u,\n", instancesPerDraw);
+	fprintf(output, "  \"results\": [\n");
+	std::vector<RecordingResult> results;
+	double singleWorkerRecordingMs = 0.0;
+	for (uint32_t threadCount : threadCounts)
+	{
+		results.push_back(RunThreadCount(threadCount, instanceCount, instancesPerDraw, frameCount, warmupFrames));
+		if (threadCount == 1)
+		{
+			singleWorkerRecordingMs = results.back().recordingP50Ms;
+		}
+	}
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const RecordingResult& result = results[i];
+		double speedup = singleWorkerRecordingMs > 0.0 && result.recordingP50Ms > 0.0 ? 
+			singleWorkerRecordingMs / result.recordingP50Ms : 1.0;
+		fprintf(output, "    { \"threads\": %u, \"recordingMs\": { \"p50\": %.4f, \"p95\": %.4f }, \"cpuFrameP50Ms\": %.4f, "
+			"\"gpuFrameAvgMs\": %.4f, \"speedup\": %.2f }%s\n", result.threadCount, result.recordingP50Ms, 
+			result.recordingP95Ms, result.cpuFrameP50Ms, result.gpuFrameAvgMs, speedup, 
+			i + 1 < results.size() ? "," : "");
+	}
+	fprintf(output, "  ]\n");
+	fprintf(output, "}\n");
+	if (output != stdout)
+	{
+		fclose(output);
+	}
+	return 0;
+}
\ No newline at end of file
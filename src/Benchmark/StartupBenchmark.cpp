@@ -0,0 +1,71 @@
+#include "Graphics/Vulkan/VulkanGraphics.h"
+#include <cstdio>
+#include <cstdlib>
+
+/* Measures how long the graphics take to initialize with an empty pipeline cache (cold) and with the cache that the cold
+   run wrote to disk (warm). The pipelines compile on worker threads during Init, so the times at which their shaders were 
+   loaded and they became ready are reported next to the phases of Init. Runs headless so that it works on machines 
+   without a display.
+   Usage: StartupBenchmark [runs] */
+
+//Initializes the graphics once and returns the timings of the startup phases
+static VulkanStartupTimings RunStartup(const char* cacheFilename, bool& loadedFromDisk)
+{
+	VulkanGraphics graphics;
+	graphics.SetPipelineCacheFilename(cacheFilename);
+	graphics.InitHeadless(720, 560);
+	graphics.WaitForPipelines();
+	VulkanStartupTimings timings = graphics.GetStartupTimings();
+	loadedFromDisk = graphics.WasPipelineCacheLoadedFromDisk();
+	graphics.Cleanup();
+	return timings;
+}
+
+static void PrintTimings(const char* name, const VulkanStartupTimings& timings, bool loadedFromDisk, bool last)
+{
+	printf("    \"%s\": { \"cacheLoaded\": %s, \"deviceMs\": %.3f, \"renderTargetsMs\": %.3f, \"pipelineMs\": %.3f, "
+		"\"totalMs\": %.3f, \"shadersLoadedMs\": %.3f, \"graphicsPipelineReadyMs\": %.3f, "
+		"\"cullingPipelineReadyMs\": %.3f }%s\n", name, loadedFromDisk ? "true" : "false", timings.deviceCreation, 
+		timings.renderTargetCreation, timings.pipelineCreation, timings.total, timings.shadersLoaded, 
+		timings.graphicsPipelineReady, timings.cullingPipelineReady, last ? "" : ",");
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t runs = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 5;
+	const char* cacheFilename = "startup_benchmark_cache.bin";
+
+	VulkanStartupTimings cold{};
+	VulkanStartupTimings warm{};
+	bool coldLoaded = false;
+	bool warmLoaded = false;
+	for (uint32_t i = 0; i < runs; ++i)
+	{
+		//Removing the cache before every cold run, the warm run then reads what the cold run just wrote
+		std::remove(cacheFilename);
+		VulkanStartupTimings coldRun = RunStartup(cacheFilename, coldLoaded);
+		VulkanStartupTimings warmRun = RunStartup(cacheFilename, warmLoaded);
+
+		cold.deviceCreation += coldRun.deviceCreation / runs;
+		cold.renderTargetCreation += coldRun.renderTargetCreation / runs;
+		cold.pipelineCreation += coldRun.pipelineCreation / runs;
+		cold.total += coldRun.total / runs;
+		cold.shadersLoaded += coldRun.shadersLoaded / runs;
+		cold.graphicsPipelineReady += coldRun.graphicsPipelineReady / runs;
+		cold.cullingPipelineReady += coldRun.cullingPipelineReady / runs;
+		warm.deviceCreation += warmRun.deviceCreation / runs;
+		warm.renderTargetCreation += warmRun.renderTargetCreation / runs;
+		warm.pipelineCreation += warmRun.pipelineCreation / runs;
+		warm.total += warmRun.total / runs;
+		warm.shadersLoaded += warmRun.shadersLoaded / runs;
+		warm.graphicsPipelineReady += warmRun.graphicsPipelineReady / runs;
+		warm.cullingPipelineReady += warmRun.cullingPipelineReady / runs;
+	}
+	std::remove(cacheFilename);
+
+	printf("{\n  \"runs\": %u,\n  \"startup\": {\n", runs);
+	PrintTimings("cold", cold, coldLoaded, false);
+	PrintTimings("warm", warm, warmLoaded, true);
+	printf("  }\n}\n");
+	return 0;
+}
\ No newline at end of file
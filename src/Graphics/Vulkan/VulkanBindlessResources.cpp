@@ -0,0 +1,222 @@
+#include "VulkanGraphics.h"
+#include <algorithm>
+
+VulkanBindlessResources::VulkanBindlessResources()
+	:vk_device(VK_NULL_HANDLE), m_descriptorIndexing(false), vk_descriptorSetLayout(VK_NULL_HANDLE), 
+	vk_descriptorPool(VK_NULL_HANDLE), vk_descriptorSet(VK_NULL_HANDLE), vk_defaultBuffer(VK_NULL_HANDLE), m_buffers(), 
+	m_textures(), m_currentFrame(0)
+{
+
+}
+
+VulkanBindlessResources::~VulkanBindlessResources()
+{
+
+}
+
+void VulkanBindlessResources::Init(const VkDevice& device, const VkInstance& vk_instance, 
+	const VkPhysicalDevice& vk_graphicsCard, bool descriptorIndexing, uint32_t framesInFlight, const VkBuffer& defaultBuffer)
+{
+	vk_device = device;
+	m_descriptorIndexing = descriptorIndexing;
+	vk_defaultBuffer = defaultBuffer;
+
+	/* The arrays are as large as the graphics card lets a stage access. Descriptors that can be updated after bind have
+	   their own limits, which are usually much higher, and can only be queried through the second version of the queries */
+	VkPhysicalDeviceProperties vk_gpuProperties;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &vk_gpuProperties);
+	const VkPhysicalDeviceLimits& vk_limits = vk_gpuProperties.limits;
+	uint32_t bufferLimit = std::min(vk_limits.maxPerStageDescriptorStorageBuffers, vk_limits.maxDescriptorSetStorageBuffers);
+	uint32_t textureLimit = std::min({ vk_limits.maxPerStageDescriptorSamplers, vk_limits.maxPerStageDescriptorSampledImages,
+		vk_limits.maxDescriptorSetSamplers, vk_limits.maxDescriptorSetSampledImages });
+	if (m_descriptorIndexing)
+	{
+		PFN_vkGetPhysicalDeviceProperties2KHR vk_getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+			vkGetInstanceProcAddr(vk_instance, "vkGetPhysicalDeviceProperties2KHR"));
+		VkPhysicalDeviceDescriptorIndexingPropertiesEXT vk_indexingProperties{};
+		vk_indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2KHR vk_properties2{};
+		vk_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		vk_properties2.pNext = &vk_indexingProperties;
+		vk_getProperties2(vk_graphicsCard, &vk_properties2);
+		bufferLimit = std::min(vk_indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers, 
+			vk_indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers);
+		textureLimit = std::min({ vk_indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers, 
+			vk_indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			vk_indexingProperties.maxDescriptorSetUpdateAfterBindSamplers, 
+			vk_indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages });
+	}
+	m_buffers.capacity = std::min(MAX_BINDLESS_BUFFERS, bufferLimit);
+	m_textures.capacity = std::min(MAX_BINDLESS_TEXTURES, textureLimit);
+	m_buffers.releasedHandles.resize(framesInFlight);
+	m_textures.releasedHandles.resize(framesInFlight);
+
+	VkDescriptorSetLayoutBinding vk_bindings[2]{};
+	vk_bindings[0].binding = 0;
+	vk_bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vk_bindings[0].descriptorCount = m_buffers.capacity;
+	vk_bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	vk_bindings[1].binding = 1;
+	vk_bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	vk_bindings[1].descriptorCount = m_textures.capacity;
+	vk_bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorSetLayoutCreateInfo vk_setLayoutInfo{};
+	vk_setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	vk_setLayoutInfo.bindingCount = 2;
+	vk_setLayoutInfo.pBindings = vk_bindings;
+	/* Partially bound arrays only need the descriptors that the shaders actually read to be valid, and the unused ones can
+	   be written while the set is bound in command buffers that are still executing */
+	VkDescriptorBindingFlagsEXT vk_bindingFlags[2] = {};
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT vk_bindingFlagsInfo{};
+	if (m_descriptorIndexing)
+	{
+		vk_bindingFlags[0] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT;
+		vk_bindingFlags[1] = vk_bindingFlags[0];
+		vk_bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+		vk_bindingFlagsInfo.bindingCount = 2;
+		vk_bindingFlagsInfo.pBindingFlags = vk_bindingFlags;
+		vk_setLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+		vk_setLayoutInfo.pNext = &vk_bindingFlagsInfo;
+	}
+	if (vkCreateDescriptorSetLayout(vk_device, &vk_setLayoutInfo, nullptr, &vk_descriptorSetLayout) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	VkDescriptorPoolSize vk_poolSizes[2]{};
+	vk_poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vk_poolSizes[0].descriptorCount = m_buffers.capacity;
+	vk_poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	vk_poolSizes[1].descriptorCount = m_textures.capacity;
+	VkDescriptorPoolCreateInfo vk_poolInfo{};
+	vk_poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	vk_poolInfo.flags = m_descriptorIndexing ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT : 0;
+	vk_poolInfo.maxSets = 1;
+	vk_poolInfo.poolSizeCount = 2;
+	vk_poolInfo.pPoolSizes = vk_poolSizes;
+	if (vkCreateDescriptorPool(vk_device, &vk_poolInfo, nullptr, &vk_descriptorPool) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+	VkDescriptorSetAllocateInfo vk_setAllocateInfo{};
+	vk_setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	vk_setAllocateInfo.descriptorPool = vk_descriptorPool;
+	vk_setAllocateInfo.descriptorSetCount = 1;
+	vk_setAllocateInfo.pSetLayouts = &vk_descriptorSetLayout;
+	if (vkAllocateDescriptorSets(vk_device, &vk_setAllocateInfo, &vk_descriptorSet) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	/* Without partially bound arrays every descriptor of an array that the shaders use needs to be valid, so they all 
+	   start out pointing to the default buffer. The texture array is not read by the shaders yet, so it can stay empty */
+	uint32_t defaultBufferCount = m_descriptorIndexing ? 1 : m_buffers.capacity;
+	std::vector<VkDescriptorBufferInfo> vk_bufferInfos(defaultBufferCount, { vk_defaultBuffer, 0, VK_WHOLE_SIZE });
+	VkWriteDescriptorSet vk_descriptorWrite{};
+	vk_descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	vk_descriptorWrite.dstSet = vk_descriptorSet;
+	vk_descriptorWrite.dstBinding = 0;
+	vk_descriptorWrite.dstArrayElement = 0;
+	vk_descriptorWrite.descriptorCount = defaultBufferCount;
+	vk_descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vk_descriptorWrite.pBufferInfo = vk_bufferInfos.data();
+	vkUpdateDescriptorSets(vk_device, 1, &vk_descriptorWrite, 0, nullptr);
+	m_buffers.nextHandle = DEFAULT_BINDLESS_BUFFER + 1;
+}
+
+void VulkanBindlessResources::BeginFrame(uint32_t frameIndex)
+{
+	m_currentFrame = frameIndex;
+	for (HandleArray* handles : { &m_buffers, &m_textures })
+	{
+		std::vector<uint32_t>& releasedHandles = handles->releasedHandles[frameIndex];
+		handles->freeHandles.insert(handles->freeHandles.end(), releasedHandles.begin(), releasedHandles.end());
+		releasedHandles.clear();
+	}
+}
+
+uint32_t VulkanBindlessResources::AllocateHandle(HandleArray& handles)
+{
+	if (!handles.freeHandles.empty())
+	{
+		uint32_t handle = handles.freeHandles.back();
+		handles.freeHandles.pop_back();
+		return handle;
+	}
+	//Every element of the array is in use
+	if (handles.nextHandle == handles.capacity)
+	{
+		__debugbreak();
+	}
+	return handles.nextHandle++;
+}
+
+void VulkanBindlessResources::WriteBufferDescriptor(uint32_t handle, const VkBuffer& vk_buffer, VkDeviceSize offset, 
+	VkDeviceSize range)
+{
+	VkDescriptorBufferInfo vk_bufferInfo{ vk_buffer, offset, range };
+	VkWriteDescriptorSet vk_descriptorWrite{};
+	vk_descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	vk_descriptorWrite.dstSet = vk_descriptorSet;
+	vk_descriptorWrite.dstBinding = 0;
+	vk_descriptorWrite.dstArrayElement = handle;
+	vk_descriptorWrite.descriptorCount = 1;
+	vk_descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vk_descriptorWrite.pBufferInfo = &vk_bufferInfo;
+	vkUpdateDescriptorSets(vk_device, 1, &vk_descriptorWrite, 0, nullptr);
+}
+
+uint32_t VulkanBindlessResources::RegisterBuffer(const VkBuffer& vk_buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	uint32_t handle = AllocateHandle(m_buffers);
+	WriteBufferDescriptor(handle, vk_buffer, offset, range);
+	return handle;
+}
+
+uint32_t VulkanBindlessResources::RegisterTexture(const VkImageView& vk_imageView, const VkSampler& vk_sampler)
+{
+	uint32_t handle = AllocateHandle(m_textures);
+	VkDescriptorImageInfo vk_imageInfo{ vk_sampler, vk_imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkWriteDescriptorSet vk_descriptorWrite{};
+	vk_descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	vk_descriptorWrite.dstSet = vk_descriptorSet;
+	vk_descriptorWrite.dstBinding = 1;
+	vk_descriptorWrite.dstArrayElement = handle;
+	vk_descriptorWrite.descriptorCount = 1;
+	vk_descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	vk_descriptorWrite.pImageInfo = &vk_imageInfo;
+	vkUpdateDescriptorSets(vk_device, 1, &vk_descriptorWrite, 0, nullptr);
+	return handle;
+}
+
+void VulkanBindlessResources::ReleaseBuffer(uint32_t handle)
+{
+	if (handle == DEFAULT_BINDLESS_BUFFER)
+	{
+		return;
+	}
+	if (!m_descriptorIndexing)
+	{
+		WriteBufferDescriptor(handle, vk_defaultBuffer, 0, VK_WHOLE_SIZE);
+	}
+	m_buffers.releasedHandles[m_currentFrame].push_back(handle);
+}
+
+void VulkanBindlessResources::ReleaseTexture(uint32_t handle)
+{
+	m_textures.releasedHandles[m_currentFrame].push_back(handle);
+}
+
+void VulkanBindlessResources::Cleanup()
+{
+	if (vk_device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	//Destroying the pool frees the descriptor set that was allocated from it
+	vkDestroyDescriptorPool(vk_device, vk_descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vk_device, vk_descriptorSetLayout, nullptr);
+	m_buffers = HandleArray();
+	m_textures = HandleArray();
+}
\ No newline at end of file
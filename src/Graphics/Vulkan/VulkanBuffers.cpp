@@ -0,0 +1,36 @@
+#include "VulkanGraphics.h"
+
+void CreateVulkanBuffer(VulkanBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags vk_bufferUsage,
+	VkMemoryPropertyFlags vk_requiredProperties, VkMemoryPropertyFlags vk_preferredProperties,
+	VulkanAllocationStrategy strategy, const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator)
+{
+	VkBufferCreateInfo vk_bufferInfo{};
+	vk_bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	vk_bufferInfo.size = size;
+	vk_bufferInfo.usage = vk_bufferUsage;
+	//Buffers that are written on a different queue family are handed over with ownership transfers instead of being shared
+	vk_bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VkResult vk_bufferCreationResult = vkCreateBuffer(vk_device, &vk_bufferInfo, nullptr, &buffer.vk_buffer);
+	if (vk_bufferCreationResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	if (!memoryAllocator.AllocateForBuffer(buffer.vk_buffer, vk_requiredProperties, vk_preferredProperties, strategy,
+		buffer.allocation))
+	{
+		__debugbreak();
+	}
+	buffer.size = size;
+}
+
+void DestroyVulkanBuffer(VulkanBuffer& buffer, const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator)
+{
+	if (buffer.vk_buffer == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	vkDestroyBuffer(vk_device, buffer.vk_buffer, nullptr);
+	memoryAllocator.Free(buffer.allocation);
+	buffer = VulkanBuffer{};
+}
\ No newline at end of file
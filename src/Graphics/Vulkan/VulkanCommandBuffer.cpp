@@ -12,6 +12,15 @@ void AllocateVulkanCommandBuffer(VkCommandBuffer& vk_commandBuffer,const VkDevic
 	}
 }
 
+void AllocateVulkanCommandBuffers(VkCommandBuffer* vk_commandBuffers, const VkDevice& vk_device, 
+	const VkCommandBufferAllocateInfo& vk_commandBufferInfo)
+{
+	if (vkAllocateCommandBuffers(vk_device, &vk_commandBufferInfo, vk_commandBuffers) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+}
+
 void CreateVulkanCommandBufferBeginInfo(VkCommandBufferBeginInfo& vk_commandBufferBegin,
 	VkCommandBufferUsageFlags vk_commandBufferUsage, VkCommandBufferInheritanceInfo* vk_commandBufferInheritance)
 {
@@ -22,10 +31,18 @@ void CreateVulkanCommandBufferBeginInfo(VkCommandBufferBeginInfo& vk_commandBuff
 
 void RecordCommandBuffer(const VkCommandBufferBeginInfo& vk_commandBufferBegin, const VkRenderPassBeginInfo& vk_renderPassBegin,
 	const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline,
-	const VkExtent2D vk_imageExtent)
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh)
 {
 	vkBeginCommandBuffer(vk_commandBuffer, &vk_commandBufferBegin);
-	vkCmdBeginRenderPass(vk_commandBuffer, &vk_renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+	RecordRenderPassCommands(vk_renderPassBegin, vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh, 1);
+	vkEndCommandBuffer(vk_commandBuffer);
+}
+
+/* Binds the pipeline, sets its dynamic state and binds the buffers of the mesh. Secondary command buffers don't inherit any
+   of this from the primary, so each of them records it as well */
+static void RecordMeshDrawState(const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline,
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh)
+{
 	vkCmdBindPipeline(vk_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vk_graphicsPipeline);
 
 	//Setting the dynamic state of the pipeline that we specified during its creation
@@ -42,8 +59,68 @@ void RecordCommandBuffer(const VkCommandBufferBeginInfo& vk_commandBufferBegin,
 	scissor.extent = vk_imageExtent;
 	vkCmdSetScissor(vk_commandBuffer, 0, 1, &scissor);
 
-	vkCmdDraw(vk_commandBuffer, 3, 1, 0, 0);
+	//Binding 0 holds the vertices of the mesh and binding 1 the data of each instance
+	VkBuffer vk_vertexBuffers[] = { mesh.vk_vertexBuffer, mesh.vk_instanceBuffer };
+	VkDeviceSize vertexBufferOffsets[] = { 0, 0 };
+	vkCmdBindVertexBuffers(vk_commandBuffer, 0, 2, vk_vertexBuffers, vertexBufferOffsets);
+	vkCmdBindIndexBuffer(vk_commandBuffer, mesh.vk_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
 
+	/* Binding the frame's uniforms only passes an offset, and the bindless set holds every resource, so neither set is 
+	   written while recording and draws with different materials only push different handles */
+	VkDescriptorSet vk_descriptorSets[] = { mesh.vk_frameDescriptorSet, mesh.vk_bindlessDescriptorSet };
+	vkCmdBindDescriptorSets(vk_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh.vk_pipelineLayout, 0, 2, 
+		vk_descriptorSets, 1, &mesh.frameUniformOffset);
+	vkCmdPushConstants(vk_commandBuffer, mesh.vk_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		0, sizeof(DrawPushConstants), &mesh.drawConstants);
+}
+
+void RecordRenderPassCommands(const VkRenderPassBeginInfo& vk_renderPassBegin, const VkCommandBuffer& vk_commandBuffer, 
+	const VkPipeline& vk_graphicsPipeline, const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, 
+	uint32_t instanceCount)
+{
+	vkCmdBeginRenderPass(vk_commandBuffer, &vk_renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+	RecordMeshDraws(vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh, instanceCount);
 	vkCmdEndRenderPass(vk_commandBuffer);
-	vkEndCommandBuffer(vk_commandBuffer);
+}
+
+void RecordMeshDraws(const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline, 
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, uint32_t instanceCount)
+{
+	//The render pass still clears the target while the mesh is being uploaded
+	if (mesh.indexCount)
+	{
+		RecordMeshDrawState(vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh);
+		//A single draw covers every instance, so the CPU cost of the draw does not grow with the amount of objects
+		if (mesh.vk_drawArgumentsBuffer == VK_NULL_HANDLE)
+		{
+			vkCmdDrawIndexed(vk_commandBuffer, mesh.indexCount, instanceCount, 0, 0, 0);
+		}
+		//The culling pass wrote the amount of visible instances into the draw arguments, it never goes back to the CPU
+		else if (mesh.vk_drawIndexedIndirectCount)
+		{
+			mesh.vk_drawIndexedIndirectCount(vk_commandBuffer, mesh.vk_drawArgumentsBuffer, 0, mesh.vk_drawArgumentsBuffer,
+				offsetof(GpuDrawArguments, drawCount), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdDrawIndexedIndirect(vk_commandBuffer, mesh.vk_drawArgumentsBuffer, 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+	}
+}
+
+void RecordInstanceRangeDraws(const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline,
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, uint32_t firstInstance, uint32_t instanceCount,
+	uint32_t instancesPerDraw)
+{
+	if (!mesh.indexCount || !instanceCount)
+	{
+		return;
+	}
+	RecordMeshDrawState(vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh);
+	uint32_t endInstance = firstInstance + instanceCount;
+	for (uint32_t instance = firstInstance; instance < endInstance; instance += instancesPerDraw)
+	{
+		uint32_t drawInstanceCount = endInstance - instance < instancesPerDraw ? endInstance - instance : instancesPerDraw;
+		vkCmdDrawIndexed(vk_commandBuffer, mesh.indexCount, drawInstanceCount, 0, 0, instance);
+	}
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#include "VulkanGraphics.h"
+
+void CreateVulkanComputePipeline(VkPipeline& vk_computePipeline, const VkComputePipelineCreateInfo& vk_pipelineInfo,
+	const VkDevice& vk_device, const VkPipelineCache& vk_pipelineCache)
+{
+	VkResult vk_pipelineCreationResult = vkCreateComputePipelines(vk_device, vk_pipelineCache, 1, &vk_pipelineInfo, nullptr,
+		&vk_computePipeline);
+	if (vk_pipelineCreationResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+}
\ No newline at end of file
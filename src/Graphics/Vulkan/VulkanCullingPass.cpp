@@ -0,0 +1,194 @@
+#include "VulkanGraphics.h"
+#include <algorithm>
+#include <cstring>
+
+VulkanCullingPass::VulkanCullingPass()
+	:vk_device(VK_NULL_HANDLE), m_memoryAllocator(nullptr), vk_descriptorSetLayout(VK_NULL_HANDLE), 
+	vk_descriptorPool(VK_NULL_HANDLE), vk_pipelineLayout(VK_NULL_HANDLE), vk_cullingPipeline(), m_frames()
+{
+
+}
+
+VulkanCullingPass::~VulkanCullingPass()
+{
+
+}
+
+void VulkanCullingPass::Init(const VkDevice& device, VulkanMemoryAllocator& memoryAllocator, uint32_t framesInFlight)
+{
+	vk_device = device;
+	m_memoryAllocator = &memoryAllocator;
+	m_frames.resize(framesInFlight);
+
+	//Binding 0 holds the instances, binding 1 the visible instances and binding 2 the arguments of the indirect draw
+	VkDescriptorSetLayoutBinding vk_bindings[3]{};
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		vk_bindings[i].binding = i;
+		vk_bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		vk_bindings[i].descriptorCount = 1;
+		vk_bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo vk_setLayoutInfo{};
+	vk_setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	vk_setLayoutInfo.bindingCount = 3;
+	vk_setLayoutInfo.pBindings = vk_bindings;
+	if (vkCreateDescriptorSetLayout(vk_device, &vk_setLayoutInfo, nullptr, &vk_descriptorSetLayout) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	//Each frame slot gets its own descriptor set, since each slot culls its own instance buffer
+	VkDescriptorPoolSize vk_poolSize{};
+	vk_poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	vk_poolSize.descriptorCount = 3 * framesInFlight;
+	VkDescriptorPoolCreateInfo vk_poolInfo{};
+	vk_poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	vk_poolInfo.maxSets = framesInFlight;
+	vk_poolInfo.poolSizeCount = 1;
+	vk_poolInfo.pPoolSizes = &vk_poolSize;
+	if (vkCreateDescriptorPool(vk_device, &vk_poolInfo, nullptr, &vk_descriptorPool) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+	std::vector<VkDescriptorSetLayout> setLayouts(framesInFlight, vk_descriptorSetLayout);
+	std::vector<VkDescriptorSet> descriptorSets(framesInFlight);
+	VkDescriptorSetAllocateInfo vk_setAllocateInfo{};
+	vk_setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	vk_setAllocateInfo.descriptorPool = vk_descriptorPool;
+	vk_setAllocateInfo.descriptorSetCount = framesInFlight;
+	vk_setAllocateInfo.pSetLayouts = setLayouts.data();
+	if (vkAllocateDescriptorSets(vk_device, &vk_setAllocateInfo, descriptorSets.data()) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	//The draw arguments are reset with a transfer command at the start of every frame and read by the indirect draw
+	for (uint32_t i = 0; i < framesInFlight; ++i)
+	{
+		m_frames[i].vk_descriptorSet = descriptorSets[i];
+		CreateVulkanBuffer(m_frames[i].drawArguments, sizeof(GpuDrawArguments), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | 
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+			VulkanAllocationStrategy::Buddy, vk_device, memoryAllocator);
+	}
+
+	VkPushConstantRange vk_pushConstantRange{};
+	vk_pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	vk_pushConstantRange.offset = 0;
+	vk_pushConstantRange.size = sizeof(CullingPushConstants);
+	VkPipelineLayoutCreateInfo vk_pipelineLayoutInfo{};
+	vk_pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	vk_pipelineLayoutInfo.setLayoutCount = 1;
+	vk_pipelineLayoutInfo.pSetLayouts = &vk_descriptorSetLayout;
+	vk_pipelineLayoutInfo.pushConstantRangeCount = 1;
+	vk_pipelineLayoutInfo.pPushConstantRanges = &vk_pushConstantRange;
+	CreateVulkanGraphicsPipelineLayout(vk_pipelineLayoutInfo, vk_device, vk_pipelineLayout);
+}
+
+VkPipeline VulkanCullingPass::CompilePipeline(const VkPipelineCache& vk_pipelineCache, 
+	const ShaderCode& cullingShaderCode) const
+{
+	VkShaderModule vk_shaderModule;
+	CreateVulkanShaderModule(vk_shaderModule, cullingShaderCode, vk_device);
+	//The pipeline keeps what it needs from the shader module, so it is destroyed as soon as the compilation returns
+	VulkanShaderModuleHandle shaderModule(vk_device, vk_shaderModule);
+	VkComputePipelineCreateInfo vk_pipelineInfo{};
+	vk_pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	vk_pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	vk_pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	vk_pipelineInfo.stage.module = vk_shaderModule;
+	vk_pipelineInfo.stage.pName = "main";
+	vk_pipelineInfo.layout = vk_pipelineLayout;
+	VkPipeline vk_pipeline;
+	CreateVulkanComputePipeline(vk_pipeline, vk_pipelineInfo, vk_device, vk_pipelineCache);
+	return vk_pipeline;
+}
+
+void VulkanCullingPass::SetInstanceBuffers(const std::vector<VulkanBuffer>& instanceBuffers, uint32_t instanceCapacity)
+{
+	for (uint32_t i = 0; i < m_frames.size(); ++i)
+	{
+		CullingFrame& frame = m_frames[i];
+		//The visible instances are only written and read by the GPU, so they live in device local memory
+		DestroyVulkanBuffer(frame.visibleInstances, vk_device, *m_memoryAllocator);
+		CreateVulkanBuffer(frame.visibleInstances, sizeof(InstanceData) * instanceCapacity, 
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+			VulkanAllocationStrategy::Buddy, vk_device, *m_memoryAllocator);
+
+		VkDescriptorBufferInfo vk_bufferInfos[3]{};
+		vk_bufferInfos[0] = { instanceBuffers[i].vk_buffer, 0, VK_WHOLE_SIZE };
+		vk_bufferInfos[1] = { frame.visibleInstances.vk_buffer, 0, VK_WHOLE_SIZE };
+		vk_bufferInfos[2] = { frame.drawArguments.vk_buffer, 0, VK_WHOLE_SIZE };
+		VkWriteDescriptorSet vk_descriptorWrite{};
+		vk_descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		vk_descriptorWrite.dstSet = frame.vk_descriptorSet;
+		vk_descriptorWrite.dstBinding = 0;
+		vk_descriptorWrite.descriptorCount = 3;
+		vk_descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		vk_descriptorWrite.pBufferInfo = vk_bufferInfos;
+		vkUpdateDescriptorSets(vk_device, 1, &vk_descriptorWrite, 0, nullptr);
+	}
+}
+
+void VulkanCullingPass::RecordCulling(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t instanceCount,
+	uint32_t indexCount, float meshRadius, const float viewTransform[4])
+{
+	CullingFrame& frame = m_frames[frameIndex];
+
+	//The instance count and the draw count are incremented by the shader, so they start from 0 every frame
+	GpuDrawArguments drawArguments{};
+	drawArguments.vk_drawCommand.indexCount = indexCount;
+	vkCmdUpdateBuffer(vk_commandBuffer, frame.drawArguments.vk_buffer, 0, sizeof(GpuDrawArguments), &drawArguments);
+	VkMemoryBarrier vk_resetBarrier{};
+	vk_resetBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	vk_resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vk_resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(vk_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+		1, &vk_resetBarrier, 0, nullptr, 0, nullptr);
+
+	/* The application draws in clip space, so the frustum is the box from -1 to 1 on x and y after the view transform. The
+	   instances are culled before the view transform, so the box is moved back through it: x is visible when 
+	   -1 <= x * scale + offset <= 1. The last two planes always pass, they are there for views that have a near and a far 
+	   plane. SetViewTransform keeps the scale away from zero */
+	CullingPushConstants pushConstants{};
+	float minX = (-1.0f - viewTransform[0]) / viewTransform[2];
+	float maxX = (1.0f - viewTransform[0]) / viewTransform[2];
+	float minY = (-1.0f - viewTransform[1]) / viewTransform[3];
+	float maxY = (1.0f - viewTransform[1]) / viewTransform[3];
+	float frustumPlanes[6][4] =
+	{
+		{ 1.0f, 0.0f, 0.0f, -std::min(minX, maxX) }, { -1.0f, 0.0f, 0.0f, std::max(minX, maxX) },
+		{ 0.0f, 1.0f, 0.0f, -std::min(minY, maxY) }, { 0.0f, -1.0f, 0.0f, std::max(minY, maxY) },
+		{ 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }
+	};
+	std::memcpy(pushConstants.frustumPlanes, frustumPlanes, sizeof(frustumPlanes));
+	pushConstants.objectCount = instanceCount;
+	pushConstants.meshRadius = meshRadius;
+
+	vkCmdBindPipeline(vk_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_cullingPipeline);
+	vkCmdBindDescriptorSets(vk_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vk_pipelineLayout, 0, 1, 
+		&frame.vk_descriptorSet, 0, nullptr);
+	vkCmdPushConstants(vk_commandBuffer, vk_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullingPushConstants),
+		&pushConstants);
+	vkCmdDispatch(vk_commandBuffer, (instanceCount + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+}
+
+void VulkanCullingPass::Cleanup()
+{
+	//The pass was never initialized if culling on the GPU was disabled
+	if (vk_device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	for (CullingFrame& frame : m_frames)
+	{
+		DestroyVulkanBuffer(frame.visibleInstances, vk_device, *m_memoryAllocator);
+		DestroyVulkanBuffer(frame.drawArguments, vk_device, *m_memoryAllocator);
+	}
+	m_frames.clear();
+	vk_cullingPipeline.Reset();
+	vkDestroyPipelineLayout(vk_device, vk_pipelineLayout, nullptr);
+	//Destroying the pool frees the descriptor sets that were allocated from it
+	vkDestroyDescriptorPool(vk_device, vk_descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vk_device, vk_descriptorSetLayout, nullptr);
+}
\ No newline at end of file
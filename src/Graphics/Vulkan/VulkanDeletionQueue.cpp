@@ -0,0 +1,77 @@
+#include "VulkanGraphics.h"
+
+VulkanDeletionQueue::VulkanDeletionQueue()
+	:vk_device(VK_NULL_HANDLE), m_memoryAllocator(nullptr), m_retired(), m_currentFrame(0)
+{
+
+}
+
+VulkanDeletionQueue::~VulkanDeletionQueue()
+{
+
+}
+
+void VulkanDeletionQueue::Init(const VkDevice& device, VulkanMemoryAllocator& memoryAllocator, uint32_t framesInFlight)
+{
+	vk_device = device;
+	m_memoryAllocator = &memoryAllocator;
+	m_retired.resize(framesInFlight);
+	m_currentFrame = 0;
+}
+
+void VulkanDeletionQueue::BeginFrame(uint32_t frameIndex)
+{
+	m_currentFrame = frameIndex;
+	//The resources are destroyed in the order they were retired
+	for (std::function<void()>& destroy : m_retired[frameIndex])
+	{
+		destroy();
+	}
+	m_retired[frameIndex].clear();
+}
+
+void VulkanDeletionQueue::Retire(VulkanBuffer& buffer)
+{
+	if (buffer.vk_buffer == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	VkDevice vk_bufferDevice = vk_device;
+	VulkanMemoryAllocator* memoryAllocator = m_memoryAllocator;
+	VulkanBuffer retiredBuffer = buffer;
+	buffer = VulkanBuffer{};
+	Retire([vk_bufferDevice, memoryAllocator, retiredBuffer]() mutable 
+		{ DestroyVulkanBuffer(retiredBuffer, vk_bufferDevice, *memoryAllocator); });
+}
+
+void VulkanDeletionQueue::Retire(std::function<void()> destroy)
+{
+	//Before the queue is initialized there is no frame that could be using the resource
+	if (m_retired.empty())
+	{
+		destroy();
+		return;
+	}
+	m_retired[m_currentFrame].push_back(std::move(destroy));
+}
+
+void VulkanDeletionQueue::Flush()
+{
+	/* Starting with the slot after the last one to begin, which holds the resources that were retired the longest time 
+	   ago, so that they are destroyed in the order they were retired */
+	for (uint32_t i = 1; i <= m_retired.size(); ++i)
+	{
+		std::vector<std::function<void()>>& retired = m_retired[(m_currentFrame + i) % m_retired.size()];
+		for (std::function<void()>& destroy : retired)
+		{
+			destroy();
+		}
+		retired.clear();
+	}
+}
+
+void VulkanDeletionQueue::Cleanup()
+{
+	Flush();
+	m_retired.clear();
+}
\ No newline at end of file
@@ -1,28 +1,272 @@
 #include "VulkanGraphics.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 void PickPhysicalDevice(const VkInstance& vk_instance, const VkSurfaceKHR& vk_surface, VkPhysicalDevice& vk_GraphicsCard,
 	QueueFamilyIndices& gpuQueueFamilyIndices,const std::vector<const char*>& requiredDeviceExtensions, 
-	SwapchainSupportDetails& gpuSwapchainSupport)
+	SwapchainSupportDetails& gpuSwapchainSupport, const std::string& graphicsCardOverride, 
+	bool physicalDeviceProperties2Enabled)
+{
+	GraphicsCardCandidate graphicsCard{};
+	if (!PickScoredGraphicsCard(vk_instance, vk_surface, requiredDeviceExtensions, graphicsCardOverride, 
+		physicalDeviceProperties2Enabled, graphicsCard))
+	{
+		__debugbreak();
+	}
+	vk_GraphicsCard = graphicsCard.vk_graphicsCard;
+	gpuQueueFamilyIndices = graphicsCard.queueFamilies;
+	CheckGraphicsCardSwapchainSupport(vk_GraphicsCard, vk_surface, gpuSwapchainSupport);
+}
+
+void PickHeadlessPhysicalDevice(const VkInstance& vk_instance, VkPhysicalDevice& vk_GraphicsCard,
+	QueueFamilyIndices& gpuQueueFamilyIndices, const std::vector<const char*>& requiredDeviceExtensions,
+	const std::string& graphicsCardOverride, bool physicalDeviceProperties2Enabled)
+{
+	//Without a surface nothing is presented, and the present family is set to the graphics family
+	GraphicsCardCandidate graphicsCard{};
+	if (!PickScoredGraphicsCard(vk_instance, VK_NULL_HANDLE, requiredDeviceExtensions, graphicsCardOverride, 
+		physicalDeviceProperties2Enabled, graphicsCard))
+	{
+		__debugbreak();
+	}
+	vk_GraphicsCard = graphicsCard.vk_graphicsCard;
+	gpuQueueFamilyIndices = graphicsCard.queueFamilies;
+}
+
+bool PickScoredGraphicsCard(const VkInstance& vk_instance, const VkSurfaceKHR& vk_surface,
+	const std::vector<const char*>& requiredDeviceExtensions, const std::string& graphicsCardOverride,
+	bool physicalDeviceProperties2Enabled, GraphicsCardCandidate& pickedGraphicsCard)
 {
 	uint32_t graphicsCardsCount;
 	vkEnumeratePhysicalDevices(vk_instance, &graphicsCardsCount, nullptr);
 	std::vector<VkPhysicalDevice> graphicsCards(graphicsCardsCount);
 	vkEnumeratePhysicalDevices(vk_instance, &graphicsCardsCount, graphicsCards.data());
-	for (uint32_t i = 0; i < graphicsCards.size(); ++i)
+
+	PFN_vkGetPhysicalDeviceProperties2KHR vk_getProperties2 = nullptr;
+	if (physicalDeviceProperties2Enabled)
+	{
+		vk_getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+			vkGetInstanceProcAddr(vk_instance, "vkGetPhysicalDeviceProperties2KHR"));
+	}
+	std::vector<GraphicsCardCandidate> candidates(graphicsCards.size());
+	for (size_t i = 0; i < graphicsCards.size(); ++i)
+	{
+		DescribeGraphicsCard(graphicsCards[i], vk_surface, requiredDeviceExtensions, vk_getProperties2, candidates[i]);
+	}
+
+	//The override passed by the application comes first, the environment can name a card when the application doesn't
+	std::string graphicsCardName = graphicsCardOverride;
+	const char* environmentOverride = std::getenv(GRAPHICS_CARD_OVERRIDE_VARIABLE);
+	if (graphicsCardName.empty() && environmentOverride)
+	{
+		graphicsCardName = environmentOverride;
+	}
+
+	int32_t pickedIndex = SelectGraphicsCard(candidates, graphicsCardName);
+	if (pickedIndex < 0)
+	{
+		return false;
+	}
+	pickedGraphicsCard = candidates[pickedIndex];
+	return true;
+}
+
+void DescribeGraphicsCard(const VkPhysicalDevice& vk_graphicsCard, const VkSurfaceKHR& vk_surface,
+	const std::vector<const char*>& requiredDeviceExtensions, PFN_vkGetPhysicalDeviceProperties2KHR vk_getProperties2,
+	GraphicsCardCandidate& candidate)
+{
+	candidate.vk_graphicsCard = vk_graphicsCard;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &candidate.vk_properties);
+	if (vk_getProperties2)
+	{
+		VkPhysicalDeviceIDPropertiesKHR vk_idProperties{};
+		vk_idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR;
+		VkPhysicalDeviceProperties2KHR vk_properties2{};
+		vk_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+		vk_properties2.pNext = &vk_idProperties;
+		vk_getProperties2(vk_graphicsCard, &vk_properties2);
+		std::memcpy(candidate.deviceUUID, vk_idProperties.deviceUUID, VK_UUID_SIZE);
+	}
+	else
+	{
+		std::memcpy(candidate.deviceUUID, candidate.vk_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	}
+
+	//The largest device local heap, since that is where the render targets and the meshes live
+	VkPhysicalDeviceMemoryProperties vk_memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(vk_graphicsCard, &vk_memoryProperties);
+	candidate.deviceLocalMemory = 0;
+	for (uint32_t i = 0; i < vk_memoryProperties.memoryHeapCount; ++i)
 	{
-		if (CheckGraphicsCardQueueFamilies(graphicsCards[i], gpuQueueFamilyIndices, vk_surface) &&
-			CheckGraphicsCardExtensionsSupport(graphicsCards[i], requiredDeviceExtensions) && 
-			CheckGraphicsCardSwapchainSupport(graphicsCards[i], vk_surface, gpuSwapchainSupport))
+		const VkMemoryHeap& vk_heap = vk_memoryProperties.memoryHeaps[i];
+		if ((vk_heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && vk_heap.size > candidate.deviceLocalMemory)
 		{
-			vk_GraphicsCard = graphicsCards[i];
-			break;
+			candidate.deviceLocalMemory = vk_heap.size;
 		}
 	}
 
-	if (vk_GraphicsCard == VK_NULL_HANDLE)
+	candidate.queueFamiliesSupported = CheckGraphicsCardQueueFamilies(vk_graphicsCard, candidate.queueFamilies, vk_surface);
+	candidate.extensionsSupported = CheckGraphicsCardExtensionsSupport(vk_graphicsCard, requiredDeviceExtensions);
+	//The swapchain support is only needed when there is a surface to present to
+	SwapchainSupportDetails swapchainSupport{};
+	candidate.swapchainSupported = vk_surface == VK_NULL_HANDLE || 
+		(candidate.extensionsSupported && CheckGraphicsCardSwapchainSupport(vk_graphicsCard, vk_surface, swapchainSupport));
+}
+
+uint64_t ScoreGraphicsCard(const GraphicsCardCandidate& candidate)
+{
+	if (!candidate.queueFamiliesSupported || !candidate.extensionsSupported || !candidate.swapchainSupported)
+	{
+		return 0;
+	}
+
+	/* The type of the card outweighs everything else, a discrete card beats an integrated one whatever their memory. Within
+	   a type the card with more device local memory wins, and the queue topology and the limits break the ties */
+	uint64_t score = 0;
+	switch (candidate.vk_properties.deviceType)
 	{
-		__debugbreak();
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+		score += 4'000'000;
+		break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+		score += 3'000'000;
+		break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+		score += 2'000'000;
+		break;
+	default:
+		//Software rasterizers like lavapipe report themselves as CPUs, they are still usable if nothing else is
+		score += 1'000'000;
+		break;
+	}
+	score += std::min<uint64_t>(candidate.deviceLocalMemory / (1024 * 1024), 500'000);
+
+	const QueueFamilyIndices& queueFamilies = candidate.queueFamilies;
+	if (queueFamilies.transfer != queueFamilies.graphics)
+	{
+		score += 1000;
+	}
+	if (queueFamilies.compute != queueFamilies.graphics)
+	{
+		score += 1000;
+	}
+	//Presenting from the graphics family means that the swapchain images never change queue family ownership
+	if (queueFamilies.present == queueFamilies.graphics)
+	{
+		score += 500;
+	}
+	const VkPhysicalDeviceLimits& vk_limits = candidate.vk_properties.limits;
+	score += vk_limits.maxImageDimension2D / 16;
+	score += vk_limits.maxComputeWorkGroupInvocations / 8;
+	return score;
+}
+
+bool MatchesGraphicsCardOverride(const GraphicsCardCandidate& candidate, const std::string& graphicsCardOverride)
+{
+	if (graphicsCardOverride.empty())
+	{
+		return false;
+	}
+
+	//The override can be the hex digits of the card's UUID, with or without dashes and in either case
+	std::string overrideDigits;
+	for (char character : graphicsCardOverride)
+	{
+		if (character != '-')
+		{
+			overrideDigits.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(character))));
+		}
 	}
+	char uuidDigits[2 * VK_UUID_SIZE + 1];
+	for (uint32_t i = 0; i < VK_UUID_SIZE; ++i)
+	{
+		std::snprintf(uuidDigits + 2 * i, 3, "%02x", candidate.deviceUUID[i]);
+	}
+	if (overrideDigits == uuidDigits)
+	{
+		return true;
+	}
+
+	//Otherwise it is a part of the card's name, compared without case so that "nvidia" matches "NVIDIA GeForce"
+	std::string deviceName = candidate.vk_properties.deviceName;
+	std::string overrideName = graphicsCardOverride;
+	for (char& character : deviceName)
+	{
+		character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+	}
+	for (char& character : overrideName)
+	{
+		character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+	}
+	return deviceName.find(overrideName) != std::string::npos;
+}
+
+int32_t SelectGraphicsCard(const std::vector<GraphicsCardCandidate>& candidates, const std::string& graphicsCardOverride)
+{
+	int32_t bestIndex = -1;
+	uint64_t bestScore = 0;
+	int32_t overrideIndex = -1;
+	for (size_t i = 0; i < candidates.size(); ++i)
+	{
+		uint64_t score = ScoreGraphicsCard(candidates[i]);
+		std::cout << "Graphics card " << i << ": " << candidates[i].vk_properties.deviceName << ", score " << score;
+		if (!score)
+		{
+			std::cout << " (missing required queue families, extensions or swapchain support)";
+		}
+		std::cout << '\n';
+		if (score > bestScore)
+		{
+			bestScore = score;
+			bestIndex = static_cast<int32_t>(i);
+		}
+		//An override can only pick a card that the application is able to use
+		if (score && overrideIndex < 0 && MatchesGraphicsCardOverride(candidates[i], graphicsCardOverride))
+		{
+			overrideIndex = static_cast<int32_t>(i);
+		}
+	}
+
+	if (overrideIndex >= 0)
+	{
+		std::cout << "Picked graphics card " << candidates[overrideIndex].vk_properties.deviceName 
+			<< " because it matches the override \"" << graphicsCardOverride << "\"\n";
+		return overrideIndex;
+	}
+	if (!graphicsCardOverride.empty())
+	{
+		std::cout << "No usable graphics card matches the override \"" << graphicsCardOverride 
+			<< "\", falling back to the highest score\n";
+	}
+	if (bestIndex >= 0)
+	{
+		std::cout << "Picked graphics card " << candidates[bestIndex].vk_properties.deviceName 
+			<< " with the highest score\n";
+	}
+	return bestIndex;
+}
+
+uint32_t FindDedicatedTransferQueueFamily(const VkPhysicalDevice& vk_graphicsCard, uint32_t graphicsQueueFamilyIndex)
+{
+	uint32_t queueFamilyPropertiesCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(vk_graphicsCard, &queueFamilyPropertiesCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertiesCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(vk_graphicsCard, &queueFamilyPropertiesCount, queueFamilyProperties.data());
+
+	/* Graphics and compute families support transfer commands as well, but a family that supports nothing else is
+	   backed by a copy engine that works alongside the graphics queue instead of taking time away from it */
+	for (uint32_t i = 0; i < queueFamilyProperties.size(); ++i)
+	{
+		VkQueueFlags vk_queueFlags = queueFamilyProperties[i].queueFlags;
+		if ((vk_queueFlags & VK_QUEUE_TRANSFER_BIT) && !(vk_queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+		{
+			return i;
+		}
+	}
+	return graphicsQueueFamilyIndex;
 }
 
 bool CheckGraphicsCardQueueFamilies(const VkPhysicalDevice& vk_graphicsCard, QueueFamilyIndices& gpuQueueFamilyIndices, 
@@ -33,30 +277,61 @@ bool CheckGraphicsCardQueueFamilies(const VkPhysicalDevice& vk_graphicsCard, Que
 	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertiesCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(vk_graphicsCard, &queueFamilyPropertiesCount, queueFamilyProperties.data());
 
-	//Checking for graphics family index
+	//Checking which families can present, without a surface every family counts as one that can
+	std::vector<VkBool32> presentationSupport(queueFamilyProperties.size(), VK_TRUE);
+	if (vk_surface != VK_NULL_HANDLE)
+	{
+		for (uint32_t i = 0; i < queueFamilyProperties.size(); ++i)
+		{
+			vkGetPhysicalDeviceSurfaceSupportKHR(vk_graphicsCard, i, vk_surface, &presentationSupport[i]);
+		}
+	}
+
+	/* Checking for graphics family index. A graphics family that can also present is preferred, so that the swapchain 
+	   images don't need to change ownership between queue families */
 	bool graphicsFamilyFound = false;
-	for (size_t i = 0; i < queueFamilyProperties.size(); ++i)
+	for (uint32_t i = 0; i < queueFamilyProperties.size(); ++i)
 	{
-		if (queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		if (!(queueFamilyProperties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+		{
+			continue;
+		}
+		if (!graphicsFamilyFound || (presentationSupport[i] && !presentationSupport[gpuQueueFamilyIndices.graphics]))
 		{
 			graphicsFamilyFound = true;
-			gpuQueueFamilyIndices.graphics = static_cast<uint32_t>(i);
-			break;
+			gpuQueueFamilyIndices.graphics = i;
 		}
 	}
 
 	//Checking for present family index
 	bool presentFamilyFound = false;
-	for (uint32_t i = 0; i < queueFamilyProperties.size(); ++i)
+	if (graphicsFamilyFound && presentationSupport[gpuQueueFamilyIndices.graphics])
 	{
-		VkBool32 presentationSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(vk_graphicsCard, i, vk_surface,
-			&presentationSupport);
-		if (presentationSupport)
+		presentFamilyFound = true;
+		gpuQueueFamilyIndices.present = gpuQueueFamilyIndices.graphics;
+	}
+	for (uint32_t i = 0; i < queueFamilyProperties.size() && !presentFamilyFound; ++i)
+	{
+		if (presentationSupport[i])
 		{
 			presentFamilyFound = true;
 			gpuQueueFamilyIndices.present = i;
-			break;
+		}
+	}
+
+	//Checking for dedicated transfer and compute family indices, both fall back to the graphics family if there is none
+	if (graphicsFamilyFound)
+	{
+		gpuQueueFamilyIndices.transfer = FindDedicatedTransferQueueFamily(vk_graphicsCard, gpuQueueFamilyIndices.graphics);
+		gpuQueueFamilyIndices.compute = gpuQueueFamilyIndices.graphics;
+		for (uint32_t i = 0; i < queueFamilyProperties.size(); ++i)
+		{
+			VkQueueFlags vk_queueFlags = queueFamilyProperties[i].queueFlags;
+			if ((vk_queueFlags & VK_QUEUE_COMPUTE_BIT) && !(vk_queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				gpuQueueFamilyIndices.compute = i;
+				break;
+			}
 		}
 	}
 
@@ -0,0 +1,122 @@
+#include "VulkanGraphics.h"
+#include <cstring>
+
+VulkanFrameConstants::VulkanFrameConstants()
+	:vk_device(VK_NULL_HANDLE), m_memoryAllocator(nullptr), m_ring(), m_frameSize(0), m_blockAlignment(1), m_blockSize(0),
+	vk_descriptorSetLayout(VK_NULL_HANDLE), vk_descriptorPool(VK_NULL_HANDLE), vk_descriptorSet(VK_NULL_HANDLE), m_frames()
+{
+
+}
+
+VulkanFrameConstants::~VulkanFrameConstants()
+{
+
+}
+
+void VulkanFrameConstants::Init(const VkDevice& device, const VkPhysicalDevice& vk_graphicsCard, 
+	VulkanMemoryAllocator& memoryAllocator, uint32_t framesInFlight, VkDeviceSize frameSize, uint32_t blockSize)
+{
+	vk_device = device;
+	m_memoryAllocator = &memoryAllocator;
+	m_blockSize = blockSize;
+
+	//Dynamic offsets need to be multiples of the device's uniform buffer alignment, so each part of the ring is as well
+	VkPhysicalDeviceProperties vk_gpuProperties;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &vk_gpuProperties);
+	m_blockAlignment = vk_gpuProperties.limits.minUniformBufferOffsetAlignment;
+	m_frameSize = (frameSize + m_blockAlignment - 1) / m_blockAlignment * m_blockAlignment;
+
+	//The ring is only written by the CPU and read by the shaders of the frames in flight, it stays mapped while it lives
+	CreateVulkanBuffer(m_ring, m_frameSize * framesInFlight, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+		VulkanAllocationStrategy::Linear, vk_device, memoryAllocator);
+	if (!m_ring.allocation.mappedData)
+	{
+		__debugbreak();
+	}
+
+	VkDescriptorSetLayoutBinding vk_binding{};
+	vk_binding.binding = 0;
+	vk_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	vk_binding.descriptorCount = 1;
+	vk_binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	VkDescriptorSetLayoutCreateInfo vk_setLayoutInfo{};
+	vk_setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	vk_setLayoutInfo.bindingCount = 1;
+	vk_setLayoutInfo.pBindings = &vk_binding;
+	if (vkCreateDescriptorSetLayout(vk_device, &vk_setLayoutInfo, nullptr, &vk_descriptorSetLayout) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	//A single set covers the whole ring, the dynamic offset picks the block, so it is written once and never again
+	VkDescriptorPoolSize vk_poolSize{};
+	vk_poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	vk_poolSize.descriptorCount = 1;
+	VkDescriptorPoolCreateInfo vk_poolInfo{};
+	vk_poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	vk_poolInfo.maxSets = 1;
+	vk_poolInfo.poolSizeCount = 1;
+	vk_poolInfo.pPoolSizes = &vk_poolSize;
+	if (vkCreateDescriptorPool(vk_device, &vk_poolInfo, nullptr, &vk_descriptorPool) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+	VkDescriptorSetAllocateInfo vk_setAllocateInfo{};
+	vk_setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	vk_setAllocateInfo.descriptorPool = vk_descriptorPool;
+	vk_setAllocateInfo.descriptorSetCount = 1;
+	vk_setAllocateInfo.pSetLayouts = &vk_descriptorSetLayout;
+	if (vkAllocateDescriptorSets(vk_device, &vk_setAllocateInfo, &vk_descriptorSet) != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+	VkDescriptorBufferInfo vk_bufferInfo{ m_ring.vk_buffer, 0, blockSize };
+	VkWriteDescriptorSet vk_descriptorWrite{};
+	vk_descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	vk_descriptorWrite.dstSet = vk_descriptorSet;
+	vk_descriptorWrite.dstBinding = 0;
+	vk_descriptorWrite.descriptorCount = 1;
+	vk_descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+	vk_descriptorWrite.pBufferInfo = &vk_bufferInfo;
+	vkUpdateDescriptorSets(vk_device, 1, &vk_descriptorWrite, 0, nullptr);
+
+	m_frames.resize(framesInFlight);
+	for (uint32_t i = 0; i < framesInFlight; ++i)
+	{
+		m_frames[i].writeOffset = m_frameSize * i;
+	}
+}
+
+void VulkanFrameConstants::BeginFrame(uint32_t frameIndex)
+{
+	ConstantsFrame& frame = m_frames[frameIndex];
+	frame.writeOffset = m_frameSize * frameIndex;
+}
+
+uint32_t VulkanFrameConstants::Write(uint32_t frameIndex, const void* data, uint32_t size)
+{
+	ConstantsFrame& frame = m_frames[frameIndex];
+	//A block can't be bigger than the range of the descriptor, and a frame can't write past its part of the ring
+	if (size > m_blockSize || frame.writeOffset + m_blockSize > m_frameSize * (frameIndex + 1))
+	{
+		__debugbreak();
+	}
+	VkDeviceSize blockOffset = frame.writeOffset;
+	std::memcpy(static_cast<char*>(m_ring.allocation.mappedData) + blockOffset, data, size);
+	frame.writeOffset += (size + m_blockAlignment - 1) / m_blockAlignment * m_blockAlignment;
+	return static_cast<uint32_t>(blockOffset);
+}
+
+void VulkanFrameConstants::Cleanup()
+{
+	if (vk_device == VK_NULL_HANDLE)
+	{
+		return;
+	}
+	m_frames.clear();
+	DestroyVulkanBuffer(m_ring, vk_device, *m_memoryAllocator);
+	//Destroying the pool frees the descriptor set that was allocated from it
+	vkDestroyDescriptorPool(vk_device, vk_descriptorPool, nullptr);
+	vkDestroyDescriptorSetLayout(vk_device, vk_descriptorSetLayout, nullptr);
+}
\ No newline at end of file
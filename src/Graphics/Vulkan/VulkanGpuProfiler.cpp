@@ -0,0 +1,262 @@
+#include "VulkanGraphics.h"
+#include <algorithm>
+
+VulkanGpuProfiler::VulkanGpuProfiler()
+	:m_enabled(false), m_pipelineStatisticsEnabled(false), m_timestampPeriod(1.0f), m_timestampMask(0), m_frames(), 
+	m_scopes(), m_lastPipelineStatistics()
+{
+
+}
+
+VulkanGpuProfiler::~VulkanGpuProfiler()
+{
+
+}
+
+void VulkanGpuProfiler::CreateQueryPools(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard,
+	uint32_t queueFamilyIndex, uint32_t framesInFlight, bool pipelineStatistics)
+{
+	VkPhysicalDeviceProperties vk_gpuProperties;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &vk_gpuProperties);
+	uint32_t queueFamilyPropertiesCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(vk_graphicsCard, &queueFamilyPropertiesCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertiesCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(vk_graphicsCard, &queueFamilyPropertiesCount, queueFamilyProperties.data());
+
+	//Without valid timestamp bits on the queue the profiler stays disabled and all of its functions do nothing
+	uint32_t timestampValidBits = queueFamilyProperties[queueFamilyIndex].timestampValidBits;
+	m_enabled = timestampValidBits != 0;
+	if (!m_enabled)
+	{
+		return;
+	}
+	m_timestampPeriod = vk_gpuProperties.limits.timestampPeriod;
+	m_timestampMask = timestampValidBits >= 64 ? UINT64_MAX : ((uint64_t(1) << timestampValidBits) - 1);
+	m_pipelineStatisticsEnabled = pipelineStatistics;
+
+	VkQueryPoolCreateInfo vk_timestampPoolInfo{};
+	vk_timestampPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	vk_timestampPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	//Each scope writes one timestamp when it begins and one when it ends
+	vk_timestampPoolInfo.queryCount = GPU_PROFILER_MAX_SCOPES * 2;
+
+	VkQueryPoolCreateInfo vk_statisticsPoolInfo{};
+	vk_statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	vk_statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	vk_statisticsPoolInfo.queryCount = 1;
+	vk_statisticsPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+	//Every slot of the frame ring gets its own query pools so that results are read back without waiting on the GPU
+	m_frames.resize(framesInFlight);
+	for (ProfilerFrameQueries& frame : m_frames)
+	{
+		if (vkCreateQueryPool(vk_device, &vk_timestampPoolInfo, nullptr, &frame.vk_timestampPool) != VK_SUCCESS)
+		{
+			__debugbreak();
+		}
+		if (m_pipelineStatisticsEnabled && 
+			vkCreateQueryPool(vk_device, &vk_statisticsPoolInfo, nullptr, &frame.vk_statisticsPool) != VK_SUCCESS)
+		{
+			__debugbreak();
+		}
+		frame.scopes.reserve(GPU_PROFILER_MAX_SCOPES);
+	}
+}
+
+void VulkanGpuProfiler::BeginFrame(const VkDevice& vk_device, const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex)
+{
+	if (!m_enabled)
+	{
+		return;
+	}
+	ProfilerFrameQueries& frame = m_frames[frameIndex];
+
+	/* This is called after the fence of the slot has been waited on, so the queries that were written the last time the slot 
+	   was used are already available. Reading them here means the results lag one trip around the ring behind */
+	CollectFrameResults(vk_device, frame);
+
+	vkCmdResetQueryPool(vk_commandBuffer, frame.vk_timestampPool, 0, GPU_PROFILER_MAX_SCOPES * 2);
+	if (m_pipelineStatisticsEnabled)
+	{
+		vkCmdResetQueryPool(vk_commandBuffer, frame.vk_statisticsPool, 0, 1);
+	}
+	frame.scopes.clear();
+	frame.statisticsWritten = false;
+}
+
+void VulkanGpuProfiler::CollectFrameResults(const VkDevice& vk_device, ProfilerFrameQueries& frame)
+{
+	if (!frame.scopes.empty())
+	{
+		uint64_t timestamps[GPU_PROFILER_MAX_SCOPES * 2];
+		uint32_t queryCount = static_cast<uint32_t>(frame.scopes.size()) * 2;
+		//No wait flag, if the results are not available for some reason the frame is skipped instead of stalling
+		VkResult vk_queryResult = vkGetQueryPoolResults(vk_device, frame.vk_timestampPool, 0, queryCount, sizeof(timestamps),
+			timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (vk_queryResult == VK_SUCCESS)
+		{
+			for (uint32_t i = 0; i < frame.scopes.size(); ++i)
+			{
+				uint64_t ticks = ((timestamps[i * 2 + 1] - timestamps[i * 2]) & m_timestampMask);
+				double milliseconds = static_cast<double>(ticks) * m_timestampPeriod / 1000000.0;
+				AddScopeSample(m_scopes[frame.scopes[i]], milliseconds);
+			}
+		}
+	}
+
+	if (frame.statisticsWritten)
+	{
+		uint64_t statistics[4];
+		if (vkGetQueryPoolResults(vk_device, frame.vk_statisticsPool, 0, 1, sizeof(statistics), statistics, 
+			sizeof(statistics), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+		{
+			//The results are written in the order of the statistic bits, from the lowest bit to the highest
+			m_lastPipelineStatistics.inputAssemblyPrimitives = statistics[0];
+			m_lastPipelineStatistics.vertexShaderInvocations = statistics[1];
+			m_lastPipelineStatistics.clippingPrimitives = statistics[2];
+			m_lastPipelineStatistics.fragmentShaderInvocations = statistics[3];
+		}
+	}
+}
+
+uint32_t VulkanGpuProfiler::BeginScope(const VkCommandBuffer& vk_commandBuffer, const char* scopeName, uint32_t frameIndex)
+{
+	if (!m_enabled || m_frames[frameIndex].scopes.size() == GPU_PROFILER_MAX_SCOPES)
+	{
+		return UINT32_MAX;
+	}
+	ProfilerFrameQueries& frame = m_frames[frameIndex];
+
+	//Finding the history of the scope by its name, scopes are few so a linear search is enough
+	uint32_t scopeId = 0;
+	while (scopeId < m_scopes.size() && m_scopes[scopeId].name != scopeName)
+	{
+		++scopeId;
+	}
+	if (scopeId == m_scopes.size())
+	{
+		GpuScopeHistory scope{};
+		scope.name = scopeName;
+		scope.samples.resize(GPU_PROFILER_HISTORY_SIZE);
+		m_scopes.push_back(scope);
+	}
+
+	uint32_t scopeSlot = static_cast<uint32_t>(frame.scopes.size());
+	frame.scopes.push_back(scopeId);
+	vkCmdWriteTimestamp(vk_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.vk_timestampPool, scopeSlot * 2);
+	return scopeSlot;
+}
+
+void VulkanGpuProfiler::EndScope(const VkCommandBuffer& vk_commandBuffer, uint32_t scopeSlot, uint32_t frameIndex)
+{
+	if (scopeSlot == UINT32_MAX)
+	{
+		return;
+	}
+	vkCmdWriteTimestamp(vk_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_frames[frameIndex].vk_timestampPool, 
+		scopeSlot * 2 + 1);
+}
+
+void VulkanGpuProfiler::BeginPipelineStatistics(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex)
+{
+	if (m_enabled && m_pipelineStatisticsEnabled)
+	{
+		vkCmdBeginQuery(vk_commandBuffer, m_frames[frameIndex].vk_statisticsPool, 0, 0);
+	}
+}
+
+void VulkanGpuProfiler::EndPipelineStatistics(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex)
+{
+	if (m_enabled && m_pipelineStatisticsEnabled)
+	{
+		vkCmdEndQuery(vk_commandBuffer, m_frames[frameIndex].vk_statisticsPool, 0);
+		m_frames[frameIndex].statisticsWritten = true;
+	}
+}
+
+void VulkanGpuProfiler::AddScopeSample(GpuScopeHistory& scope, double milliseconds)
+{
+	scope.samples[scope.nextSample] = milliseconds;
+	scope.nextSample = (scope.nextSample + 1) % GPU_PROFILER_HISTORY_SIZE;
+	scope.sampleCount = std::min(scope.sampleCount + 1, GPU_PROFILER_HISTORY_SIZE);
+	scope.lastSample = milliseconds;
+	++scope.totalSampleCount;
+}
+
+bool VulkanGpuProfiler::GetLastScopeSample(const char* scopeName, double& milliseconds, uint64_t& readbackCount) const
+{
+	for (const GpuScopeHistory& scope : m_scopes)
+	{
+		if (scope.name == scopeName && scope.totalSampleCount)
+		{
+			milliseconds = scope.lastSample;
+			readbackCount = scope.totalSampleCount;
+			return true;
+		}
+	}
+	return false;
+}
+
+void VulkanGpuProfiler::GetScopeStatistics(std::vector<GpuScopeStatistics>& scopeStatistics) const
+{
+	scopeStatistics.clear();
+	std::vector<double> sortedSamples;
+	for (const GpuScopeHistory& scope : m_scopes)
+	{
+		if (!scope.sampleCount)
+		{
+			continue;
+		}
+		//The statistics are computed over the rolling window of the most recent samples
+		sortedSamples.assign(scope.samples.begin(), scope.samples.begin() + scope.sampleCount);
+		std::sort(sortedSamples.begin(), sortedSamples.end());
+		double sum = 0.0;
+		for (double sample : sortedSamples)
+		{
+			sum += sample;
+		}
+
+		GpuScopeStatistics statistics{};
+		statistics.name = scope.name;
+		statistics.sampleCount = scope.sampleCount;
+		statistics.lastMs = scope.lastSample;
+		statistics.minMs = sortedSamples.front();
+		statistics.avgMs = sum / sortedSamples.size();
+		statistics.p50Ms = sortedSamples[(sortedSamples.size() - 1) * 50 / 100];
+		statistics.p95Ms = sortedSamples[(sortedSamples.size() - 1) * 95 / 100];
+		statistics.p99Ms = sortedSamples[(sortedSamples.size() - 1) * 99 / 100];
+		scopeStatistics.push_back(statistics);
+	}
+}
+
+bool VulkanGpuProfiler::DumpCsv(const char* filename) const
+{
+	std::ofstream csvFile(filename, std::ios::trunc);
+	if (!csvFile.is_open())
+	{
+		return false;
+	}
+
+	std::vector<GpuScopeStatistics> scopeStatistics;
+	GetScopeStatistics(scopeStatistics);
+	csvFile << "scope,samples,last_ms,min_ms,avg_ms,p50_ms,p95_ms,p99_ms\n";
+	for (const GpuScopeStatistics& statistics : scopeStatistics)
+	{
+		csvFile << statistics.name << ',' << statistics.sampleCount << ',' << statistics.lastMs << ',' << statistics.minMs <<
+			',' << statistics.avgMs << ',' << statistics.p50Ms << ',' << statistics.p95Ms << ',' << statistics.p99Ms << '\n';
+	}
+	return static_cast<bool>(csvFile);
+}
+
+void VulkanGpuProfiler::Cleanup(const VkDevice& vk_device)
+{
+	for (ProfilerFrameQueries& frame : m_frames)
+	{
+		vkDestroyQueryPool(vk_device, frame.vk_timestampPool, nullptr);
+		vkDestroyQueryPool(vk_device, frame.vk_statisticsPool, nullptr);
+	}
+	m_frames.clear();
+	m_enabled = false;
+}
\ No newline at end of file
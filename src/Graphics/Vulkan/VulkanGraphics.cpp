@@ -1,42 +1,98 @@
 #include "VulkanGraphics.h"
-
+#include "VulkanShaderRegistry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+//Returns the milliseconds that have passed since the time point passed, used to measure the phases of initialization
+static double MillisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
 
 VulkanGraphics::VulkanGraphics()
 	:vk_instance(), vk_surface(), vk_graphicsCard(VK_NULL_HANDLE), m_gpuQueueFamilies(), m_gpuSwapchainSupport(),
-	requiredDeviceExtensions(), vk_device(), vk_graphicsQueue(), vk_presentQueue(), vk_swapchain(), swapchainImages(),
-	vk_imageFormat(), vk_imageExtent(), imageViews(), vk_pipelineLayout(), vk_renderPass(),vk_graphicsPipeline(),
-	framebuffers(), vk_commandPool(), vk_commandBuffer(), m_syncObjects()
+	m_graphicsCardOverride(), requiredDeviceExtensions(), vk_device(), vk_graphicsQueue(), vk_presentQueue(), 
+	vk_transferQueue(), m_memoryAllocator(), 
+	vk_swapchain(), 
+	swapchainImages(),
+	vk_imageFormat(), vk_imageExtent(), vk_surfaceFormat(), vk_swapchainPresentMode(), 
+	m_framePacing({ VK_PRESENT_MODE_MAILBOX_KHR, 0, 0.0, false }), m_nextFrameDeadline(), m_waitedForFrame(false), 
+	m_physicalDeviceProperties2Enabled(false), m_presentIdFeatures(), m_presentWaitFeatures(), 
+	m_descriptorIndexingFeatures(), vk_waitForPresent(nullptr), 
+	m_nextPresentId(1), m_lastPresentId(0), m_windowState(), m_windowResizeCount(0), m_swapchainOutdated(false), 
+	m_drawnContentVersion(0), m_drawnInstanceGeneration(0), m_drawnWindowDamageCount(0), m_redrawRequested(true), 
+	m_animating(false), m_headless(false), offscreenImageAllocations(), imageViews(), vk_pipelineLayout(), 
+	m_renderGraph(), m_renderTargetResource(0), m_mainRenderGraphPass(0), m_msaaSamples(VK_SAMPLE_COUNT_1_BIT), 
+	vk_graphicsPipeline(), m_initStart(), m_vertexShaderCode(), m_fragShaderCode(), m_cullingShaderCode(),
+	m_shaderDirectoryOverride(),
+	m_graphicsPipelineCompilation(), m_cullingPipelineCompilation(), m_pipelineCache(), 
+	m_pipelineCacheFilename("pipeline_cache.bin"), 
+	vk_commandPool(), m_syncObjects(), m_framesInFlight(DEFAULT_FRAMES_IN_FLIGHT), m_deletionQueue(), m_uploadQueue(), 
+	m_vertexFormat(VertexFormat::Quantized), m_vertexBuffer(), 
+	m_indexBuffer(), m_indexCount(0), m_meshUploadTicket(0), m_meshFile(), m_gpuProfiler(), 
+	m_gpuProfilingEnabled(true), m_pipelineStatisticsEnabled(false), m_instances(), m_instanceBuffers(), 
+	m_instanceBufferGenerations(), m_instanceCapacity(0), m_instanceGeneration(1), m_cullingPass(), 
+	m_gpuCullingEnabled(true), m_meshBoundingRadius(0.0f), vk_drawIndexedIndirectCount(nullptr), 
+	m_frameConstants(), m_drawConstants({ { 0.0f, 0.0f, 1.0f, 1.0f }, DEFAULT_BINDLESS_BUFFER }), 
+	m_frameUniforms({ { 1.0f, 1.0f, 1.0f, 1.0f } }), m_recordedMesh(), m_bindlessResources(), 
+	m_defaultMaterialBuffer(), m_materialBuffers(), 
+	m_recordingWorkers(),
+	m_recordingThreadCount(0), m_instancesPerDraw(0), m_recordedSecondaryCommandBuffers(), m_lastRecordingMs(0.0), 
+	m_staticCommandBuffersEnabled(false), m_staticCommandBuffers(), m_staticCommandBufferVersions(), 
+	m_staticContentVersion(1), m_staticContentIndexCount(0),
+	m_enabledFeatures(), m_startupTimings()
 {
 	
 }
 
 VulkanGraphics::~VulkanGraphics()
 {
-	vkDestroyCommandPool(vk_device, vk_commandPool, nullptr);
-	for (uint32_t i = 0; i < framebuffers.size(); ++i)
+	//The handles are owned by their wrappers, but they need to be destroyed before the device they were created with
+	vk_commandPool.Reset();
+	vk_graphicsPipeline.Reset();
+	//The render graph frees the memory of its transient attachments, so it goes before the memory allocator
+	m_renderGraph.Cleanup();
+	vk_pipelineLayout.Reset();
+	imageViews.clear();
+	if (m_headless)
 	{
-		vkDestroyFramebuffer(vk_device, framebuffers[i], nullptr);
+		//The offscreen render targets are owned by the application instead of a swapchain
+		for (uint32_t i = 0; i < swapchainImages.size(); ++i)
+		{
+			vkDestroyImage(vk_device, swapchainImages[i], nullptr);
+			m_memoryAllocator.Free(offscreenImageAllocations[i]);
+		}
+		m_memoryAllocator.Cleanup();
+		vkDestroyDevice(vk_device, nullptr);
 	}
-	vkDestroyPipeline(vk_device, vk_graphicsPipeline, nullptr);
-	vkDestroyRenderPass(vk_device, vk_renderPass, nullptr);
-	vkDestroyPipelineLayout(vk_device, vk_pipelineLayout, nullptr);
-	for (uint32_t i = 0; i < imageViews.size(); ++i)
+	else
 	{
-		vkDestroyImageView(vk_device, imageViews[i], nullptr);
+		vk_swapchain.Reset();
+		m_memoryAllocator.Cleanup();
+		vkDestroyDevice(vk_device, nullptr);
+		vkDestroySurfaceKHR(vk_instance, vk_surface, nullptr);
 	}
-	vkDestroySwapchainKHR(vk_device, vk_swapchain, nullptr);
-	vkDestroyDevice(vk_device, nullptr);
-	vkDestroySurfaceKHR(vk_instance, vk_surface, nullptr);
 	vkDestroyInstance(vk_instance, nullptr);
 }
 
 void VulkanGraphics::Init(const WindowHandle& window)
 {
+	m_headless = false;
+	std::chrono::steady_clock::time_point initStart = std::chrono::steady_clock::now();
+	m_initStart = initStart;
+	StartShaderLoads();
+
 	//Initializing an instance first so that the application can interface with the vulkan API
 	VkInstanceCreateInfo vk_instanceInfo{};
 	VkApplicationInfo vk_appInfo{};
 	CreateAppDefaultVkInstanceInfo(vk_instanceInfo, vk_appInfo);
-	CreateVulkanInstance(&vk_instance, vk_instanceInfo);
+	//The window system decides which instance extensions are needed to create a surface
+	std::vector<const char*> requiredInstanceExtensions;
+	window.GetRequiredVulkanInstanceExtensions(requiredInstanceExtensions);
+	AddOptionalInstanceExtensions(requiredInstanceExtensions);
+	CreateVulkanInstance(&vk_instance, vk_instanceInfo, requiredInstanceExtensions);
 
 	//Creating the surface so that vulkan can interface with the window system
 	CreateVulkanSurface(vk_instance, window, vk_surface);
@@ -44,7 +100,8 @@ void VulkanGraphics::Init(const WindowHandle& window)
 	//Picking a physical device/graphics card for Vulkan to interface with
 	requiredDeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
 	PickPhysicalDevice(vk_instance, vk_surface, vk_graphicsCard, m_gpuQueueFamilies, 
-		requiredDeviceExtensions, m_gpuSwapchainSupport);
+		requiredDeviceExtensions, m_gpuSwapchainSupport, m_graphicsCardOverride, m_physicalDeviceProperties2Enabled);
+	AddOptionalDeviceExtensions();
 
 	//Creating the VkDevice(logical device) object that will interface with the physical device we picked earlier
 	VkDeviceCreateInfo vk_deviceInfo{};
@@ -54,26 +111,193 @@ void VulkanGraphics::Init(const WindowHandle& window)
 	//Retrieving the queue from the device object based on the queue family indices we got from the physical device
 	vkGetDeviceQueue(vk_device, m_gpuQueueFamilies.graphics, 0, &vk_graphicsQueue);
 	vkGetDeviceQueue(vk_device, m_gpuQueueFamilies.present, 0, &vk_presentQueue);
+	vkGetDeviceQueue(vk_device, m_gpuQueueFamilies.transfer, 0, &vk_transferQueue);
+	//Present wait is only loaded if both of its features were enabled on the device
+	if (m_presentWaitFeatures.presentWait)
+	{
+		vk_waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(vk_device, "vkWaitForPresentKHR"));
+	}
+	m_memoryAllocator.Init(vk_device, vk_graphicsCard);
+	m_deletionQueue.Init(vk_device, m_memoryAllocator, m_framesInFlight);
+	m_startupTimings.deviceCreation = MillisecondsSince(initStart);
 
-	//Creating the swapchain that will own the framebuffers that will later be presented on screen
-	VkSurfaceFormatKHR vk_surfaceFormat{};
+	/* The surface format is chosen once. The present mode is chosen every time the swapchain is created, since the frame 
+	   pacing can change it */
 	ChooseVulkanSurfaceFormat(vk_surfaceFormat, m_gpuSwapchainSupport.surfaceFormats);
-	VkPresentModeKHR vk_swapchainPresentMode{};
-	ChooseVulkanSwapchainPresentMode(vk_swapchainPresentMode, m_gpuSwapchainSupport.presentModes);
-	VkExtent2D vk_swapchainExtent{};
-	ChooseVulkanSwapchainExtent(vk_swapchainExtent, m_gpuSwapchainSupport.surfaceCapabilities,
-		window.GetWidth(), window.GetHeight());
-	vk_imageExtent = vk_swapchainExtent;
 	vk_imageFormat = vk_surfaceFormat.format;
+
+	//The render pass only needs the format, so the pipelines can compile while the swapchain is being created
+	std::chrono::steady_clock::time_point pipelineStart = std::chrono::steady_clock::now();
+	CreateGraphicsPipelineObjects();
+	m_startupTimings.pipelineCreation = MillisecondsSince(pipelineStart);
+
+	std::chrono::steady_clock::time_point renderTargetStart = std::chrono::steady_clock::now();
+	m_windowState = window.GetState();
+	m_windowResizeCount = m_windowState.resizeCount;
+	m_drawnWindowDamageCount = m_windowState.damageCount;
+	CreateSwapchain();
+	CreateRenderTargetImageViews();
+	m_startupTimings.renderTargetCreation = MillisecondsSince(renderTargetStart);
+
+	CreateFramebuffers();
+	CreateCommandObjects();
+	CreateDefaultMesh();
+	m_startupTimings.total = MillisecondsSince(initStart);
+}
+
+void VulkanGraphics::InitHeadless(uint32_t width, uint32_t height)
+{
+	m_headless = true;
+	std::chrono::steady_clock::time_point initStart = std::chrono::steady_clock::now();
+	m_initStart = initStart;
+	StartShaderLoads();
+
+	//The instance does not need any window system extensions, since nothing will be presented
+	VkInstanceCreateInfo vk_instanceInfo{};
+	VkApplicationInfo vk_appInfo{};
+	CreateAppDefaultVkInstanceInfo(vk_instanceInfo, vk_appInfo);
+	std::vector<const char*> requiredInstanceExtensions;
+	AddOptionalInstanceExtensions(requiredInstanceExtensions);
+	CreateVulkanInstance(&vk_instance, vk_instanceInfo, requiredInstanceExtensions);
+
+	//Without a surface the graphics card only needs to support graphics commands
+	requiredDeviceExtensions.clear();
+	PickHeadlessPhysicalDevice(vk_instance, vk_graphicsCard, m_gpuQueueFamilies, requiredDeviceExtensions, 
+		m_graphicsCardOverride, m_physicalDeviceProperties2Enabled);
+	AddOptionalDeviceExtensions();
+
+	VkDeviceCreateInfo vk_deviceInfo{};
+	std::vector<VkDeviceQueueCreateInfo> queueInfos;
+	CreateAppDefaultVkDeviceInfo(vk_deviceInfo, m_gpuQueueFamilies, requiredDeviceExtensions, queueInfos);
+	CreateVulkanLogicalDevice(vk_device, vk_deviceInfo, vk_graphicsCard);
+	vkGetDeviceQueue(vk_device, m_gpuQueueFamilies.graphics, 0, &vk_graphicsQueue);
+	vk_presentQueue = vk_graphicsQueue;
+	vkGetDeviceQueue(vk_device, m_gpuQueueFamilies.transfer, 0, &vk_transferQueue);
+	m_memoryAllocator.Init(vk_device, vk_graphicsCard);
+	m_deletionQueue.Init(vk_device, m_memoryAllocator, m_framesInFlight);
+	m_startupTimings.deviceCreation = MillisecondsSince(initStart);
+
+	vk_imageExtent = { width, height };
+	vk_imageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	//The pipelines compile on worker threads while the offscreen render targets are being created
+	std::chrono::steady_clock::time_point pipelineStart = std::chrono::steady_clock::now();
+	CreateGraphicsPipelineObjects();
+	m_startupTimings.pipelineCreation = MillisecondsSince(pipelineStart);
+
+	std::chrono::steady_clock::time_point renderTargetStart = std::chrono::steady_clock::now();
+	CreateOffscreenRenderTargets();
+	CreateRenderTargetImageViews();
+	m_startupTimings.renderTargetCreation = MillisecondsSince(renderTargetStart);
+
+	CreateFramebuffers();
+	CreateCommandObjects();
+	CreateDefaultMesh();
+	m_startupTimings.total = MillisecondsSince(initStart);
+}
+
+void VulkanGraphics::CreateSwapchain()
+{
+	//Creating the swapchain that will own the framebuffers that will later be presented on screen
+	ChooseVulkanSwapchainExtent(vk_imageExtent, m_gpuSwapchainSupport.surfaceCapabilities,
+		m_windowState.width, m_windowState.height);
+	ChooseVulkanSwapchainPresentMode(vk_swapchainPresentMode, m_gpuSwapchainSupport.presentModes, 
+		m_framePacing.vk_presentMode);
 	VkSwapchainCreateInfoKHR vk_swapchainInfo{};
-	CreateAppDefaultVkSwapchainInfo(vk_swapchainInfo, vk_surfaceFormat, vk_swapchainExtent, vk_swapchainPresentMode);
-	CreateVulkanSwapchain(vk_swapchain, vk_device, vk_swapchainInfo);
+	CreateAppDefaultVkSwapchainInfo(vk_swapchainInfo, vk_surfaceFormat, vk_imageExtent, vk_swapchainPresentMode);
+	/* When recreating, the old swapchain is passed in the info so its resources can be recycled. It is retired afterwards,
+	   since the frames in flight may still be presenting its images */
+	VkSwapchainKHR vk_newSwapchain;
+	CreateVulkanSwapchain(vk_newSwapchain, vk_device, vk_swapchainInfo);
+	m_deletionQueue.Retire(std::move(vk_swapchain));
+	vk_swapchain = VulkanSwapchainHandle(vk_device, vk_newSwapchain);
+	//The ids of the presents to the old swapchain can't be waited on with the new one
+	m_lastPresentId = 0;
+
 	//After creating the swapchain, we retrieve the swapchain image handles from it
 	uint32_t swapchainImageCount;
 	vkGetSwapchainImagesKHR(vk_device, vk_swapchain, &swapchainImageCount, nullptr);
 	swapchainImages.resize(swapchainImageCount);
 	vkGetSwapchainImagesKHR(vk_device, vk_swapchain, &swapchainImageCount, swapchainImages.data());
-	//Now that we have the swapchain images, we resize the image view array so that each image view correlates to a VkImage
+}
+
+bool VulkanGraphics::RecreateSwapchain()
+{
+	m_windowResizeCount = m_windowState.resizeCount;
+	//A minimized window can't have a swapchain, it will be recreated once the window is restored
+	if (m_windowState.IsMinimized())
+	{
+		m_swapchainOutdated = true;
+		return false;
+	}
+
+	/* Only the frames in flight can still be using the framebuffers, attachments and image views, so they are retired and 
+	   destroyed once those frames are done instead of waiting for them. The pipeline (which uses dynamic viewport and 
+	   scissor), the render passes and the command pool do not depend on the extent and are kept alive */
+	m_renderGraph.ReleaseAttachments(m_deletionQueue);
+	m_deletionQueue.Retire(imageViews);
+
+	//The surface capabilities hold the new extent of the surface
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(vk_graphicsCard, vk_surface, &m_gpuSwapchainSupport.surfaceCapabilities);
+	CreateSwapchain();
+	CreateRenderTargetImageViews();
+	CreateFramebuffers();
+
+	//The new swapchain can have a different amount of images, and none of them is being rendered to yet
+	m_syncObjects.imagesInFlight.assign(swapchainImages.size(), VK_NULL_HANDLE);
+	//The static command buffers were recorded with the old extent and framebuffers
+	if (m_staticCommandBuffersEnabled)
+	{
+		AllocateStaticCommandBuffers();
+	}
+	m_swapchainOutdated = false;
+	//The new images hold nothing yet, even if the content did not change
+	m_redrawRequested = true;
+	return true;
+}
+
+void VulkanGraphics::WaitForFramesInFlight()
+{
+	std::vector<VkFence> frameFences;
+	for (const FrameInFlightData& frame : m_syncObjects.frames)
+	{
+		frameFences.push_back(frame.vk_framesInFlightFence);
+	}
+	vkWaitForFences(vk_device, static_cast<uint32_t>(frameFences.size()), frameFences.data(), VK_TRUE, UINT64_MAX);
+	m_deletionQueue.Flush();
+}
+
+void VulkanGraphics::CreateOffscreenRenderTargets()
+{
+	/* Each slot of the frame ring gets its own render target, so that the GPU can render a frame into one image
+	   while the CPU is recording the next frame for a different one */
+	VkImageCreateInfo vk_imageInfo{};
+	vk_imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	vk_imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	vk_imageInfo.format = vk_imageFormat;
+	vk_imageInfo.extent = { vk_imageExtent.width, vk_imageExtent.height, 1 };
+	vk_imageInfo.mipLevels = 1;
+	vk_imageInfo.arrayLayers = 1;
+	vk_imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	vk_imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	//The results can be copied out of the image after rendering, to be written to disk for example
+	vk_imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	vk_imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	vk_imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	swapchainImages.resize(m_framesInFlight);
+	offscreenImageAllocations.resize(m_framesInFlight);
+	for (uint32_t i = 0; i < swapchainImages.size(); ++i)
+	{
+		//Render targets are large and live as long as the application, so they get dedicated allocations
+		CreateVulkanImage(swapchainImages[i], offscreenImageAllocations[i], vk_imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			true, vk_device, m_memoryAllocator);
+	}
+}
+
+void VulkanGraphics::CreateRenderTargetImageViews()
+{
+	//Now that we have the render target images, we resize the image view array so that each image view correlates to a VkImage
 	imageViews.resize(swapchainImages.size());
 
 	/*Creating a base VkImageViewCreateInfo for the application that will be used to create the image views. The image views
@@ -81,7 +305,7 @@ void VulkanGraphics::Init(const WindowHandle& window)
 	VkImageViewCreateInfo vk_imageViewInfo{};
 	vk_imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	vk_imageViewInfo.format = vk_imageFormat;
-	vk_imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
+	vk_imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
 	//Describes what the image's purpose is and which part of the image should be accessed
 	vk_imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	vk_imageViewInfo.subresourceRange.baseMipLevel = 0;
@@ -95,33 +319,167 @@ void VulkanGraphics::Init(const WindowHandle& window)
 	vk_imageViewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
 	for (uint32_t i = 0; i < swapchainImages.size(); ++i)
 	{
-		
+		VkImageView vk_imageView;
 		vk_imageViewInfo.image = swapchainImages[i];
-		CreateVulkanSwapchainImageViews(imageViews[i], vk_imageViewInfo, vk_device);
+		CreateVulkanSwapchainImageViews(vk_imageView, vk_imageViewInfo, vk_device);
+		imageViews[i] = VulkanImageViewHandle(vk_device, vk_imageView);
 	}
+}
+
+void VulkanGraphics::CreateGraphicsPipelineObjects()
+{
+	//Loading the pipeline cache from the previous launch, so that the driver can skip compiling pipelines it has seen before
+	m_pipelineCache.CreatePipelineCache(vk_device, vk_graphicsCard, m_pipelineCacheFilename.c_str());
+
+	//The pipeline layout takes the descriptor set layout of the frame constants, so they need to exist first
+	m_frameConstants.Init(vk_device, vk_graphicsCard, m_memoryAllocator, m_framesInFlight, DEFAULT_FRAME_CONSTANTS_SIZE,
+		sizeof(FrameUniforms));
+	//The default material leaves the colors of the mesh as they are
+	MaterialData defaultMaterial{ { 1.0f, 1.0f, 1.0f, 1.0f } };
+	CreateVulkanBuffer(m_defaultMaterialBuffer, sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		VulkanAllocationStrategy::Buddy, vk_device, m_memoryAllocator);
+	std::memcpy(m_defaultMaterialBuffer.allocation.mappedData, &defaultMaterial, sizeof(MaterialData));
+	m_bindlessResources.Init(vk_device, vk_instance, vk_graphicsCard, m_descriptorIndexingFeatures.descriptorBindingPartiallyBound,
+		m_framesInFlight, m_defaultMaterialBuffer.vk_buffer);
 
 	//Creating the pipeline layout object to pass to the pipeline object later and to pass uniform variables when needed
 	VkPipelineLayoutCreateInfo vk_pipelineLayoutInfo{};
-	CreateAppDefaultPipelineLayoutInfo(vk_pipelineLayoutInfo);
-	CreateVulkanGraphicsPipelineLayout(vk_pipelineLayoutInfo, vk_device, vk_pipelineLayout);
-
-	//Creating the render pass that will later be passed into the graphics pipeline to specify the framebuffer attachments
-	VkAttachmentDescription vk_attachmentInfo{};
-	VkAttachmentReference vk_attachmentRef{};
-	VkSubpassDescription vk_subpassInfo{};
-	VkRenderPassCreateInfo vk_renderPassInfo{};
-	VkSubpassDependency vk_dependencyInfo{};
-	CreateAppDefaultRenderPassInfo(vk_renderPassInfo, vk_attachmentInfo, vk_attachmentRef, 
-		vk_subpassInfo, vk_dependencyInfo);
-	CreateVulkanRenderPass(vk_renderPass, vk_renderPassInfo, vk_device);
-
-	//Reading the vertex and shader filenames
-	const char* vertexShaderFilename = "Shaders/vert.spv";
-	std::vector<char> vertexShaderCode;
-	ReadShaderFile(vertexShaderCode, vertexShaderFilename);
-	const char* fragShaderFilename = "Shaders/frag.spv";
-	std::vector<char> fragShaderCode;
-	ReadShaderFile(fragShaderCode, fragShaderFilename);
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	VkPushConstantRange vk_pushConstantRange{};
+	CreateAppDefaultPipelineLayoutInfo(vk_pipelineLayoutInfo, setLayouts, vk_pushConstantRange);
+	VkPipelineLayout vk_newPipelineLayout;
+	CreateVulkanGraphicsPipelineLayout(vk_pipelineLayoutInfo, vk_device, vk_newPipelineLayout);
+	vk_pipelineLayout = VulkanPipelineLayoutHandle(vk_device, vk_newPipelineLayout);
+
+	//Compiling the render graph creates the render pass of the main pass, which the graphics pipeline is compiled against
+	BuildRenderGraph();
+
+	/* The graphics pipeline is compiled on its own thread. The pipeline cache is internally synchronized, so the pipelines
+	   can share it while they compile concurrently */
+	m_graphicsPipelineCompilation = std::async(std::launch::async, &VulkanGraphics::CompileGraphicsPipeline, this);
+
+	/* The culling pre-pass creates its buffers here, since the memory allocator is only used from the main thread, and its 
+	   compute pipeline compiles on a thread of its own */
+	if (m_gpuCullingEnabled)
+	{
+		m_cullingPass.Init(vk_device, m_memoryAllocator, m_framesInFlight);
+		m_cullingPipelineCompilation = std::async(std::launch::async, [this]()
+			{
+				ShaderCode cullingShaderCode = m_cullingShaderCode.get();
+				CompiledPipeline compiledPipeline{};
+				compiledPipeline.shadersLoaded = MillisecondsSince(m_initStart);
+				compiledPipeline.vk_pipeline = m_cullingPass.CompilePipeline(m_pipelineCache.vk_pipelineCache, 
+					cullingShaderCode);
+				compiledPipeline.ready = MillisecondsSince(m_initStart);
+				return compiledPipeline;
+			});
+
+		//The function of the count variant of the indirect draw is only loaded if its extension was enabled on the device
+		bool drawIndirectCountEnabled = std::any_of(requiredDeviceExtensions.begin(), requiredDeviceExtensions.end(),
+			[](const char* extension) { return !strcmp(extension, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME); });
+		if (drawIndirectCountEnabled)
+		{
+			vk_drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+				vkGetDeviceProcAddr(vk_device, "vkCmdDrawIndexedIndirectCountKHR"));
+		}
+	}
+}
+
+void VulkanGraphics::BuildRenderGraph()
+{
+	m_renderGraph.Init(vk_device, m_memoryAllocator);
+
+	/* The render target is presented at the end of the frame, or copied out of when the application is headless. Its first
+	   use waits for the stage that the semaphore of the acquired swapchain image is waited on with */
+	RenderGraphImageInfo renderTargetInfo{ vk_imageFormat, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+	m_renderTargetResource = m_renderGraph.ImportImage("RenderTarget", renderTargetInfo, 
+		m_headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	//Each frame slot has its own culling buffers, the graph only orders the accesses to them within a frame
+	uint32_t drawArguments = m_renderGraph.ImportBuffer("DrawArguments");
+	uint32_t visibleInstances = m_renderGraph.ImportBuffer("VisibleInstances");
+
+	uint32_t cullingPass = m_renderGraph.AddPass("Culling", false, 
+		[this](const RenderGraphPassContext& context) { RecordCullingPass(context); });
+	m_renderGraph.Use(cullingPass, drawArguments, RenderGraphAccess::ComputeShaderWrite);
+	m_renderGraph.Use(cullingPass, visibleInstances, RenderGraphAccess::ComputeShaderWrite);
+
+	//The sample count is lowered to the highest one below it that the graphics card can render color attachments with
+	VkPhysicalDeviceProperties vk_gpuProperties;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &vk_gpuProperties);
+	while (m_msaaSamples > VK_SAMPLE_COUNT_1_BIT && !(vk_gpuProperties.limits.framebufferColorSampleCounts & m_msaaSamples))
+	{
+		m_msaaSamples = static_cast<VkSampleCountFlagBits>(m_msaaSamples >> 1);
+	}
+
+	/* For each new frame the render target is cleared to black before rendering. With multisampling the pass draws into a 
+	   multisampled image instead, which is resolved into the render target at the end of the subpass. Since nothing uses 
+	   the samples afterwards they are not stored, so the graph makes the image a lazily allocated transient attachment 
+	   that tiled graphics cards can keep in tile memory */
+	m_mainRenderGraphPass = m_renderGraph.AddPass("Main", true,
+		[this](const RenderGraphPassContext& context) { RecordMainPass(context); });
+	m_renderGraph.Use(m_mainRenderGraphPass, m_renderTargetResource, RenderGraphAccess::ColorAttachment);
+	VkClearValue vk_clearValue{ {{0.0f, 0.0f, 0.0f, 1.0f}} };
+	if (m_msaaSamples > VK_SAMPLE_COUNT_1_BIT)
+	{
+		RenderGraphImageInfo msaaColorInfo{ vk_imageFormat, m_msaaSamples, VK_IMAGE_ASPECT_COLOR_BIT };
+		uint32_t msaaColor = m_renderGraph.AddTransientImage("MsaaColor", msaaColorInfo);
+		m_renderGraph.Use(m_mainRenderGraphPass, msaaColor, RenderGraphAccess::ColorAttachment);
+		m_renderGraph.ClearAttachment(m_mainRenderGraphPass, msaaColor, vk_clearValue);
+		m_renderGraph.ResolveAttachment(m_mainRenderGraphPass, msaaColor, m_renderTargetResource);
+	}
+	else
+	{
+		m_renderGraph.ClearAttachment(m_mainRenderGraphPass, m_renderTargetResource, vk_clearValue);
+	}
+	/* The split draws draw ranges of the instances, which the compacted instances of the culling pass don't map to. The
+	   static command buffers take precedence over them, like when the command objects are created */
+	bool drawsCulledInstances = m_gpuCullingEnabled && (m_staticCommandBuffersEnabled || !m_instancesPerDraw);
+	if (drawsCulledInstances)
+	{
+		m_renderGraph.Use(m_mainRenderGraphPass, drawArguments, RenderGraphAccess::IndirectCommandRead);
+		m_renderGraph.Use(m_mainRenderGraphPass, visibleInstances, RenderGraphAccess::VertexAttributeRead);
+	}
+	m_renderGraph.Compile();
+}
+
+void VulkanGraphics::StartShaderLoads()
+{
+	//The override passed by the application comes first, the environment can name a directory when the application doesn't
+	std::string shaderDirectory = m_shaderDirectoryOverride;
+	const char* environmentOverride = std::getenv(SHADER_DIRECTORY_OVERRIDE_VARIABLE);
+	if (shaderDirectory.empty() && environmentOverride)
+	{
+		shaderDirectory = environmentOverride;
+	}
+	m_vertexShaderCode = LoadShaderCode(APP_VERTEX_SHADER, shaderDirectory);
+	m_fragShaderCode = LoadShaderCode(APP_FRAGMENT_SHADER, shaderDirectory);
+	if (m_gpuCullingEnabled)
+	{
+		m_cullingShaderCode = LoadShaderCode(CULLING_SHADER, shaderDirectory);
+	}
+}
+
+std::future<ShaderCode> VulkanGraphics::LoadShaderCode(const EmbeddedShader& shader, const std::string& shaderDirectory)
+{
+	if (shaderDirectory.empty())
+	{
+		return std::async(std::launch::deferred, [&shader]()
+			{ ShaderCode shaderCode; shaderCode.embeddedWords = shader.words; shaderCode.embeddedWordCount = shader.wordCount; 
+			  return shaderCode; });
+	}
+	//Reading the file does not need vulkan, so it overlaps with creating the instance and the device
+	std::string filename = shaderDirectory + "/" + shader.filename;
+	return std::async(std::launch::async, [this, filename]()
+		{ ShaderCode shaderCode; ReadShaderFile(shaderCode.fileWords, filename.c_str()); return shaderCode; });
+}
+
+CompiledPipeline VulkanGraphics::CompileGraphicsPipeline()
+{
+	//Waiting for the reads that started with Init, they have usually finished by the time the render pass exists
+	ShaderCode vertexShaderCode = m_vertexShaderCode.get();
+	ShaderCode fragShaderCode = m_fragShaderCode.get();
 	//Creating the shader module wrappers that are needed to wrap around the shader code to be passed into the pipeline
 	VkShaderModule vk_vertexShaderModule;
 	VkShaderModule vk_fragShaderModule;
@@ -129,6 +487,16 @@ void VulkanGraphics::Init(const WindowHandle& window)
 	VkPipelineShaderStageCreateInfo vk_fragShaderStage{};
 	CreateShaderStages(vk_vertexShaderModule, vk_fragShaderModule, vk_vertexShaderStage, vk_fragShaderStage,
 		vertexShaderCode, fragShaderCode, vk_device);
+	//The pipeline keeps what it needs from the shader modules, so they are destroyed as soon as the compilation returns
+	VulkanShaderModuleHandle vertexShaderModule(vk_device, vk_vertexShaderModule);
+	VulkanShaderModuleHandle fragShaderModule(vk_device, vk_fragShaderModule);
+	//The size of the bindless buffer array depends on the graphics card, so the fragment shader gets it when it is compiled
+	uint32_t bindlessBufferCapacity = m_bindlessResources.GetBufferCapacity();
+	VkSpecializationMapEntry vk_specializationEntry{ 0, 0, sizeof(uint32_t) };
+	VkSpecializationInfo vk_specializationInfo{ 1, &vk_specializationEntry, sizeof(uint32_t), &bindlessBufferCapacity };
+	vk_fragShaderStage.pSpecializationInfo = &vk_specializationInfo;
+	CompiledPipeline compiledPipeline{};
+	compiledPipeline.shadersLoaded = MillisecondsSince(m_initStart);
 	VkPipelineShaderStageCreateInfo shaderStageInfos[] = { vk_vertexShaderStage, vk_fragShaderStage };
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vk_vertexShaderStage, vk_fragShaderStage };
 	//Specifying the dynamic state of the pipeline
@@ -153,85 +521,786 @@ void VulkanGraphics::Init(const WindowHandle& window)
 		vk_colorBlendAttachment, vk_colorBlendInfo, pipelineFixedState);
 	//Specifies the format of the vertex data that will be passed into the vertex shader
 	VkPipelineVertexInputStateCreateInfo vk_vertexInputInfo{};
-	CreateAppDefaultVkVertexInputInfo(vk_vertexInputInfo);
+	std::vector<VkVertexInputBindingDescription> vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+	CreateAppDefaultVkVertexInputInfo(vk_vertexInputInfo, vertexBindings, vertexAttributes);
 	//Creating the final pipeline info which will have pointer to all the other infos created for the pipeline
 	VkGraphicsPipelineCreateInfo vk_pipelineInfo{};
 	CreateAppDefaultVkPipelineInfo(vk_pipelineInfo, shaderStageInfos, vk_vertexInputInfo, pipelineFixedState,
 		vk_dynamicStateInfo);
-	CreateVulkanGraphicsPipeline(vk_graphicsPipeline, vk_pipelineInfo, vk_device);
+	CreateVulkanGraphicsPipeline(compiledPipeline.vk_pipeline, vk_pipelineInfo, vk_device, m_pipelineCache.vk_pipelineCache);
+	compiledPipeline.ready = MillisecondsSince(m_initStart);
+	return compiledPipeline;
+}
 
-	VkFramebufferCreateInfo vk_framebufferInfo{};
-	framebuffers.resize(imageViews.size());
-	for (uint32_t i = 0; i < framebuffers.size(); ++i)
+void VulkanGraphics::PublishCompiledPipelines(bool wait)
+{
+	std::chrono::seconds timeout(0);
+	if (m_graphicsPipelineCompilation.valid() && 
+		(wait || m_graphicsPipelineCompilation.wait_for(timeout) == std::future_status::ready))
 	{
-		CreateAppDefaultFramebufferInfo(vk_framebufferInfo, i);
-		CreateVulkanFramebuffer(framebuffers[i], vk_framebufferInfo, vk_device);
+		CompiledPipeline compiledPipeline = m_graphicsPipelineCompilation.get();
+		//The frames in flight may still be drawing with the pipeline that is replaced
+		m_deletionQueue.Retire(std::move(vk_graphicsPipeline));
+		vk_graphicsPipeline = VulkanPipelineHandle(vk_device, compiledPipeline.vk_pipeline);
+		m_startupTimings.shadersLoaded = compiledPipeline.shadersLoaded;
+		m_startupTimings.graphicsPipelineReady = compiledPipeline.ready;
+		//Static command buffers that were recorded without the pipeline, or with a previous one, need to bind the new one
+		MarkStaticContentDirty();
 	}
+	if (m_cullingPipelineCompilation.valid() && 
+		(wait || m_cullingPipelineCompilation.wait_for(timeout) == std::future_status::ready))
+	{
+		CompiledPipeline compiledPipeline = m_cullingPipelineCompilation.get();
+		m_deletionQueue.Retire(m_cullingPass.SetPipeline(VulkanPipelineHandle(vk_device, compiledPipeline.vk_pipeline)));
+		m_startupTimings.cullingPipelineReady = compiledPipeline.ready;
+		MarkStaticContentDirty();
+	}
+}
+
+void VulkanGraphics::WaitForPipelines()
+{
+	PublishCompiledPipelines(true);
+}
 
+void VulkanGraphics::CreateFramebuffers()
+{
+	//A frame renders to the render target image at its image index, through the framebuffers of the graph's passes
+	std::vector<VkImageView> renderTargetViews;
+	for (const VulkanImageViewHandle& imageView : imageViews)
+	{
+		renderTargetViews.push_back(imageView);
+	}
+	m_renderGraph.SetImportedImages(m_renderTargetResource, swapchainImages, renderTargetViews);
+	m_renderGraph.CreateAttachments(vk_imageExtent);
+}
+
+void VulkanGraphics::CreateCommandObjects()
+{
 	//Creating the command pool before the command buffers so that we can allocate them
 	VkCommandPoolCreateInfo vk_commandPoolInfo{};
 	CreateAppDefaultVkCommandPoolInfo(vk_commandPoolInfo, m_gpuQueueFamilies.graphics);
-	CreateVulkanCommandPool(vk_commandPool, vk_commandPoolInfo, vk_device);
+	VkCommandPool vk_newCommandPool;
+	CreateVulkanCommandPool(vk_newCommandPool, vk_commandPoolInfo, vk_device);
+	vk_commandPool = VulkanCommandPoolHandle(vk_device, vk_newCommandPool);
 
+	//Creating the ring of frames in flight and allocating a command buffer for each one of its slots
+	m_syncObjects.CreateSyncObjects(vk_device, m_framesInFlight, static_cast<uint32_t>(swapchainImages.size()));
 	VkCommandBufferAllocateInfo vk_commandBufferInfo{};
 	CreateAppDefaultVkCommandBufferInfo(vk_commandBufferInfo, vk_commandPool);
-	AllocateVulkanCommandBuffer(vk_commandBuffer, vk_device, vk_commandBufferInfo);
+	for (FrameInFlightData& frame : m_syncObjects.frames)
+	{
+		AllocateVulkanCommandBuffer(frame.vk_commandBuffer, vk_device, vk_commandBufferInfo);
+	}
+
+	//The profiler needs query pools for each slot of the ring, since each slot's results are read back when it is reused
+	if (m_gpuProfilingEnabled)
+	{
+		m_gpuProfiler.CreateQueryPools(vk_device, vk_graphicsCard, m_gpuQueueFamilies.graphics, m_framesInFlight,
+			m_enabledFeatures.pipelineStatisticsQuery == VK_TRUE);
+	}
+
+	//Each slot of the ring gets its own part of the staging ring and, with a dedicated transfer queue, its own upload commands
+	m_uploadQueue.Init(vk_device, m_memoryAllocator, m_gpuQueueFamilies, vk_transferQueue, m_framesInFlight);
 
-	m_syncObjects.CreateSyncObjects(vk_device);
+	if (m_staticCommandBuffersEnabled)
+	{
+		AllocateStaticCommandBuffers();
+	}
+	else if (m_recordingThreadCount)
+	{
+		m_recordingWorkers.Init(vk_device, m_gpuQueueFamilies.graphics, m_recordingThreadCount, m_framesInFlight);
+	}
+}
+
+void VulkanGraphics::AllocateStaticCommandBuffers()
+{
+	if (!m_staticCommandBuffers.empty())
+	{
+		//The pool outlives the deletion queue, which is flushed on cleanup
+		VkDevice vk_poolDevice = vk_device;
+		VkCommandPool vk_pool = vk_commandPool;
+		std::vector<VkCommandBuffer> retiredCommandBuffers = std::move(m_staticCommandBuffers);
+		m_deletionQueue.Retire([vk_poolDevice, vk_pool, retiredCommandBuffers]() 
+			{
+				vkFreeCommandBuffers(vk_poolDevice, vk_pool, static_cast<uint32_t>(retiredCommandBuffers.size()), 
+					retiredCommandBuffers.data());
+			});
+	}
+
+	m_staticCommandBuffers.resize(m_framesInFlight * swapchainImages.size());
+	VkCommandBufferAllocateInfo vk_commandBufferInfo{};
+	CreateAppDefaultVkCommandBufferInfo(vk_commandBufferInfo, vk_commandPool);
+	vk_commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	vk_commandBufferInfo.commandBufferCount = static_cast<uint32_t>(m_staticCommandBuffers.size());
+	AllocateVulkanCommandBuffers(m_staticCommandBuffers.data(), vk_device, vk_commandBufferInfo);
+	//None of the new command buffers has been recorded
+	m_staticCommandBufferVersions.assign(m_staticCommandBuffers.size(), 0);
+}
+
+void VulkanGraphics::CreateDefaultMesh()
+{
+	//The triangle that the vertex shader used to hardcode, wound clockwise to match the rasterization state
+	std::vector<Vertex> vertices =
+	{
+		{ { 0.0f, -0.5f }, { 1.0f, 0.0f, 0.0f } },
+		{ { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f } },
+		{ { -0.5f, 0.5f }, { 0.0f, 0.0f, 1.0f } }
+	};
+	std::vector<uint32_t> indices = { 0, 1, 2 };
+	SetMesh(vertices, indices);
+
+	//Unless the application already asked for its own instances, the triangle is drawn once without being transformed
+	if (m_instances.empty())
+	{
+		m_instances.push_back({ { 0.0f, 0.0f }, 1.0f, 0.0f, { 1.0f, 1.0f, 1.0f, 1.0f } });
+		++m_instanceGeneration;
+	}
+	CreateInstanceBuffers(static_cast<uint32_t>(m_instances.size()));
+}
+
+void VulkanGraphics::SetInstances(const std::vector<InstanceData>& instances)
+{
+	m_instances = instances;
+	++m_instanceGeneration;
+	//The draw that doesn't go through the culling pass records the amount of instances
+	MarkStaticContentDirty();
+	//Before Init the buffers are created with the right capacity from the start
+	if (!m_instanceBuffers.empty() && m_instances.size() > m_instanceCapacity)
+	{
+		//Growing to at least twice the capacity, so that slowly growing instance counts don't wait on the GPU every time
+		CreateInstanceBuffers(std::max(static_cast<uint32_t>(m_instances.size()), m_instanceCapacity * 2));
+	}
+}
+
+void VulkanGraphics::SetViewTransform(float offsetX, float offsetY, float scaleX, float scaleY)
+{
+	//Written so that a NaN scale is clamped as well, keeping the sign of the scale the caller passed
+	auto clampScale = [](float scale)
+	{
+		return std::fabs(scale) >= MIN_VIEW_SCALE ? scale : std::copysign(MIN_VIEW_SCALE, scale);
+	};
+	//Only the transform is written, the material handle of the push constants stays the one SetMaterial picked
+	m_drawConstants.viewTransform[0] = offsetX;
+	m_drawConstants.viewTransform[1] = offsetY;
+	m_drawConstants.viewTransform[2] = clampScale(scaleX);
+	m_drawConstants.viewTransform[3] = clampScale(scaleY);
+	MarkStaticContentDirty();
+}
+
+void VulkanGraphics::SetInstanceCount(uint32_t instanceCount)
+{
+	std::vector<InstanceData> instances(instanceCount);
+	uint32_t columns = 1;
+	while (columns * columns < instanceCount)
+	{
+		++columns;
+	}
+	//The render target goes from -1 to 1 on both axes, and the triangle fits in a square of size 1 before it is scaled
+	float cellSize = 2.0f / columns;
+	for (uint32_t i = 0; i < instanceCount; ++i)
+	{
+		float column = static_cast<float>(i % columns);
+		float row = static_cast<float>(i / columns);
+		InstanceData& instance = instances[i];
+		instance.offset[0] = -1.0f + cellSize * (column + 0.5f);
+		instance.offset[1] = -1.0f + cellSize * (row + 0.5f);
+		instance.scale = cellSize;
+		instance.rotation = 0.0f;
+		//Tinting each instance by its place in the grid, so that every instance can be told apart
+		instance.color[0] = column / columns;
+		instance.color[1] = row / columns;
+		instance.color[2] = 1.0f - column / columns;
+		instance.color[3] = 1.0f;
+	}
+	SetInstances(instances);
+}
+
+void VulkanGraphics::CreateInstanceBuffers(uint32_t instanceCapacity)
+{
+	//The culling pass points its descriptor sets at the new buffers, which can't be done while the frames in flight use them
+	if (!m_instanceBuffers.empty() && m_gpuCullingEnabled)
+	{
+		WaitForFramesInFlight();
+	}
+	for (VulkanBuffer& instanceBuffer : m_instanceBuffers)
+	{
+		m_deletionQueue.Retire(instanceBuffer);
+	}
+
+	/* The CPU writes the instances straight into the buffers, so they need to be host visible. Device local memory that is
+	   also host visible is preferred where the graphics card exposes it, so the vertex shader does not read over the bus */
+	m_instanceCapacity = instanceCapacity ? instanceCapacity : 1;
+	m_instanceBuffers.resize(m_framesInFlight);
+	for (VulkanBuffer& instanceBuffer : m_instanceBuffers)
+	{
+		//The culling pass reads the instances as a storage buffer, and the draw reads them directly when culling is disabled
+		CreateVulkanBuffer(instanceBuffer, sizeof(InstanceData) * m_instanceCapacity, 
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VulkanAllocationStrategy::Buddy, vk_device, m_memoryAllocator);
+	}
+	//None of the new buffers hold any instances yet
+	m_instanceBufferGenerations.assign(m_framesInFlight, 0);
+	MarkStaticContentDirty();
+	if (m_gpuCullingEnabled)
+	{
+		m_cullingPass.SetInstanceBuffers(m_instanceBuffers, m_instanceCapacity);
+	}
+}
+
+void VulkanGraphics::UpdateInstanceBuffer(uint32_t frameIndex)
+{
+	if (m_instanceBufferGenerations[frameIndex] == m_instanceGeneration)
+	{
+		return;
+	}
+	//The buffer is host coherent, so the writes are visible to the GPU once the frame is submitted without flushing them
+	std::memcpy(m_instanceBuffers[frameIndex].allocation.mappedData, m_instances.data(), 
+		sizeof(InstanceData) * m_instances.size());
+	m_instanceBufferGenerations[frameIndex] = m_instanceGeneration;
+}
+
+void VulkanGraphics::SetMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	DestroyMeshBuffers();
+	m_indexCount = static_cast<uint32_t>(indices.size());
+	MarkStaticContentDirty();
+	std::vector<QuantizedVertex> quantizedVertices;
+	if (m_vertexFormat == VertexFormat::Quantized)
+	{
+		QuantizeVertices(vertices, quantizedVertices);
+	}
+	/* The instances are culled with a bounding sphere around the origin of the mesh, since that is what the transform moves.
+	   The positions are measured as the vertex shader reads them, after they were quantized */
+	m_meshBoundingRadius = 0.0f;
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		float x = quantizedVertices.empty() ? vertices[i].position[0] : HalfToFloat(quantizedVertices[i].position[0].bits);
+		float y = quantizedVertices.empty() ? vertices[i].position[1] : HalfToFloat(quantizedVertices[i].position[1].bits);
+		m_meshBoundingRadius = std::max(m_meshBoundingRadius, std::sqrt(x * x + y * y));
+	}
+	if (vertices.empty() || indices.empty())
+	{
+		m_indexCount = 0;
+		return;
+	}
+
+	VkDeviceSize vertexBufferSize = static_cast<VkDeviceSize>(GetVertexLayout(m_vertexFormat).stride) * vertices.size();
+	VkDeviceSize indexBufferSize = sizeof(uint32_t) * indices.size();
+	CreateMeshBuffers(vertexBufferSize, indexBufferSize);
+
+	//Uploads are submitted in the order they were queued, so the mesh is ready once the index upload has been submitted
+	const void* vertexData = quantizedVertices.empty() ? static_cast<const void*>(vertices.data()) : quantizedVertices.data();
+	m_uploadQueue.QueueBufferUpload(m_vertexBuffer.vk_buffer, 0, vertexData, vertexBufferSize);
+	m_meshUploadTicket = m_uploadQueue.QueueBufferUpload(m_indexBuffer.vk_buffer, 0, indices.data(), indexBufferSize);
+}
+
+bool VulkanGraphics::LoadMesh(const char* filename)
+{
+	//The file is checked before the current mesh is replaced
+	MeshFile meshFile;
+	if (!meshFile.Open(filename) || meshFile.GetHeader().vertexFormat != static_cast<uint32_t>(m_vertexFormat) ||
+		meshFile.GetHeader().vertexStride != GetVertexLayout(m_vertexFormat).stride)
+	{
+		return false;
+	}
+	DestroyMeshBuffers();
+	m_meshFile = std::move(meshFile);
+	const MeshFileHeader& header = m_meshFile.GetHeader();
+	m_indexCount = header.indexCount;
+	m_meshBoundingRadius = header.boundingRadius;
+	MarkStaticContentDirty();
+	if (header.vertexCount == 0 || header.indexCount == 0)
+	{
+		m_indexCount = 0;
+		m_meshFile.Close();
+		return true;
+	}
+
+	/* Nothing is read into memory of our own, the pages of the sections go from the mapping into the staging ring, the 
+	   parts that don't fit in it right away over the next frames */
+	CreateMeshBuffers(header.vertices.size, header.indices.size);
+	m_uploadQueue.QueueBorrowedBufferUpload(m_vertexBuffer.vk_buffer, 0, m_meshFile.GetVertexData(), header.vertices.size);
+	m_meshUploadTicket = m_uploadQueue.QueueBorrowedBufferUpload(m_indexBuffer.vk_buffer, 0, m_meshFile.GetIndexData(), 
+		header.indices.size);
+	return true;
+}
+
+void VulkanGraphics::DestroyMeshBuffers()
+{
+	if (m_vertexBuffer.vk_buffer != VK_NULL_HANDLE)
+	{
+		m_uploadQueue.DiscardBufferUploads(m_vertexBuffer.vk_buffer);
+		m_uploadQueue.DiscardBufferUploads(m_indexBuffer.vk_buffer);
+		m_deletionQueue.Retire(m_vertexBuffer);
+		m_deletionQueue.Retire(m_indexBuffer);
+	}
+	m_meshFile.Close();
+}
+
+void VulkanGraphics::CreateMeshBuffers(VkDeviceSize vertexBufferSize, VkDeviceSize indexBufferSize)
+{
+	CreateVulkanBuffer(m_vertexBuffer, vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VulkanAllocationStrategy::Buddy, vk_device, m_memoryAllocator);
+	CreateVulkanBuffer(m_indexBuffer, indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VulkanAllocationStrategy::Buddy, vk_device, m_memoryAllocator);
+}
+
+uint32_t VulkanGraphics::CreateMaterial(const MaterialData& material)
+{
+	//Without descriptor indexing the bindless set can't be written while frames in flight use it
+	if (!m_bindlessResources.UsesDescriptorIndexing())
+	{
+		WaitForFramesInFlight();
+		MarkStaticContentDirty();
+	}
+	VulkanBuffer materialBuffer;
+	CreateVulkanBuffer(materialBuffer, sizeof(MaterialData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | 
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, VulkanAllocationStrategy::Buddy, vk_device,
+		m_memoryAllocator);
+	m_uploadQueue.QueueBufferUpload(materialBuffer.vk_buffer, 0, &material, sizeof(MaterialData));
+	uint32_t materialHandle = m_bindlessResources.RegisterBuffer(materialBuffer.vk_buffer, 0, sizeof(MaterialData));
+	if (materialHandle >= m_materialBuffers.size())
+	{
+		m_materialBuffers.resize(materialHandle + 1);
+	}
+	m_materialBuffers[materialHandle] = materialBuffer;
+	return materialHandle;
+}
+
+void VulkanGraphics::DestroyMaterial(uint32_t materialHandle)
+{
+	if (materialHandle == DEFAULT_BINDLESS_BUFFER || materialHandle >= m_materialBuffers.size())
+	{
+		return;
+	}
+	/* Without descriptor indexing the descriptor of the handle is pointed back at the default material right away. With it
+	   the descriptor is left alone, and the handle is only given to another material once the frames in flight are done */
+	if (!m_bindlessResources.UsesDescriptorIndexing())
+	{
+		WaitForFramesInFlight();
+	}
+	m_uploadQueue.DiscardBufferUploads(m_materialBuffers[materialHandle].vk_buffer);
+	m_bindlessResources.ReleaseBuffer(materialHandle);
+	m_deletionQueue.Retire(m_materialBuffers[materialHandle]);
+	//The handle can be given to another material, so the instances go back to the default one
+	if (m_drawConstants.materialHandle == materialHandle)
+	{
+		SetMaterial(DEFAULT_BINDLESS_BUFFER);
+	}
+	else if (!m_bindlessResources.UsesDescriptorIndexing())
+	{
+		MarkStaticContentDirty();
+	}
 }
 
 void VulkanGraphics::MainLoop()
 {
+	if (!m_waitedForFrame)
+	{
+		WaitForNextFrame();
+	}
+	m_waitedForFrame = false;
+
+	if (m_headless)
+	{
+		DrawHeadless();
+		return;
+	}
+
+	//The window changed size since the last frame, or the swapchain could not be recreated while the window was minimized
+	if ((m_swapchainOutdated || m_windowState.resizeCount != m_windowResizeCount) && !RecreateSwapchain())
+	{
+		return;
+	}
 	Draw();
 }
 
+bool VulkanGraphics::NeedsRedraw()
+{
+	if (m_headless)
+	{
+		return true;
+	}
+	//Publishing the pipelines that finished compiling, since they change the content
+	PublishCompiledPipelines(false);
+	return m_redrawRequested || m_animating || m_swapchainOutdated || 
+		m_drawnContentVersion != m_staticContentVersion || m_drawnInstanceGeneration != m_instanceGeneration ||
+		m_windowState.resizeCount != m_windowResizeCount || m_windowState.damageCount != m_drawnWindowDamageCount ||
+		m_uploadQueue.HasPendingUploads() || m_graphicsPipelineCompilation.valid() || m_cullingPipelineCompilation.valid();
+}
+
+void VulkanGraphics::SetFramePacing(const FramePacingSettings& framePacing)
+{
+	bool swapchainChanged = framePacing.vk_presentMode != m_framePacing.vk_presentMode || 
+		framePacing.swapchainImageCount != m_framePacing.swapchainImageCount;
+	m_framePacing = framePacing;
+	//The limiter starts over from the next frame, instead of catching up with the deadlines of the previous frame rate
+	m_nextFrameDeadline = std::chrono::steady_clock::now();
+	if (swapchainChanged && vk_swapchain != VK_NULL_HANDLE)
+	{
+		m_swapchainOutdated = true;
+	}
+}
+
+void VulkanGraphics::WaitForNextFrame()
+{
+	m_waitedForFrame = true;
+
+	/* Waiting for the previous frame to reach the display, or at least to finish rendering, so that the fence wait in Draw 
+	   doesn't block after the input of the next frame was sampled */
+	if (m_framePacing.lowLatency)
+	{
+		if (vk_waitForPresent && m_lastPresentId)
+		{
+			//A present that never completes (like on a hidden window) only holds the frame back for the timeout
+			VkResult vk_waitResult = vk_waitForPresent(vk_device, vk_swapchain, m_lastPresentId, PRESENT_WAIT_TIMEOUT);
+			if (vk_waitResult == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				m_swapchainOutdated = true;
+			}
+		}
+		else if (!m_syncObjects.frames.empty())
+		{
+			uint32_t frameCount = static_cast<uint32_t>(m_syncObjects.frames.size());
+			uint32_t previousFrame = (m_syncObjects.GetCurrentFrameIndex() + frameCount - 1) % frameCount;
+			vkWaitForFences(vk_device, 1, m_syncObjects.frames[previousFrame].vk_framesInFlightFence.GetAddress(), VK_TRUE, UINT64_MAX);
+		}
+	}
+
+	if (m_framePacing.targetFrameRate <= 0.0)
+	{
+		return;
+	}
+	/* Sleeping until shortly before the deadline and spinning for the rest, since sleeps can oversleep by more than a 
+	   millisecond. A frame that missed its deadline by more than a whole frame resets the deadlines instead of rushing the
+	   frames after it */
+	std::chrono::steady_clock::duration framePeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(1.0 / m_framePacing.targetFrameRate));
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (m_nextFrameDeadline + framePeriod < now)
+	{
+		m_nextFrameDeadline = now;
+	}
+	std::this_thread::sleep_until(m_nextFrameDeadline - FRAME_LIMITER_SPIN_TIME);
+	while (std::chrono::steady_clock::now() < m_nextFrameDeadline)
+	{
+		std::this_thread::yield();
+	}
+	m_nextFrameDeadline += framePeriod;
+}
+
 void VulkanGraphics::Draw()
 {
+	FrameInFlightData& frame = m_syncObjects.GetCurrentFrame();
 
-	//Wait for the previous frame to finish and reseting the fence when we get a signal from it
-	vkWaitForFences(vk_device, 1, &m_syncObjects.vk_framesInFlightFence, VK_TRUE, UINT64_MAX);
-	vkResetFences(vk_device, 1, &m_syncObjects.vk_framesInFlightFence);
+	/* Wait only for the frame that last used this slot of the ring to finish. The frames recorded in the other slots
+	   can still be executing on the GPU while we record this one */
+	vkWaitForFences(vk_device, 1, frame.vk_framesInFlightFence.GetAddress(), VK_TRUE, UINT64_MAX);
 
 	//Getting the index of the next image that we can draw to
 	uint32_t imageIndex;
-	vkAcquireNextImageKHR(vk_device, vk_swapchain, UINT64_MAX, m_syncObjects.vk_imageAvailableSemaphore,
+	VkResult vk_acquireResult = vkAcquireNextImageKHR(vk_device, vk_swapchain, UINT64_MAX, frame.vk_imageAvailableSemaphore,
 		VK_NULL_HANDLE, &imageIndex);
+	//The swapchain no longer matches the surface and can't be presented to. The fence was not reset so the slot is reusable
+	if (vk_acquireResult == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		RecreateSwapchain();
+		return;
+	}
+	else if (vk_acquireResult != VK_SUCCESS && vk_acquireResult != VK_SUBOPTIMAL_KHR)
+	{
+		__debugbreak();
+	}
+
+	//If a frame from a different slot is still rendering to the image we acquired, we need to wait for it as well
+	if (m_syncObjects.imagesInFlight[imageIndex] != VK_NULL_HANDLE && 
+		m_syncObjects.imagesInFlight[imageIndex] != frame.vk_framesInFlightFence)
+	{
+		vkWaitForFences(vk_device, 1, &m_syncObjects.imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+	}
+	m_syncObjects.imagesInFlight[imageIndex] = frame.vk_framesInFlightFence;
+	vkResetFences(vk_device, 1, frame.vk_framesInFlightFence.GetAddress());
 	
-	//Resettig the command buffer for the previous frame
-	vkResetCommandBuffer(vk_commandBuffer, 0);
-	//Creating a begin info struct for the command buffer
-	VkCommandBufferBeginInfo vk_commandBufferBegin{};
-	CreateVulkanCommandBufferBeginInfo(vk_commandBufferBegin, 0, nullptr);
-	//Creating a begin info struct for the render pass that we will be using
-	VkRenderPassBeginInfo vk_renderPassBegin{};
-	VkOffset2D vk_renderAreaOffset{ 0 , 0 };
-	VkClearValue vk_clearValue{ {{0.0f, 0.0f, 0.0f, 1.0f}} };
-	CreateVulkanRenderPassBeginInfo(vk_renderPassBegin, framebuffers[imageIndex], vk_renderPass, vk_imageExtent,
-		vk_renderAreaOffset, 1, &vk_clearValue);
-	//Recording the command buffer before submitting the queue
-	RecordCommandBuffer(vk_commandBufferBegin, vk_renderPassBegin, vk_commandBuffer, vk_graphicsPipeline,
-		vk_imageExtent);
+	VkSemaphore vk_uploadSemaphore = RecordFrame(frame, imageIndex);
 
 	VkSubmitInfo vk_submitInfo{};
-	//Specifies the operation we should wait to finish before submitting the queue
-	VkSemaphore vk_waitSemaphores[] = { m_syncObjects.vk_imageAvailableSemaphore };
+	/* Specifies the operation we should wait to finish before submitting the queue. The copies of the frame's uploads 
+	   only need to be done before vertex input, so rendering can start while they are still running */
+	VkSemaphore vk_waitSemaphores[] = { frame.vk_imageAvailableSemaphore, vk_uploadSemaphore };
+	uint32_t waitSemaphoreCount = vk_uploadSemaphore != VK_NULL_HANDLE ? 2 : 1;
 	//Signal the semaphore so that operation can continue after rendering is complete
-	VkSemaphore vk_signalSemaphores[] = { m_syncObjects.vk_renderFinishedSemaphore };
+	VkSemaphore vk_signalSemaphores[] = { frame.vk_renderFinishedSemaphore };
 	//Specifies in which stages of the pipeline the gpu should wait for the specified operations to finish
-	VkPipelineStageFlags vk_pipelineWaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	CreateVulkanSubmitInfo(vk_submitInfo, 1, vk_waitSemaphores, vk_pipelineWaitStages, 1, vk_commandBuffer,
-		1, vk_signalSemaphores);
-	vkQueueSubmit(vk_graphicsQueue, 1, &vk_submitInfo, m_syncObjects.vk_framesInFlightFence);
+	VkPipelineStageFlags vk_pipelineWaitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT };
+	CreateVulkanSubmitInfo(vk_submitInfo, waitSemaphoreCount, vk_waitSemaphores, vk_pipelineWaitStages, 1, 
+		frame.vk_commandBuffer, 1, vk_signalSemaphores);
+	vkQueueSubmit(vk_graphicsQueue, 1, &vk_submitInfo, frame.vk_framesInFlightFence);
 
 	VkPresentInfoKHR vk_presentInfo{};
 	VkSwapchainKHR vk_swapchains[] = { vk_swapchain };
 	CreateVulkanPresentInfo(vk_presentInfo, 1, vk_signalSemaphores, 1, vk_swapchains, imageIndex);
-	vkQueuePresentKHR(vk_presentQueue, &vk_presentInfo);
+	//Each present gets an id when present wait is enabled, so that the low latency wait can wait for it to be displayed
+	VkPresentIdKHR vk_presentId{};
+	uint64_t presentId = m_nextPresentId;
+	if (vk_waitForPresent)
+	{
+		vk_presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+		vk_presentId.swapchainCount = 1;
+		vk_presentId.pPresentIds = &presentId;
+		vk_presentInfo.pNext = &vk_presentId;
+		m_lastPresentId = m_nextPresentId++;
+	}
+	VkResult vk_presentResult = vkQueuePresentKHR(vk_presentQueue, &vk_presentInfo);
+
+	m_syncObjects.AdvanceFrame();
+	//The frame that was just presented shows the content as it is now
+	m_drawnContentVersion = m_staticContentVersion;
+	m_drawnInstanceGeneration = m_instanceGeneration;
+	m_drawnWindowDamageCount = m_windowState.damageCount;
+	m_redrawRequested = false;
+
+	//A suboptimal swapchain can still be presented to, but it is recreated so that it matches the surface again
+	if (vk_presentResult == VK_ERROR_OUT_OF_DATE_KHR || vk_presentResult == VK_SUBOPTIMAL_KHR)
+	{
+		m_swapchainOutdated = true;
+	}
+	else if (vk_presentResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+}
+
+void VulkanGraphics::DrawHeadless()
+{
+	FrameInFlightData& frame = m_syncObjects.GetCurrentFrame();
+
+	//Each slot of the ring renders to its own offscreen target, so the slot's fence is the only thing we need to wait on
+	vkWaitForFences(vk_device, 1, frame.vk_framesInFlightFence.GetAddress(), VK_TRUE, UINT64_MAX);
+	vkResetFences(vk_device, 1, frame.vk_framesInFlightFence.GetAddress());
+
+	uint32_t imageIndex = m_syncObjects.GetCurrentFrameIndex();
+	m_syncObjects.imagesInFlight[imageIndex] = frame.vk_framesInFlightFence;
+
+	VkSemaphore vk_uploadSemaphore = RecordFrame(frame, imageIndex);
+
+	//There is no image to acquire and nothing to present, so the submission only waits on the frame's uploads if it has any
+	VkSubmitInfo vk_submitInfo{};
+	VkPipelineStageFlags vk_uploadWaitStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+	CreateVulkanSubmitInfo(vk_submitInfo, vk_uploadSemaphore != VK_NULL_HANDLE ? 1 : 0, &vk_uploadSemaphore, 
+		&vk_uploadWaitStage, 1, frame.vk_commandBuffer, 0, nullptr);
+	vkQueueSubmit(vk_graphicsQueue, 1, &vk_submitInfo, frame.vk_framesInFlightFence);
+
+	m_syncObjects.AdvanceFrame();
+}
+
+VkSemaphore VulkanGraphics::RecordFrame(FrameInFlightData& frame, uint32_t imageIndex)
+{
+	std::chrono::steady_clock::time_point recordingStart = std::chrono::steady_clock::now();
+	//Resettig the command buffer of this slot, the GPU is done with the frame that was previously recorded in it
+	vkResetCommandBuffer(frame.vk_commandBuffer, 0);
+	//Creating a begin info struct for the command buffer
+	VkCommandBufferBeginInfo vk_commandBufferBegin{};
+	CreateVulkanCommandBufferBeginInfo(vk_commandBufferBegin, 0, nullptr);
+	//Recording the command buffer before submitting the queue
+	uint32_t frameIndex = m_syncObjects.GetCurrentFrameIndex();
+	//Starting to use the pipelines that finished compiling since the last frame
+	PublishCompiledPipelines(false);
+	vkBeginCommandBuffer(frame.vk_commandBuffer, &vk_commandBufferBegin);
+	m_gpuProfiler.BeginFrame(vk_device, frame.vk_commandBuffer, frameIndex);
+	uint32_t frameScope = m_gpuProfiler.BeginScope(frame.vk_commandBuffer, "Frame", frameIndex);
+
+	//Submitting the uploads queued since the last frame, this frame can draw every mesh whose upload has been submitted
+	VkSemaphore vk_uploadSemaphore = m_uploadQueue.Flush(frame.vk_commandBuffer, frameIndex);
+	//Once the upload of a loaded mesh has been submitted all of it is in the staging ring, so its file can be unmapped
+	if (m_meshFile.IsOpen() && IsMeshUploaded())
+	{
+		m_meshFile.Close();
+	}
+	//The fence of the slot has signaled, so the GPU is no longer reading the slot's instance buffer or constants
+	UpdateInstanceBuffer(frameIndex);
+	m_frameConstants.BeginFrame(frameIndex);
+	m_bindlessResources.BeginFrame(frameIndex);
+	m_deletionQueue.BeginFrame(frameIndex);
+	m_frameUniforms.resolution[0] = static_cast<float>(vk_imageExtent.width);
+	m_frameUniforms.resolution[1] = static_cast<float>(vk_imageExtent.height);
+	m_frameUniforms.time = static_cast<float>(MillisecondsSince(m_initStart) / 1000.0);
+	uint32_t frameUniformOffset = m_frameConstants.Write(frameIndex, m_frameUniforms);
+	m_recordedMesh = MeshBuffers{ m_vertexBuffer.vk_buffer, m_indexBuffer.vk_buffer, 
+		m_uploadQueue.GetSubmittedTicket() >= m_meshUploadTicket ? m_indexCount : 0, m_instanceBuffers[frameIndex].vk_buffer,
+		VK_NULL_HANDLE, nullptr, vk_pipelineLayout, m_frameConstants.GetDescriptorSet(), frameUniformOffset, 
+		m_bindlessResources.GetDescriptorSet(), m_drawConstants };
+	//Until the graphics pipeline has compiled the render pass only clears the render target
+	if (vk_graphicsPipeline == VK_NULL_HANDLE)
+	{
+		m_recordedMesh.indexCount = 0;
+	}
+
+	//The render graph records the passes that were not culled with the barriers and layout transitions between them
+	m_renderGraph.Execute(frame.vk_commandBuffer, frameIndex, imageIndex);
+
+	m_gpuProfiler.EndScope(frame.vk_commandBuffer, frameScope, frameIndex);
+	vkEndCommandBuffer(frame.vk_commandBuffer);
+
+	std::chrono::steady_clock::time_point recordingEnd = std::chrono::steady_clock::now();
+	m_lastRecordingMs = std::chrono::duration<double, std::milli>(recordingEnd - recordingStart).count();
+	return vk_uploadSemaphore;
+}
+
+void VulkanGraphics::RecordCullingPass(const RenderGraphPassContext& context)
+{
+	//Culling the instances before the render pass, the draw then takes the visible instances and their amount from the GPU
+	if (!m_cullingPass.IsReady() || !m_recordedMesh.indexCount)
+	{
+		return;
+	}
+	uint32_t cullingScope = m_gpuProfiler.BeginScope(context.vk_commandBuffer, "Culling", context.frameIndex);
+	m_cullingPass.RecordCulling(context.vk_commandBuffer, context.frameIndex, static_cast<uint32_t>(m_instances.size()), 
+		m_recordedMesh.indexCount, m_meshBoundingRadius, m_drawConstants.viewTransform);
+	m_gpuProfiler.EndScope(context.vk_commandBuffer, cullingScope, context.frameIndex);
+	m_recordedMesh.vk_instanceBuffer = m_cullingPass.GetVisibleInstanceBuffer(context.frameIndex);
+	m_recordedMesh.vk_drawArgumentsBuffer = m_cullingPass.GetDrawArgumentsBuffer(context.frameIndex);
+	m_recordedMesh.vk_drawIndexedIndirectCount = vk_drawIndexedIndirectCount;
+}
+
+void VulkanGraphics::RecordMainPass(const RenderGraphPassContext& context)
+{
+	uint32_t renderPassScope = m_gpuProfiler.BeginScope(context.vk_commandBuffer, "RenderPass", context.frameIndex);
+	if (m_staticCommandBuffersEnabled)
+	{
+		RecordStaticRenderPass(context.vk_renderPassBegin, context.vk_commandBuffer, context.frameIndex, context.imageIndex,
+			m_recordedMesh);
+	}
+	else if (m_recordingWorkers.IsEnabled())
+	{
+		/* The pipeline statistics query would be active while the secondary command buffers execute, which needs the
+		   inherited queries feature, so the statistics are not collected on this path */
+		RecordParallelRenderPass(context.vk_renderPassBegin, context.vk_commandBuffer, context.frameIndex, 
+			context.imageIndex, m_recordedMesh);
+	}
+	//Without worker threads the split draws are recorded on this thread, the same draws that the workers would record
+	else if (m_instancesPerDraw)
+	{
+		m_gpuProfiler.BeginPipelineStatistics(context.vk_commandBuffer, context.frameIndex);
+		vkCmdBeginRenderPass(context.vk_commandBuffer, &context.vk_renderPassBegin, VK_SUBPASS_CONTENTS_INLINE);
+		RecordInstanceRangeDraws(context.vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent, m_recordedMesh, 0,
+			static_cast<uint32_t>(m_instances.size()), m_instancesPerDraw);
+		vkCmdEndRenderPass(context.vk_commandBuffer);
+		m_gpuProfiler.EndPipelineStatistics(context.vk_commandBuffer, context.frameIndex);
+	}
+	else
+	{
+		m_gpuProfiler.BeginPipelineStatistics(context.vk_commandBuffer, context.frameIndex);
+		RecordRenderPassCommands(context.vk_renderPassBegin, context.vk_commandBuffer, vk_graphicsPipeline, vk_imageExtent,
+			m_recordedMesh, static_cast<uint32_t>(m_instances.size()));
+		m_gpuProfiler.EndPipelineStatistics(context.vk_commandBuffer, context.frameIndex);
+	}
+	m_gpuProfiler.EndScope(context.vk_commandBuffer, renderPassScope, context.frameIndex);
+}
+
+void VulkanGraphics::RecordStaticRenderPass(const VkRenderPassBeginInfo& vk_renderPassBegin, 
+	const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t imageIndex, const MeshBuffers& mesh)
+{
+	//The mesh was still uploading when the static command buffers were last recorded, or it stopped being drawable
+	if (mesh.indexCount != m_staticContentIndexCount)
+	{
+		m_staticContentIndexCount = mesh.indexCount;
+		MarkStaticContentDirty();
+	}
+
+	/* The command buffer is only executed by the frames of this slot, and the slot's fence has signaled, so it can be 
+	   recorded again. The primary command buffers that executed it are being recorded again as well */
+	size_t staticIndex = frameIndex * swapchainImages.size() + imageIndex;
+	VkCommandBuffer vk_staticCommandBuffer = m_staticCommandBuffers[staticIndex];
+	if (m_staticCommandBufferVersions[staticIndex] != m_staticContentVersion)
+	{
+		VkCommandBufferInheritanceInfo vk_inheritanceInfo{};
+		vk_inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		vk_inheritanceInfo.renderPass = vk_renderPassBegin.renderPass;
+		vk_inheritanceInfo.subpass = 0;
+		vk_inheritanceInfo.framebuffer = vk_renderPassBegin.framebuffer;
+		VkCommandBufferBeginInfo vk_commandBufferBegin{};
+		CreateVulkanCommandBufferBeginInfo(vk_commandBufferBegin, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, 
+			&vk_inheritanceInfo);
+		vkBeginCommandBuffer(vk_staticCommandBuffer, &vk_commandBufferBegin);
+		RecordMeshDraws(vk_staticCommandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh, 
+			static_cast<uint32_t>(m_instances.size()));
+		vkEndCommandBuffer(vk_staticCommandBuffer);
+		m_staticCommandBufferVersions[staticIndex] = m_staticContentVersion;
+	}
+
+	vkCmdBeginRenderPass(vk_commandBuffer, &vk_renderPassBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	vkCmdExecuteCommands(vk_commandBuffer, 1, &vk_staticCommandBuffer);
+	vkCmdEndRenderPass(vk_commandBuffer);
+}
+
+void VulkanGraphics::RecordParallelRenderPass(const VkRenderPassBeginInfo& vk_renderPassBegin, 
+	const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t imageIndex, const MeshBuffers& mesh)
+{
+	//The contents of the render pass come only from the secondary command buffers, the primary can't record draws in it
+	vkCmdBeginRenderPass(vk_commandBuffer, &vk_renderPassBegin, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	//Naming the framebuffer is optional, but lets the driver specialize the secondary command buffers for it
+	VkCommandBufferInheritanceInfo vk_inheritanceInfo{};
+	vk_inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	vk_inheritanceInfo.renderPass = vk_renderPassBegin.renderPass;
+	vk_inheritanceInfo.subpass = 0;
+	vk_inheritanceInfo.framebuffer = vk_renderPassBegin.framebuffer;
+
+	//Each job is a single draw, so the workers split the draws and not the instances
+	uint32_t instanceCount = mesh.indexCount ? static_cast<uint32_t>(m_instances.size()) : 0;
+	uint32_t drawCount = (instanceCount + m_instancesPerDraw - 1) / m_instancesPerDraw;
+	m_recordingWorkers.Record(frameIndex, vk_inheritanceInfo, drawCount,
+		[this, &mesh, instanceCount](const VkCommandBuffer& vk_secondaryCommandBuffer, uint32_t firstDraw, uint32_t drawJobs)
+		{
+			uint32_t firstInstance = firstDraw * m_instancesPerDraw;
+			uint32_t rangeInstanceCount = std::min(drawJobs * m_instancesPerDraw, instanceCount - firstInstance);
+			RecordInstanceRangeDraws(vk_secondaryCommandBuffer, vk_graphicsPipeline, vk_imageExtent, mesh, firstInstance,
+				rangeInstanceCount, m_instancesPerDraw);
+		}, m_recordedSecondaryCommandBuffers);
+
+	if (!m_recordedSecondaryCommandBuffers.empty())
+	{
+		vkCmdExecuteCommands(vk_commandBuffer, static_cast<uint32_t>(m_recordedSecondaryCommandBuffers.size()),
+			m_recordedSecondaryCommandBuffers.data());
+	}
+	vkCmdEndRenderPass(vk_commandBuffer);
 }
 
 void VulkanGraphics::Cleanup()
 {
+	//The pipelines that are still compiling are published so that their threads are done and the pipelines are destroyed
+	WaitForPipelines();
+	//Every frame in flight needs to finish before its sync objects can be destroyed
+	vkDeviceWaitIdle(vk_device);
+	m_deletionQueue.Cleanup();
 	m_syncObjects.Cleanup(vk_device);
+	DestroyVulkanBuffer(m_vertexBuffer, vk_device, m_memoryAllocator);
+	DestroyVulkanBuffer(m_indexBuffer, vk_device, m_memoryAllocator);
+	m_meshFile.Close();
+	for (VulkanBuffer& instanceBuffer : m_instanceBuffers)
+	{
+		DestroyVulkanBuffer(instanceBuffer, vk_device, m_memoryAllocator);
+	}
+	m_instanceBuffers.clear();
+	m_cullingPass.Cleanup();
+	m_frameConstants.Cleanup();
+	for (VulkanBuffer& materialBuffer : m_materialBuffers)
+	{
+		DestroyVulkanBuffer(materialBuffer, vk_device, m_memoryAllocator);
+	}
+	m_materialBuffers.clear();
+	DestroyVulkanBuffer(m_defaultMaterialBuffer, vk_device, m_memoryAllocator);
+	m_bindlessResources.Cleanup();
+	m_uploadQueue.Cleanup();
+	m_recordingWorkers.Cleanup();
+
+	//Persisting the pipelines compiled during this run so that the next launch can skip compiling them
+	m_pipelineCache.SavePipelineCache(vk_device);
+	m_pipelineCache.Cleanup(vk_device);
+	m_gpuProfiler.Cleanup(vk_device);
 }
 
 
@@ -255,6 +1324,91 @@ void VulkanGraphics::CreateAppDefaultVkInstanceInfo(VkInstanceCreateInfo& vk_ins
 	vk_instanceInfo.ppEnabledLayerNames = nullptr;
 }
 
+void VulkanGraphics::AddOptionalDeviceExtensions()
+{
+	//The count variant of the indirect draw lets the GPU skip the draw entirely when the culling pass finds nothing visible
+	std::vector<const char*> drawIndirectCountExtension = { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME };
+	if (m_gpuCullingEnabled && CheckGraphicsCardExtensionsSupport(vk_graphicsCard, drawIndirectCountExtension))
+	{
+		requiredDeviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+	}
+
+	/* Present wait lets the low latency mode wait for the previous frame to reach the display, and descriptor indexing lets
+	   the bindless resource table be updated while frames in flight use it. Their features can only be queried through the
+	   instance extension for the second version of the device queries */
+	std::vector<const char*> presentWaitExtensions = { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME };
+	std::vector<const char*> descriptorIndexingExtensions = { VK_KHR_MAINTENANCE3_EXTENSION_NAME, 
+		VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME };
+	m_presentIdFeatures = {};
+	m_presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+	m_presentWaitFeatures = {};
+	m_presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+	m_descriptorIndexingFeatures = {};
+	m_descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (!m_physicalDeviceProperties2Enabled)
+	{
+		return;
+	}
+	PFN_vkGetPhysicalDeviceFeatures2KHR vk_getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+		vkGetInstanceProcAddr(vk_instance, "vkGetPhysicalDeviceFeatures2KHR"));
+	if (!vk_getFeatures2)
+	{
+		return;
+	}
+	bool presentWaitSupported = !m_headless && CheckGraphicsCardExtensionsSupport(vk_graphicsCard, presentWaitExtensions);
+	bool descriptorIndexingSupported = CheckGraphicsCardExtensionsSupport(vk_graphicsCard, descriptorIndexingExtensions);
+	m_presentIdFeatures.pNext = &m_presentWaitFeatures;
+	m_descriptorIndexingFeatures.pNext = &m_presentIdFeatures;
+	VkPhysicalDeviceFeatures2KHR vk_features2{};
+	vk_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+	vk_features2.pNext = &m_descriptorIndexingFeatures;
+	//Querying the features of extensions the graphics card doesn't have only leaves them false
+	vk_getFeatures2(vk_graphicsCard, &vk_features2);
+
+	if (presentWaitSupported && m_presentIdFeatures.presentId && m_presentWaitFeatures.presentWait)
+	{
+		requiredDeviceExtensions.insert(requiredDeviceExtensions.end(), presentWaitExtensions.begin(), 
+			presentWaitExtensions.end());
+	}
+	else
+	{
+		m_presentIdFeatures.presentId = VK_FALSE;
+		m_presentWaitFeatures.presentWait = VK_FALSE;
+	}
+
+	//Only the features that the bindless resource table uses are enabled, and only if the graphics card has all of them
+	bool bindlessFeaturesSupported = descriptorIndexingSupported && 
+		m_descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+		m_descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending &&
+		m_descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind && 
+		m_descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+	m_descriptorIndexingFeatures = {};
+	m_descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	if (bindlessFeaturesSupported)
+	{
+		requiredDeviceExtensions.insert(requiredDeviceExtensions.end(), descriptorIndexingExtensions.begin(), 
+			descriptorIndexingExtensions.end());
+		m_descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+		m_descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+		m_descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+		m_descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	}
+	//The device is created with the features that ended up enabled
+	m_descriptorIndexingFeatures.pNext = m_presentWaitFeatures.presentWait ? &m_presentIdFeatures : nullptr;
+	m_presentWaitFeatures.pNext = nullptr;
+}
+
+void VulkanGraphics::AddOptionalInstanceExtensions(std::vector<const char*>& instanceExtensions)
+{
+	//Present id depends on it, and it lets the application query the features of present wait
+	m_physicalDeviceProperties2Enabled = CheckInstanceExtensionSupport(
+		VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	if (m_physicalDeviceProperties2Enabled)
+	{
+		instanceExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+	}
+}
+
 void VulkanGraphics::CreateAppDefaultVkDeviceInfo(VkDeviceCreateInfo& vk_deviceInfo, 
 	const QueueFamilyIndices& gpuQueueFamilyIndices,const std::vector<const char*>& requiredDeviceExtensions, 
 	std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos)
@@ -262,7 +1416,7 @@ void VulkanGraphics::CreateAppDefaultVkDeviceInfo(VkDeviceCreateInfo& vk_deviceI
 	/*Creating all the necessary queue create infos based on the queue family indices we retrieved from the graphics card
 	  when we called the CheckGraphicsCardSwapchainSupport function from the PickPhysicalDevice function */
 	std::set<uint32_t> uniqueQueueFamilies = { gpuQueueFamilyIndices.graphics,
-			gpuQueueFamilyIndices.present };
+			gpuQueueFamilyIndices.present, gpuQueueFamilyIndices.transfer };
 	float queuePriority = 1.0f;
 	for (uint32_t queueFamily : uniqueQueueFamilies)
 	{
@@ -283,8 +1437,26 @@ void VulkanGraphics::CreateAppDefaultVkDeviceInfo(VkDeviceCreateInfo& vk_deviceI
 	vk_deviceInfo.enabledExtensionCount = requiredDeviceExtensions.size();
 	vk_deviceInfo.ppEnabledExtensionNames = requiredDeviceExtensions.data();
 
-	//Device features
-	vk_deviceInfo.pEnabledFeatures = nullptr;
+	/* Device features, pipeline statistics queries are only enabled when the profiler asks for them and the graphics card 
+	   supports them */
+	VkPhysicalDeviceFeatures vk_supportedFeatures;
+	vkGetPhysicalDeviceFeatures(vk_graphicsCard, &vk_supportedFeatures);
+	m_enabledFeatures = {};
+	m_enabledFeatures.pipelineStatisticsQuery = m_gpuProfilingEnabled && m_pipelineStatisticsEnabled ? 
+		vk_supportedFeatures.pipelineStatisticsQuery : VK_FALSE;
+	//The fragment shader indexes the bindless buffer array with the material handle of the draw
+	m_enabledFeatures.shaderStorageBufferArrayDynamicIndexing = vk_supportedFeatures.shaderStorageBufferArrayDynamicIndexing;
+	vk_deviceInfo.pEnabledFeatures = &m_enabledFeatures;
+	/* The optional features were chained together when the graphics card was found to support them, descriptor indexing 
+	   first and then present id and present wait */
+	if (m_descriptorIndexingFeatures.descriptorBindingPartiallyBound)
+	{
+		vk_deviceInfo.pNext = &m_descriptorIndexingFeatures;
+	}
+	else if (m_presentWaitFeatures.presentWait)
+	{
+		vk_deviceInfo.pNext = &m_presentIdFeatures;
+	}
 
 	//Device queues
 	vk_deviceInfo.queueCreateInfoCount = queueCreateInfos.size();
@@ -307,6 +1479,18 @@ void VulkanGraphics::CreateAppDefaultVkSwapchainInfo(VkSwapchainCreateInfoKHR& v
 	vk_swapchainInfo.imageArrayLayers = 1;
 	vk_swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+	/* Fewer images keep fewer frames queued in front of the display, more let the GPU keep rendering while the display holds
+	   on to its images. A max image count of 0 means that the surface has no upper limit */
+	const VkSurfaceCapabilitiesKHR& vk_surfaceCapabilities = m_gpuSwapchainSupport.surfaceCapabilities;
+	uint32_t imageCount = m_framePacing.swapchainImageCount ? m_framePacing.swapchainImageCount : 
+		vk_surfaceCapabilities.minImageCount + 1;
+	imageCount = std::max(imageCount, vk_surfaceCapabilities.minImageCount);
+	if (vk_surfaceCapabilities.maxImageCount)
+	{
+		imageCount = std::min(imageCount, vk_surfaceCapabilities.maxImageCount);
+	}
+	vk_swapchainInfo.minImageCount = imageCount;
+
 	uint32_t queueFamilyIndices[] = { m_gpuQueueFamilies.graphics, m_gpuQueueFamilies.present };
 	if (m_gpuQueueFamilies.graphics != m_gpuQueueFamilies.present) {
 		vk_swapchainInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
@@ -319,66 +1503,25 @@ void VulkanGraphics::CreateAppDefaultVkSwapchainInfo(VkSwapchainCreateInfoKHR& v
 		vk_swapchainInfo.pQueueFamilyIndices = nullptr; // Optional
 	}
 
-	vk_swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
+	//The swapchain that is being replaced, which is VK_NULL_HANDLE the first time the swapchain is created
+	vk_swapchainInfo.oldSwapchain = vk_swapchain;
 }
 
-void VulkanGraphics::CreateAppDefaultPipelineLayoutInfo(VkPipelineLayoutCreateInfo& vk_pipelineLayoutInfo)
+void VulkanGraphics::CreateAppDefaultPipelineLayoutInfo(VkPipelineLayoutCreateInfo& vk_pipelineLayoutInfo, 
+	std::vector<VkDescriptorSetLayout>& setLayouts, VkPushConstantRange& vk_pushConstantRange)
 {
+	//The vertex shader reads the view transform and the fragment shader the material handle
+	vk_pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+	vk_pushConstantRange.offset = 0;
+	vk_pushConstantRange.size = sizeof(DrawPushConstants);
+
+	//Set 0 holds the frame's uniforms and set 1 the bindless resources
+	setLayouts = { m_frameConstants.GetDescriptorSetLayout(), m_bindlessResources.GetDescriptorSetLayout() };
 	vk_pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	vk_pipelineLayoutInfo.setLayoutCount = 0;
-	vk_pipelineLayoutInfo.pSetLayouts = nullptr;
-	vk_pipelineLayoutInfo.pushConstantRangeCount = 0;
-	vk_pipelineLayoutInfo.pPushConstantRanges = nullptr;
-}
-
-void VulkanGraphics::CreateAppDefaultRenderPassInfo(VkRenderPassCreateInfo& vk_renderPassInfo,
-	VkAttachmentDescription& vk_attachmentInfo,VkAttachmentReference& vk_attachmentRef, 
-	VkSubpassDescription& vk_subpassInfo, VkSubpassDependency& vk_subpassDependency)
-{
-	vk_attachmentInfo.format = vk_imageFormat;
-	vk_attachmentInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-	//For each new frame the framebuffer will be cleared to black before rendering
-	vk_attachmentInfo.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	//The rendering results are stored so that they can be rendered to the screen
-	vk_attachmentInfo.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	//The application does not use a stencil buffer
-	vk_attachmentInfo.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	vk_attachmentInfo.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	//The contents of the image from the previous will probably not be preserved (but it's going to be cleared either way)
-	vk_attachmentInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	//The layout will be ready for presentation after the render pass is finished
-	vk_attachmentInfo.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	/* One ore more subpasses can be passed into a single render pass. They consist of subsequent operations 
-	   that depend on the contents of framebuffers from previous passes. One subpass can have multiple attachment 
-	   references, which are references to one of the attachments like the one created above */
-
-	//The attachment reference references the first attachment in the attachments array
-	vk_attachmentRef.attachment = 0;
-	//The attachment will be used as a color buffer 
-	vk_attachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	//Explicitly stating that this is a graphics subpass
-	vk_subpassInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	//The subpass will have 1 attachment, the color attahment we created a reference for
-	vk_subpassInfo.colorAttachmentCount = 1;
-	vk_subpassInfo.pColorAttachments = &vk_attachmentRef;
-
-	vk_subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	vk_subpassDependency.dstSubpass = 0;
-	//Specifies which stage to wait on
-	vk_subpassDependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	vk_subpassDependency.srcAccessMask = 0;
-	vk_subpassDependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	vk_subpassDependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	vk_renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	vk_renderPassInfo.attachmentCount = 1;
-	vk_renderPassInfo.pAttachments = &vk_attachmentInfo;
-	vk_renderPassInfo.subpassCount = 1;
-	vk_renderPassInfo.pSubpasses = &vk_subpassInfo;
-	vk_renderPassInfo.dependencyCount = 1;
-	vk_renderPassInfo.pDependencies = &vk_subpassDependency;
+	vk_pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	vk_pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	vk_pipelineLayoutInfo.pushConstantRangeCount = 1;
+	vk_pipelineLayoutInfo.pPushConstantRanges = &vk_pushConstantRange;
 }
 
 void VulkanGraphics::CreateAppDefaultPipelineFixedState(VkPipelineInputAssemblyStateCreateInfo& vk_inputAssemblyInfo,
@@ -412,10 +1555,11 @@ void VulkanGraphics::CreateAppDefaultPipelineFixedState(VkPipelineInputAssemblyS
 
 	/* Setting up multisampling which is a form of anti-alliasing. It combines the fragment shader results of multiple
 	polygons that rasterize to the same pixel. This mainly occurs along edges,
-	which is also where the most noticeable aliasing artifacts occur. It requires a GPU feature to enable. */
+	which is also where the most noticeable aliasing artifacts occur. The samples need to match the color attachment of 
+	the main pass. Sample shading stays off so that the fragment shader still runs once per pixel */
 	vk_multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	vk_multisamplingInfo.sampleShadingEnable = VK_FALSE;
-	vk_multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	vk_multisamplingInfo.rasterizationSamples = m_msaaSamples;
 
 	//Setting up the depth and stencil buffers
 
@@ -446,7 +1590,7 @@ void VulkanGraphics::CreateAppDefaultPipelineFixedState(VkPipelineInputAssemblyS
 	fixedState.vk_colorBlendInfo = vk_colorBlendInfo;
 }
 
-void VulkanGraphics::ReadShaderFile(std::vector<char>& shaderCode, const char* shaderFilename)
+void VulkanGraphics::ReadShaderFile(std::vector<uint32_t>& shaderWords, const char* shaderFilename)
 {
 	std::ifstream shaderFile(shaderFilename, std::ios::ate | std::ios::binary);
 	if (!shaderFile.is_open())
@@ -454,40 +1598,26 @@ void VulkanGraphics::ReadShaderFile(std::vector<char>& shaderCode, const char* s
 		__debugbreak();
 	}
 
+	//SPIR-V is made of 32 bit words, a file of another size isn't SPIR-V
 	size_t filesize = static_cast<size_t>(shaderFile.tellg());
-	shaderCode.resize(filesize);
+	if (filesize == 0 || filesize % sizeof(uint32_t) != 0)
+	{
+		__debugbreak();
+	}
+	shaderWords.resize(filesize / sizeof(uint32_t));
 
 	shaderFile.seekg(0);
-	shaderFile.read(shaderCode.data(), filesize);
+	shaderFile.read(reinterpret_cast<char*>(shaderWords.data()), filesize);
 
 	shaderFile.close();
 }
 
 void VulkanGraphics::CreateShaderStages(VkShaderModule& vk_vertexShaderModule, VkShaderModule& vk_fragShaderModule,
 	VkPipelineShaderStageCreateInfo& vk_vertexShaderStageInfo, VkPipelineShaderStageCreateInfo& vk_fragShaderStageInfo,
-	std::vector<char>& vertexShaderCode, std::vector<char>& fragShaderCode, const VkDevice& vk_device)
+	const ShaderCode& vertexShaderCode, const ShaderCode& fragShaderCode, const VkDevice& vk_device)
 {
-	VkShaderModuleCreateInfo vk_vertexShaderModuleInfo{};
-	vk_vertexShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	vk_vertexShaderModuleInfo.codeSize = vertexShaderCode.size();
-	vk_vertexShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(vertexShaderCode.data());
-	VkResult vk_vertexShaderModuleCreationResult = vkCreateShaderModule(vk_device, &vk_vertexShaderModuleInfo,
-		nullptr, &vk_vertexShaderModule);
-	if (vk_vertexShaderModuleCreationResult != VK_SUCCESS)
-	{
-		__debugbreak();
-	}
-
-	VkShaderModuleCreateInfo vk_fragShaderModuleInfo{};
-	vk_fragShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	vk_fragShaderModuleInfo.codeSize = fragShaderCode.size();
-	vk_fragShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(fragShaderCode.data());
-	VkResult vk_fragShaderModuleCreationResult = vkCreateShaderModule(vk_device, &vk_fragShaderModuleInfo,
-		nullptr, &vk_fragShaderModule);
-	if (vk_fragShaderModuleCreationResult != VK_SUCCESS)
-	{
-		__debugbreak();
-	}
+	CreateVulkanShaderModule(vk_vertexShaderModule, vertexShaderCode, vk_device);
+	CreateVulkanShaderModule(vk_fragShaderModule, fragShaderCode, vk_device);
 	
 	vk_vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 	vk_vertexShaderStageInfo.module = vk_vertexShaderModule;
@@ -516,28 +1646,52 @@ void VulkanGraphics::CreateAppDefaultVkPipelineInfo(VkGraphicsPipelineCreateInfo
 	vk_pipelineInfo.pRasterizationState = &fixedState.vk_rasterizationInfo;
 	vk_pipelineInfo.pVertexInputState = &vk_vertexInputStateInfo;
 	vk_pipelineInfo.subpass = 0;
-	vk_pipelineInfo.renderPass = vk_renderPass;
+	vk_pipelineInfo.renderPass = m_renderGraph.GetRenderPass(m_mainRenderGraphPass);
 	vk_pipelineInfo.layout = vk_pipelineLayout;
 	vk_pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
 }
 
-void VulkanGraphics::CreateAppDefaultVkVertexInputInfo(VkPipelineVertexInputStateCreateInfo& vk_vertexInputInfo)
+void VulkanGraphics::CreateAppDefaultVkVertexInputInfo(VkPipelineVertexInputStateCreateInfo& vk_vertexInputInfo,
+	std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+	std::vector<VkVertexInputAttributeDescription>& attributeDescriptions)
 {
-	vk_vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vk_vertexInputInfo.vertexBindingDescriptionCount = 0;
-}
+	//The vertices are tightly packed in a single buffer, and the shader moves to the next one for every vertex
+	VertexLayout vertexLayout = GetVertexLayout(m_vertexFormat);
+	bindingDescriptions.resize(2);
+	bindingDescriptions[0].binding = 0;
+	bindingDescriptions[0].stride = vertexLayout.stride;
+	bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+	//The instances are in a second buffer, and the shader only moves to the next one for every instance
+	bindingDescriptions[1].binding = 1;
+	bindingDescriptions[1].stride = sizeof(InstanceData);
+	bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	/* Location 0 is the position and location 1 the color, like in the vertex shader. The formats come from the vertex 
+	   format, quantized attributes are converted back to floats by the vertex fetch */
+	attributeDescriptions.resize(4);
+	for (uint32_t location = 0; location < 2; ++location)
+	{
+		attributeDescriptions[location].binding = 0;
+		attributeDescriptions[location].location = location;
+		attributeDescriptions[location].format = vertexLayout.attributes[location].vk_format;
+		attributeDescriptions[location].offset = vertexLayout.attributes[location].offset;
+	}
+	//Location 2 is the transform of the instance (offset, scale and rotation) and location 3 its color
+	attributeDescriptions[2].binding = 1;
+	attributeDescriptions[2].location = 2;
+	attributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	attributeDescriptions[2].offset = offsetof(InstanceData, offset);
+	attributeDescriptions[3].binding = 1;
+	attributeDescriptions[3].location = 3;
+	attributeDescriptions[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	attributeDescriptions[3].offset = offsetof(InstanceData, color);
 
-void VulkanGraphics::CreateAppDefaultFramebufferInfo(VkFramebufferCreateInfo& vk_framebufferInfo, 
-	uint32_t imageViewIndex)
-{
-	vk_framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	vk_framebufferInfo.width = vk_imageExtent.width;
-	vk_framebufferInfo.height = vk_imageExtent.height;
-	vk_framebufferInfo.renderPass = vk_renderPass;
-	vk_framebufferInfo.layers = 1;
-	vk_framebufferInfo.attachmentCount = 1;
-	vk_framebufferInfo.pAttachments = &imageViews[imageViewIndex];
+	vk_vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vk_vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+	vk_vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
+	vk_vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+	vk_vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 }
 
 void VulkanGraphics::CreateAppDefaultVkCommandPoolInfo(VkCommandPoolCreateInfo& vk_commandPoolInfo,
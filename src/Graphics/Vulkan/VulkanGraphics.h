@@ -5,12 +5,28 @@
 #include <set>
 #include <string>
 #include <fstream>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <cstddef>
+#include <utility>
 #include "Window/Window.h"
+#include "Assets/MeshFile.h"
+#include "Assets/MeshPreprocessor.h"
+#include "VulkanMemoryAllocator.h"
 
 
 /* Functions that initialize and utilize the vulkan SDK instance objects. The instance object (VkInstance) is required 
    in order to interface with the vulkan SDK and for most cases only one instance will exist */
-void CreateVulkanInstance(VkInstance* vk_instance, VkInstanceCreateInfo& vk_instanceInfo);
+void CreateVulkanInstance(VkInstance* vk_instance, VkInstanceCreateInfo& vk_instanceInfo, 
+	const std::vector<const char*>& requiredInstanceExtensions);
+
+//Checks if the vulkan implementation supports the instance extension passed, used for extensions the application can do without
+bool CheckInstanceExtensionSupport(const char* instanceExtension);
 
 /* Function that calls on the window handle object to call the window specification's own function 
    to initialize the vulkan SDK surface object, need to interface with the window system  */
@@ -25,6 +41,11 @@ struct QueueFamilyIndices
 {
 	uint32_t graphics;
 	uint32_t present;
+	/* A family that supports transfer commands but not graphics or compute ones, usually the copy engine of a discrete card.
+	   If the graphics card has none this holds the graphics family, and uploads are recorded on the graphics queue instead */
+	uint32_t transfer;
+	//A family that supports compute commands but not graphics ones, for async compute. Holds the graphics family if there is none
+	uint32_t compute;
 };
 
 /* Helper struct that holds the swap chain support capabilities of a graphics card
@@ -38,15 +59,96 @@ struct SwapchainSupportDetails
 	std::vector<VkPresentModeKHR> presentModes;
 };
 
+//The environment variable that names the graphics card to use, by a part of its name or by its UUID
+constexpr const char* GRAPHICS_CARD_OVERRIDE_VARIABLE = "VKTRIANGLE_GRAPHICS_CARD";
+
+/* The environment variable that names a directory to read the compiled shaders from instead of using the ones embedded in
+   the executable, so that shaders can be changed during development without rebuilding */
+constexpr const char* SHADER_DIRECTORY_OVERRIDE_VARIABLE = "VKTRIANGLE_SHADER_DIRECTORY";
+
+//See VulkanShaderRegistry.h
+struct EmbeddedShader;
+
+/* The SPIR-V of a shader. It points into the executable when the shader is embedded, and otherwise holds the words read 
+   from the shader's file, which are read as words so that they are aligned the way shader modules need */
+struct ShaderCode
+{
+	const uint32_t* embeddedWords = nullptr;
+	size_t embeddedWordCount = 0;
+	std::vector<uint32_t> fileWords;
+
+	inline const uint32_t* GetWords() const { return fileWords.empty() ? embeddedWords : fileWords.data(); }
+
+	inline size_t GetSize() const { return (fileWords.empty() ? embeddedWordCount : fileWords.size()) * sizeof(uint32_t); }
+};
+
+//Creates a shader module around the SPIR-V of a shader
+void CreateVulkanShaderModule(VkShaderModule& vk_shaderModule, const ShaderCode& shaderCode, const VkDevice& vk_device);
+
+/* What the application knows about a graphics card when picking one. It is plain data, so that the selection can be run
+   against a list of made up cards as well as the ones vulkan enumerates */
+struct GraphicsCardCandidate
+{
+	VkPhysicalDevice vk_graphicsCard;
+	VkPhysicalDeviceProperties vk_properties;
+	/* The UUID that tells the card apart from the other cards of the system, even from ones of the same model. Only known
+	   with VK_KHR_get_physical_device_properties2, without it this holds the pipeline cache UUID, which is shared by cards
+	   of the same model and driver */
+	uint8_t deviceUUID[VK_UUID_SIZE];
+	//The size of the largest device local memory heap
+	VkDeviceSize deviceLocalMemory;
+	QueueFamilyIndices queueFamilies;
+	bool queueFamiliesSupported;
+	bool extensionsSupported;
+	bool swapchainSupported;
+};
+
 /* Function called to pick a physical device for vulkan to interface with (required to initialize the VkDevice object that
    will be referenced throughout the application). The function some of the details and features of the device that are of interest
-   to the application */
+   to the application. The graphics card with the highest score is picked, unless the override (or the environment 
+   variable when the override is empty) names a different one */
 void PickPhysicalDevice(const VkInstance& vk_instance, const VkSurfaceKHR& vk_surface, VkPhysicalDevice& vk_GraphicsCard,
 	QueueFamilyIndices& gpuQueueFamilyIndices, const std::vector<const char*>& requiredDeviceExtensions,
-	SwapchainSupportDetails& gpuSwapchainSupport);
+	SwapchainSupportDetails& gpuSwapchainSupport, const std::string& graphicsCardOverride, 
+	bool physicalDeviceProperties2Enabled);
+
+/* Picks a physical device for an application that renders offscreen without a window. Since nothing will be presented,
+   the graphics card only needs to support graphics commands and the device extensions that were passed */
+void PickHeadlessPhysicalDevice(const VkInstance& vk_instance, VkPhysicalDevice& vk_GraphicsCard,
+	QueueFamilyIndices& gpuQueueFamilyIndices, const std::vector<const char*>& requiredDeviceExtensions,
+	const std::string& graphicsCardOverride, bool physicalDeviceProperties2Enabled);
+
+/* Describes every graphics card of the instance and picks one with SelectGraphicsCard. Without a surface the cards don't 
+   need to present. The device UUIDs of the cards are only queried if the instance enabled 
+   VK_KHR_get_physical_device_properties2. Returns false if none of them can be used */
+bool PickScoredGraphicsCard(const VkInstance& vk_instance, const VkSurfaceKHR& vk_surface,
+	const std::vector<const char*>& requiredDeviceExtensions, const std::string& graphicsCardOverride,
+	bool physicalDeviceProperties2Enabled, GraphicsCardCandidate& pickedGraphicsCard);
+
+/* Queries the properties, memory heaps, queue families and support of a graphics card that the selection needs. The 
+   device UUID is queried through vk_getProperties2 if it isn't null */
+void DescribeGraphicsCard(const VkPhysicalDevice& vk_graphicsCard, const VkSurfaceKHR& vk_surface,
+	const std::vector<const char*>& requiredDeviceExtensions, PFN_vkGetPhysicalDeviceProperties2KHR vk_getProperties2,
+	GraphicsCardCandidate& candidate);
+
+/* Ranks a graphics card by its type, then by its device local memory, then by its dedicated transfer and compute 
+   families and its limits. Returns 0 if the card is missing something the application needs */
+uint64_t ScoreGraphicsCard(const GraphicsCardCandidate& candidate);
+
+//Checks if the override is the UUID of the card (its device UUID in hex) or a part of its name, ignoring case
+bool MatchesGraphicsCardOverride(const GraphicsCardCandidate& candidate, const std::string& graphicsCardOverride);
+
+/* Returns the index of the usable card that matches the override, or else of the card with the highest score, and logs the
+   score of every card and the decision. Returns -1 if none of the cards can be used */
+int32_t SelectGraphicsCard(const std::vector<GraphicsCardCandidate>& candidates, const std::string& graphicsCardOverride);
+
+/* Returns the index of a queue family that only supports transfer commands, so that copies can run in parallel with rendering.
+   Returns the graphics queue family index that was passed if the graphics card does not have one */
+uint32_t FindDedicatedTransferQueueFamily(const VkPhysicalDevice& vk_graphicsCard, uint32_t graphicsQueueFamilyIndex);
 
 /*Checks if the graphics card supports the queue families for the commands we need for our application and saves the indices 
-  in the queue family indices argument that was passed.*/
+  in the queue family indices argument that was passed. Records the dedicated transfer and compute families as well, and 
+  without a surface (VK_NULL_HANDLE) the graphics family doubles as the present family.*/
 bool CheckGraphicsCardQueueFamilies(const VkPhysicalDevice& vk_graphicsCard, QueueFamilyIndices& gpuQueueFamilyIndices, 
 	const VkSurfaceKHR& vk_surface);
 
@@ -78,7 +180,7 @@ void ChooseVulkanSurfaceFormat(VkSurfaceFormatKHR& vk_surfaceFormat,
 /*Checks the available present modes we retrieved from the graphics card and chooses the most suitable one for the application.
   The present modes are the conditions for swapping images to the screen */
 void ChooseVulkanSwapchainPresentMode(VkPresentModeKHR& vk_swapchainPresentMode,
-	const std::vector<VkPresentModeKHR>& availablePresentModes);
+	const std::vector<VkPresentModeKHR>& availablePresentModes, VkPresentModeKHR vk_preferredPresentMode);
 
 //Sets the swapchain extent according to the surface capabilities we retrieved for the graphics card
 void ChooseVulkanSwapchainExtent(VkExtent2D& vk_swapchainExtent, const VkSurfaceCapabilitiesKHR& vk_surfaceCapabilities,
@@ -90,6 +192,29 @@ void ChooseVulkanSwapchainExtent(VkExtent2D& vk_swapchainExtent, const VkSurface
 void CreateVulkanSwapchainImageViews(VkImageView& vk_imageView, const VkImageViewCreateInfo& vk_imageViewInfo,
 	const VkDevice& vk_device);
 
+/* Creates an image object owned by the application (unlike the swapchain images) and allocates the memory that will 
+   back it from the memory allocator. Large images like render targets should ask for a dedicated allocation */
+void CreateVulkanImage(VkImage& vk_image, VulkanAllocation& imageAllocation, const VkImageCreateInfo& vk_imageInfo,
+	VkMemoryPropertyFlags vk_memoryProperties, bool dedicated, const VkDevice& vk_device, 
+	VulkanMemoryAllocator& memoryAllocator);
+
+//A buffer object and the memory that backs it
+struct VulkanBuffer
+{
+	VkBuffer vk_buffer = VK_NULL_HANDLE;
+	VulkanAllocation allocation;
+	VkDeviceSize size = 0;
+};
+
+/* Creates a buffer object and allocates the memory that backs it from the memory allocator. If the memory is host visible
+   the allocator keeps it mapped, so the CPU can write to the buffer through its allocation's mapped data */
+void CreateVulkanBuffer(VulkanBuffer& buffer, VkDeviceSize size, VkBufferUsageFlags vk_bufferUsage,
+	VkMemoryPropertyFlags vk_requiredProperties, VkMemoryPropertyFlags vk_preferredProperties, 
+	VulkanAllocationStrategy strategy, const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator);
+
+//Destroys the buffer and gives its memory back to the allocator, the GPU needs to be done using it
+void DestroyVulkanBuffer(VulkanBuffer& buffer, const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator);
+
 /* Creates an pipeline layout which will be passed into a graphics pipeline object through info struct. The pipeline layout 
    will allow the application to pass uniform variables into a shader */
 void CreateVulkanGraphicsPipelineLayout(const VkPipelineLayoutCreateInfo& vk_pipelineLayoutInfo, const VkDevice& vk_device,
@@ -104,7 +229,12 @@ void CreateVulkanRenderPass(VkRenderPass& vk_renderPass, const VkRenderPassCreat
    The graphics pipeline is a series of operations that take vertices of the objects that are to be rendered all
    the way to pixels that are presented on screen*/
 void CreateVulkanGraphicsPipeline(VkPipeline& vk_graphicsPipeline, const VkGraphicsPipelineCreateInfo& vk_pipelineInfo,
-	const VkDevice& vk_device);
+	const VkDevice& vk_device, const VkPipelineCache& vk_pipelineCache);
+
+/* Creates a vulkan compute pipeline object. Compute pipelines only have a single shader stage and run outside of render 
+   passes, the application uses them to prepare work for the graphics pipeline on the GPU */
+void CreateVulkanComputePipeline(VkPipeline& vk_computePipeline, const VkComputePipelineCreateInfo& vk_pipelineInfo,
+	const VkDevice& vk_device, const VkPipelineCache& vk_pipelineCache);
 
 /* Creates a vulkan framebuffer object which references the image views that represent the attachments specified 
    in the render pass that was the application will use*/
@@ -121,9 +251,259 @@ void CreateVulkanCommandPool(VkCommandPool& vk_commandPool, const VkCommandPoolC
 void AllocateVulkanCommandBuffer(VkCommandBuffer& vk_commandBuffer,const VkDevice& vk_device, 
 	const VkCommandBufferAllocateInfo& vk_commandBufferInfo);
 
+//Allocates as many command buffers as the allocate info asks for into the array passed, which needs to hold that many
+void AllocateVulkanCommandBuffers(VkCommandBuffer* vk_commandBuffers, const VkDevice& vk_device, 
+	const VkCommandBufferAllocateInfo& vk_commandBufferInfo);
+
+/* Owns a handle created from the device and destroys it with the vkDestroy function of its type when it is reset, assigned
+   another handle or goes out of scope. It can only be moved, so every handle has a single owner. It converts to the handle
+   so that it can be passed to vulkan as it is. Handles that frames in flight may still be using are moved into the 
+   deletion queue instead of being reset */
+template<typename HandleType, void (VKAPI_PTR* DestroyFunction)(VkDevice, HandleType, const VkAllocationCallbacks*)>
+class VulkanHandle
+{
+public:
+	VulkanHandle()
+		:vk_device(VK_NULL_HANDLE), vk_handle(VK_NULL_HANDLE)
+	{
+
+	}
+
+	VulkanHandle(const VkDevice& device, HandleType handle)
+		:vk_device(device), vk_handle(handle)
+	{
+
+	}
+
+	VulkanHandle(VulkanHandle&& other) noexcept
+		:vk_device(other.vk_device), vk_handle(other.Release())
+	{
+
+	}
+
+	VulkanHandle& operator=(VulkanHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Reset();
+			vk_device = other.vk_device;
+			vk_handle = other.Release();
+		}
+		return *this;
+	}
+
+	VulkanHandle(const VulkanHandle&) = delete;
+	VulkanHandle& operator=(const VulkanHandle&) = delete;
+
+	~VulkanHandle()
+	{
+		Reset();
+	}
+
+	//Destroys the handle right away, the GPU needs to be done using it
+	void Reset()
+	{
+		if (vk_handle != VK_NULL_HANDLE)
+		{
+			DestroyFunction(vk_device, vk_handle, nullptr);
+			vk_handle = VK_NULL_HANDLE;
+		}
+	}
+
+	//Gives up the ownership of the handle without destroying it
+	HandleType Release()
+	{
+		HandleType handle = vk_handle;
+		vk_handle = VK_NULL_HANDLE;
+		return handle;
+	}
+
+	inline const VkDevice& GetDevice() const { return vk_device; }
+
+	inline const HandleType& Get() const { return vk_handle; }
+
+	//For the infos that point at arrays of handles, like the attachments of a framebuffer
+	inline const HandleType* GetAddress() const { return &vk_handle; }
+
+	inline operator HandleType() const { return vk_handle; }
+private:
+	VkDevice vk_device;
+	HandleType vk_handle;
+};
+
+using VulkanSwapchainHandle = VulkanHandle<VkSwapchainKHR, vkDestroySwapchainKHR>;
+using VulkanImageHandle = VulkanHandle<VkImage, vkDestroyImage>;
+using VulkanImageViewHandle = VulkanHandle<VkImageView, vkDestroyImageView>;
+using VulkanShaderModuleHandle = VulkanHandle<VkShaderModule, vkDestroyShaderModule>;
+using VulkanPipelineLayoutHandle = VulkanHandle<VkPipelineLayout, vkDestroyPipelineLayout>;
+using VulkanRenderPassHandle = VulkanHandle<VkRenderPass, vkDestroyRenderPass>;
+using VulkanPipelineHandle = VulkanHandle<VkPipeline, vkDestroyPipeline>;
+using VulkanFramebufferHandle = VulkanHandle<VkFramebuffer, vkDestroyFramebuffer>;
+using VulkanCommandPoolHandle = VulkanHandle<VkCommandPool, vkDestroyCommandPool>;
+using VulkanSemaphoreHandle = VulkanHandle<VkSemaphore, vkDestroySemaphore>;
+using VulkanFenceHandle = VulkanHandle<VkFence, vkDestroyFence>;
+
+//The layout of a vertex in the vertex buffer, it needs to match the inputs of the vertex shader
+struct Vertex
+{
+	float position[2];
+	float color[3];
+};
+
+//Storage types of quantized attributes, which tell their vertex input formats apart from the integers they hold
+struct HalfFloat
+{
+	uint16_t bits;
+};
+
+struct Unorm8
+{
+	uint8_t value;
+};
+
+/* A vertex with the same attributes as Vertex in 8 bytes instead of 20. The position is stored as half floats and the 
+   color as unorm8, with a fourth channel that the shader doesn't read, since vertex buffers always support that format */
+struct QuantizedVertex
+{
+	HalfFloat position[2];
+	Unorm8 color[4];
+};
+
+//The vertex input format of an attribute, deduced from the type of the vertex member that holds it
+template<typename AttributeType> struct VertexAttributeFormat;
+template<> struct VertexAttributeFormat<float[2]> { static constexpr VkFormat vk_format = VK_FORMAT_R32G32_SFLOAT; };
+template<> struct VertexAttributeFormat<float[3]> { static constexpr VkFormat vk_format = VK_FORMAT_R32G32B32_SFLOAT; };
+template<> struct VertexAttributeFormat<float[4]> { static constexpr VkFormat vk_format = VK_FORMAT_R32G32B32A32_SFLOAT; };
+template<> struct VertexAttributeFormat<HalfFloat[2]> { static constexpr VkFormat vk_format = VK_FORMAT_R16G16_SFLOAT; };
+template<> struct VertexAttributeFormat<HalfFloat[4]> 
+{ 
+	static constexpr VkFormat vk_format = VK_FORMAT_R16G16B16A16_SFLOAT; 
+};
+template<> struct VertexAttributeFormat<Unorm8[4]> { static constexpr VkFormat vk_format = VK_FORMAT_R8G8B8A8_UNORM; };
+
+//Where an attribute is in a vertex and the format it is read with
+struct VertexAttributeLayout
+{
+	VkFormat vk_format;
+	uint32_t offset;
+};
+
+//Fills the layout of a member of a vertex, the format follows from the type of the member
+#define VERTEX_ATTRIBUTE_LAYOUT(VertexType, member) \
+	VertexAttributeLayout{ VertexAttributeFormat<decltype(VertexType::member)>::vk_format, \
+		static_cast<uint32_t>(offsetof(VertexType, member)) }
+
+/* The layouts the vertices of a mesh can be stored in. The format of the mesh needs to be chosen before the graphics are
+   initialized, since the graphics pipeline is created with its vertex input state */
+enum class VertexFormat : uint32_t
+{
+	Float,
+	Quantized
+};
+
+//The attributes are in the order of the locations of the vertex shader, the position and then the color
+struct VertexLayout
+{
+	uint32_t stride;
+	VertexAttributeLayout attributes[2];
+};
+
+VertexLayout GetVertexLayout(VertexFormat format);
+
+//Quantizes the attributes of the vertices into the layout of QuantizedVertex
+void QuantizeVertices(const std::vector<Vertex>& vertices, std::vector<QuantizedVertex>& quantizedVertices);
+
+/* The per instance data of the instanced draw, read by the vertex shader from the second vertex binding. The offset,
+   scale and rotation (in radians) are read as a single vec4, and the color multiplies the color of the vertices */
+struct InstanceData
+{
+	float offset[2];
+	float scale;
+	float rotation;
+	float color[4];
+};
+
+/* The arguments of an indirect draw as the culling pass writes them. The draw count follows the draw command, so that the
+   count variant of the indirect draw can read it from the same buffer */
+struct GpuDrawArguments
+{
+	VkDrawIndexedIndirectCommand vk_drawCommand;
+	uint32_t drawCount;
+};
+
+/* The per draw constants of the graphics pipeline, small enough to be pushed with the draw instead of going through memory. 
+   The view transform moves the whole scene, the offset is in xy and the scale in zw. The material is the bindless handle
+   of the buffer that holds the draw's material */
+struct DrawPushConstants
+{
+	float viewTransform[4];
+	uint32_t materialHandle;
+};
+
+/* The smallest magnitude of the view scale. A zero scale collapses the scene to a point, and the culling pass divides by
+   the scale to move the frustum back through the view transform */
+constexpr float MIN_VIEW_SCALE = 1e-6f;
+
+//The material that the fragment shader reads from the bindless buffer array
+struct MaterialData
+{
+	float color[4];
+};
+
+//The per frame constants of the graphics pipeline, read from the frame constant ring with a dynamic offset
+struct FrameUniforms
+{
+	//Multiplies the color of every fragment, used to fade or tint the whole frame
+	float colorScale[4];
+	//The size of the render target in pixels
+	float resolution[2];
+	//The seconds since the graphics were initialized
+	float time;
+	float padding;
+};
+
+//The buffers of the mesh that a render pass draws and of its instances. Nothing is drawn while the index count is 0
+struct MeshBuffers
+{
+	VkBuffer vk_vertexBuffer;
+	VkBuffer vk_indexBuffer;
+	uint32_t indexCount;
+	VkBuffer vk_instanceBuffer;
+	/* If the instances were culled on the GPU, the draw reads its arguments from this buffer instead (a GpuDrawArguments).
+	   The count variant of the indirect draw is used when the device supports it, otherwise the function is null */
+	VkBuffer vk_drawArgumentsBuffer;
+	PFN_vkCmdDrawIndexedIndirectCountKHR vk_drawIndexedIndirectCount;
+	/* The constants and resources of the draw, bound with the draw state: the frame's uniforms at their dynamic offset, the
+	   bindless resource table and the push constants */
+	VkPipelineLayout vk_pipelineLayout;
+	VkDescriptorSet vk_frameDescriptorSet;
+	uint32_t frameUniformOffset;
+	VkDescriptorSet vk_bindlessDescriptorSet;
+	DrawPushConstants drawConstants;
+};
+
+//Records a whole command buffer that only holds the render pass recorded by RecordRenderPassCommands
 void RecordCommandBuffer(const VkCommandBufferBeginInfo& vk_commandBufferBegin, const VkRenderPassBeginInfo& vk_renderPassBegin, 
 	const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline,
-	const VkExtent2D vk_imageExtent);
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh);
+
+/* Records the render pass of a frame into a command buffer that has already begun, so that the caller can record
+   other commands (like queries) around it */
+void RecordRenderPassCommands(const VkRenderPassBeginInfo& vk_renderPassBegin, const VkCommandBuffer& vk_commandBuffer, 
+	const VkPipeline& vk_graphicsPipeline, const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, 
+	uint32_t instanceCount);
+
+/* Records the draw of the mesh and its instances (or nothing while the mesh has no indices) into a command buffer that is 
+   already inside a render pass */
+void RecordMeshDraws(const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline, 
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, uint32_t instanceCount);
+
+/* Records draws of a range of the mesh's instances, each draw covering up to the amount of instances passed, into a 
+   command buffer that is already inside a render pass (like a secondary command buffer that continues one). Used when 
+   every object is its own draw, which is where recording on several threads pays off */
+void RecordInstanceRangeDraws(const VkCommandBuffer& vk_commandBuffer, const VkPipeline& vk_graphicsPipeline,
+	const VkExtent2D vk_imageExtent, const MeshBuffers& mesh, uint32_t firstInstance, uint32_t instanceCount,
+	uint32_t instancesPerDraw);
 
 
 void CreateVulkanCommandBufferBeginInfo(VkCommandBufferBeginInfo& vk_commandBufferBegin,
@@ -138,25 +518,947 @@ void CreateVulkanSubmitInfo(VkSubmitInfo& vk_submitInfo, uint32_t waitSemaphoreC
 	uint32_t signalSemaphoreCount, VkSemaphore* vk_signalSemaphores);
 
 void CreateVulkanPresentInfo(VkPresentInfoKHR& vk_presentInfo, uint32_t waitSemaphoreCount, VkSemaphore* vk_waitSemaphores,
-	uint32_t swapchainCount, VkSwapchainKHR* vk_swapchains, uint32_t imageIndex);
+	uint32_t swapchainCount, VkSwapchainKHR* vk_swapchains, const uint32_t& imageIndex);
+
 
 
+//The amount of frames the CPU is allowed to record ahead of the GPU if the application does not ask for a different one
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+/* Holds the objects that a single frame in flight needs, so that the CPU can record a new frame into its own command buffer
+   while the GPU is still executing the command buffers of the previous frames */
+struct FrameInFlightData
+{
+	VkCommandBuffer vk_commandBuffer = VK_NULL_HANDLE;
+	VulkanSemaphoreHandle vk_imageAvailableSemaphore;
+	VulkanSemaphoreHandle vk_renderFinishedSemaphore;
+	VulkanFenceHandle vk_framesInFlightFence;
+};
 
+/* Ring of frames in flight. Each slot is reused only after its fence has been signaled, and each swapchain image remembers 
+   the fence of the frame that last rendered to it, so that two frames never render to the same image at the same time */
 class VulkanSyncObjects
 {
 public:
 	VulkanSyncObjects();
 	~VulkanSyncObjects();
 
-	void CreateSyncObjects(const VkDevice& vk_device);
+	/* Creates the semaphores and fences of every slot in the ring. The command buffers of each slot are allocated 
+	   separately since they need the command pool of the application */
+	void CreateSyncObjects(const VkDevice& vk_device, uint32_t framesInFlight, uint32_t swapchainImageCount);
 	
 	void Cleanup(const VkDevice& vk_device);
+
+	//Returns the slot of the ring that the next frame will be recorded to
+	inline FrameInFlightData& GetCurrentFrame() { return frames[currentFrame]; }
+
+	inline uint32_t GetCurrentFrameIndex() const { return currentFrame; }
+
+	inline uint32_t GetFramesInFlightCount() const { return static_cast<uint32_t>(frames.size()); }
+
+	//Called after a frame has been submitted to move on to the next slot of the ring
+	inline void AdvanceFrame() { currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size()); }
+public:
+	std::vector<FrameInFlightData> frames;
+	//Holds the fence of the frame that is currently rendering to each swapchain image, or VK_NULL_HANDLE if there is none
+	std::vector<VkFence> imagesInFlight;
+	uint32_t currentFrame;
+};
+
+/* Destroys the resources that frames in flight may still be using once the GPU is done with them, so that they can be
+   replaced without waiting for the frames in flight. A retired resource goes into the list of the frame slot that last 
+   began, since only the frames that began before it was retired can be using it. The list is destroyed when the slot 
+   begins again, after its fence was waited on. A fence also covers everything submitted to the queue before it, so the 
+   frames of the other slots that began before the resource was retired have finished as well */
+class VulkanDeletionQueue
+{
 public:
-	VkSemaphore vk_imageAvailableSemaphore;
-	VkSemaphore vk_renderFinishedSemaphore;
-	VkFence vk_framesInFlightFence;
+	VulkanDeletionQueue();
+	~VulkanDeletionQueue();
+
+	void Init(const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator, uint32_t framesInFlight);
+
+	//Called once the fence of the slot was waited on, destroys what was retired while the slot was the last one to begin
+	void BeginFrame(uint32_t frameIndex);
+
+	//Takes the handle and destroys it once the frames in flight are done with it
+	template<typename HandleType, void (VKAPI_PTR* DestroyFunction)(VkDevice, HandleType, const VkAllocationCallbacks*)>
+	void Retire(VulkanHandle<HandleType, DestroyFunction>&& handle)
+	{
+		if (handle.Get() == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		VkDevice vk_handleDevice = handle.GetDevice();
+		HandleType vk_handle = handle.Release();
+		Retire([vk_handleDevice, vk_handle]() { DestroyFunction(vk_handleDevice, vk_handle, nullptr); });
+	}
+
+	//Retires every handle of the array and leaves it empty
+	template<typename HandleType, void (VKAPI_PTR* DestroyFunction)(VkDevice, HandleType, const VkAllocationCallbacks*)>
+	void Retire(std::vector<VulkanHandle<HandleType, DestroyFunction>>& handles)
+	{
+		for (VulkanHandle<HandleType, DestroyFunction>& handle : handles)
+		{
+			Retire(std::move(handle));
+		}
+		handles.clear();
+	}
+
+	//Takes the buffer, leaving it empty, and destroys it and frees its memory once the frames in flight are done with it
+	void Retire(VulkanBuffer& buffer);
+
+	//Calls the function passed once the frames in flight are done, for resources that are not destroyed on their own
+	void Retire(std::function<void()> destroy);
+
+	//Destroys everything that was retired, the frames in flight need to have finished
+	void Flush();
+
+	void Cleanup();
+private:
+	VkDevice vk_device;
+	VulkanMemoryAllocator* m_memoryAllocator;
+	//The resources retired while each frame slot was the last one to begin, destroyed when the slot begins again
+	std::vector<std::vector<std::function<void()>>> m_retired;
+	uint32_t m_currentFrame;
+};
+
+
+/* How a pass of the render graph uses a resource. Each access stands for the pipeline stages and memory accesses it is 
+   made with and, for images, the layout the image needs to be in, which is all the graph derives its barriers from */
+enum class RenderGraphAccess : uint32_t
+{
+	ColorAttachment,
+	DepthStencilAttachment,
+	FragmentShaderRead,
+	ComputeShaderRead,
+	ComputeShaderWrite,
+	IndirectCommandRead,
+	VertexAttributeRead,
+	TransferRead,
+	TransferWrite
 };
 
+//The stages, accesses and image layout of an access, and whether the access writes to the resource
+struct RenderGraphAccessInfo
+{
+	VkPipelineStageFlags vk_stages;
+	VkAccessFlags vk_access;
+	VkImageLayout vk_layout;
+	bool write;
+};
+
+RenderGraphAccessInfo GetRenderGraphAccessInfo(RenderGraphAccess access);
+
+//The format of an image of the render graph, its extent is the one the attachments of the graph are created with
+struct RenderGraphImageInfo
+{
+	VkFormat vk_format;
+	VkSampleCountFlagBits vk_samples;
+	VkImageAspectFlags vk_aspect;
+};
+
+/* What a pass of the render graph records with. A graphics pass begins its render pass with the begin info, so that it
+   can choose how the contents of the render pass are recorded. The begin info is empty for the other passes */
+struct RenderGraphPassContext
+{
+	VkCommandBuffer vk_commandBuffer;
+	uint32_t frameIndex;
+	uint32_t imageIndex;
+	VkRenderPassBeginInfo vk_renderPassBegin;
+};
+
+/* Records the passes of a frame from what each of them declared it reads and writes, instead of hand-written barriers and
+   render passes. The passes are declared once and compiled: the passes that don't contribute to an output are culled, 
+   each graphics pass gets a render pass whose load and store operations follow from the passes before and after it, and
+   the barriers between the passes are derived from the accesses. A barrier is only placed where a resource is written 
+   after being used, read after a write it has not seen yet, or needs a different layout, and the barriers before a pass 
+   are batched into a single vkCmdPipelineBarrier. The passes are recorded in the order they were added.
+   Transient images only live within a frame. The ones whose lifetimes don't overlap share memory, and the ones that never
+   leave their render pass are created as transient attachments in lazily allocated memory where the device has it, so 
+   that tiled GPUs never back them with memory */
+class VulkanRenderGraph
+{
+public:
+	using RecordFunction = std::function<void(const RenderGraphPassContext& context)>;
+
+	VulkanRenderGraph();
+	~VulkanRenderGraph();
+
+	void Init(const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator);
+
+	//Declares an image that only lives within a frame and is created by the graph, returns the index of the resource
+	uint32_t AddTransientImage(const char* name, const RenderGraphImageInfo& imageInfo);
+
+	/* Declares an image that is created outside of the graph, like the render target. Imported images are outputs of the 
+	   graph and are left in the final layout at the end of the frame. Their contents are discarded at the start of a frame
+	   and their first use waits for the stages passed, the ones the semaphore that guards the image is waited on with */
+	uint32_t ImportImage(const char* name, const RenderGraphImageInfo& imageInfo, VkImageLayout vk_finalLayout, 
+		VkPipelineStageFlags vk_initialStages);
+
+	//Declares a buffer that is created outside of the graph. Only the accesses of the passes to it are synchronized
+	uint32_t ImportBuffer(const char* name);
+
+	//The passes that write to an output are never culled
+	void MarkOutput(uint32_t resource);
+
+	//A graphics pass gets a render pass with the attachments it uses, the other passes record outside of render passes
+	uint32_t AddPass(const char* name, bool graphics, RecordFunction record);
+
+	//A pass can use a resource with several accesses, as long as they agree on the layout of an image
+	void Use(uint32_t pass, uint32_t resource, RenderGraphAccess access);
+
+	//The attachment is cleared to the value passed when the render pass of the pass begins, instead of being loaded
+	void ClearAttachment(uint32_t pass, uint32_t resource, const VkClearValue& vk_clearValue);
+
+	/* The multisampled color attachment source is resolved into the single sampled color attachment destination at the 
+	   end of the subpass of the pass. Both need to be used by the pass as color attachments first. The destination is 
+	   written as a whole, so it is neither loaded nor cleared */
+	void ResolveAttachment(uint32_t pass, uint32_t source, uint32_t destination);
+
+	/* Culls the passes, creates the render passes and derives the barriers. Called once every pass has been added, the
+	   render passes can then be used to create the pipelines with */
+	void Compile();
+
+	/* Sets the images (and their views) that an imported image stands for. A frame uses the image at its image index, 
+	   which is the index of the swapchain image for the render target */
+	void SetImportedImages(uint32_t resource, const std::vector<VkImage>& images, const std::vector<VkImageView>& imageViews);
+
+	//Creates the transient images and the framebuffers of the graphics passes with the extent passed
+	void CreateAttachments(const VkExtent2D& vk_extent);
+
+	/* Retires the transient images, their memory and the framebuffers to the deletion queue, since the frames in flight 
+	   may still be using them. Called before the attachments are created again with a different extent */
+	void ReleaseAttachments(VulkanDeletionQueue& deletionQueue);
+
+	//Records the passes that were not culled into a command buffer that has already begun, with the barriers between them
+	void Execute(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t imageIndex);
+
+	void Cleanup();
+
+	inline VkRenderPass GetRenderPass(uint32_t pass) const { return m_passes[pass].vk_renderPass; }
+
+	inline bool IsPassCulled(uint32_t pass) const { return m_passes[pass].culled; }
+
+	//The amount of vkCmdPipelineBarrier calls recorded every frame
+	inline uint32_t GetBarrierCount() const { return m_barrierCount; }
+
+	//The memory that backs the transient images, less than their total size when they share memory
+	inline VkDeviceSize GetTransientMemorySize() const { return m_transientMemorySize; }
+private:
+	struct Resource
+	{
+		std::string name;
+		bool image;
+		bool imported;
+		bool output;
+		RenderGraphImageInfo imageInfo;
+		VkImageLayout vk_finalLayout;
+		VkPipelineStageFlags vk_initialStages;
+		//The images an imported image stands for and their views
+		std::vector<VkImage> importedImages;
+		std::vector<VkImageView> importedViews;
+		/* The usage of a transient image, the first and last pass that use it and the memory slot it shares with the other 
+		   transient images. A transient image that no pass uses after culling has no passes and is not created */
+		VkImageUsageFlags vk_usage;
+		uint32_t firstPass;
+		uint32_t lastPass;
+		uint32_t memorySlot;
+		VulkanImageHandle vk_image;
+		VulkanImageViewHandle vk_imageView;
+	};
+
+	/* The accesses of a pass to a resource merged together, the value the resource is cleared to if it is an attachment 
+	   and the attachment it is resolved from, UINT32_MAX if it is not a resolve attachment */
+	struct PassUse
+	{
+		uint32_t resource;
+		RenderGraphAccessInfo accessInfo;
+		bool clear;
+		VkClearValue vk_clearValue;
+		uint32_t resolveSource;
+	};
+
+	struct ImageTransition
+	{
+		uint32_t resource;
+		VkImageLayout vk_oldLayout;
+		VkImageLayout vk_newLayout;
+		VkAccessFlags vk_srcAccess;
+		VkAccessFlags vk_dstAccess;
+	};
+
+	//The barriers recorded before a pass. The buffers are covered by a single memory barrier, the images have their own
+	struct BarrierBatch
+	{
+		VkPipelineStageFlags vk_srcStages = 0;
+		VkPipelineStageFlags vk_dstStages = 0;
+		VkAccessFlags vk_srcAccess = 0;
+		VkAccessFlags vk_dstAccess = 0;
+		std::vector<ImageTransition> imageTransitions;
+	};
+
+	struct Pass
+	{
+		std::string name;
+		bool graphics;
+		RecordFunction record;
+		std::vector<PassUse> uses;
+		bool culled;
+		BarrierBatch barriers;
+		//The resources of the attachments in the order of the render pass, and the values they are cleared to
+		std::vector<uint32_t> attachments;
+		std::vector<VkClearValue> clearValues;
+		VulkanRenderPassHandle vk_renderPass;
+		//A framebuffer for each of the images of the imported attachments
+		std::vector<VulkanFramebufferHandle> framebuffers;
+	};
+
+	//The memory shared by transient images whose lifetimes don't overlap, in the order they use it in a frame
+	struct MemorySlot
+	{
+		std::vector<uint32_t> resources;
+		VulkanAllocation allocation;
+	};
+
+	/* The state a resource was left in by the accesses so far. The write stages are those of the last write (or of the 
+	   accesses the write has to wait for at the start of the frame), the read stages those of the reads since then, and 
+	   the visible stages and accesses the ones the last write has been made visible to */
+	struct ResourceState
+	{
+		VkImageLayout vk_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags vk_writeStages = 0;
+		VkAccessFlags vk_writeAccess = 0;
+		VkPipelineStageFlags vk_readStages = 0;
+		VkPipelineStageFlags vk_visibleStages = 0;
+		VkAccessFlags vk_visibleAccess = 0;
+	};
+
+	//Culls the passes that none of the outputs depend on, walking back from the last pass
+	void CullPasses();
+
+	//Finds the lifetimes and the usage of the transient images and the memory slots they share
+	void AssignTransientImages();
+
+	//Creates the render pass of a graphics pass, the load and store operations follow from the passes around it
+	void CreateRenderPass(uint32_t passIndex);
+
+	/* Applies the accesses of every pass to the states of the resources, starting from the states passed. Adds the barriers
+	   that the accesses need to the batches of the passes if asked to */
+	void ApplyAccesses(std::vector<ResourceState>& states, bool addBarriers);
+
+	//Adds the barrier that an access needs after the state passed to the batch, if it needs one, and updates the state
+	void ApplyAccess(ResourceState& state, uint32_t resource, const RenderGraphAccessInfo& accessInfo, BarrierBatch* batch);
+
+	void DeriveBarriers();
+
+	void RecordBarriers(const VkCommandBuffer& vk_commandBuffer, const BarrierBatch& batch, uint32_t imageIndex);
+
+	VkImage GetImage(uint32_t resource, uint32_t imageIndex) const;
+private:
+	VkDevice vk_device;
+	VulkanMemoryAllocator* m_memoryAllocator;
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::vector<MemorySlot> m_memorySlots;
+	//The transitions of the imported images to their final layouts, recorded after the last pass
+	BarrierBatch m_finalBarriers;
+	VkExtent2D vk_extent;
+	uint32_t m_barrierCount;
+	VkDeviceSize m_transientMemorySize;
+	//Filled with the image barriers of a batch when it is recorded, kept around so it isn't reallocated every frame
+	std::vector<VkImageMemoryBarrier> m_imageBarriers;
+};
+
+
+//The size of the staging ring that uploads go through, unless the upload queue is told otherwise
+constexpr VkDeviceSize DEFAULT_STAGING_RING_SIZE = 16ull * 1024 * 1024;
+
+/* Streams data into device local buffers without stalling the render loop. The data is copied into a persistently mapped
+   staging ring and the copies queued during a frame are submitted together, on the dedicated transfer queue if the graphics
+   card has one. A frame slot's part of the ring is reclaimed when the slot is reused (after its fence has signaled), so
+   queueing an upload never waits on the GPU. Data that does not fit in the ring waits on the CPU and is streamed in chunks
+   over the next frames */
+class VulkanUploadQueue
+{
+public:
+	VulkanUploadQueue();
+	~VulkanUploadQueue();
+
+	void Init(const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator, const QueueFamilyIndices& gpuQueueFamilies,
+		const VkQueue& vk_transferQueue, uint32_t framesInFlight, VkDeviceSize ringSize = DEFAULT_STAGING_RING_SIZE);
+
+	/* Queues a copy of the data into a buffer that was created with the transfer dst usage. The data is copied before the
+	   function returns. The ticket that is returned can be compared with the submitted ticket to find out when the buffer 
+	   holds the data. Each range of a buffer should be uploaded while no frame in flight is reading it */
+	uint64_t QueueBufferUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+	/* Like QueueBufferUpload, but data that does not fit in the ring is streamed into it straight from where it is instead
+	   of being copied to the CPU first, which suits data that is mapped from a file. The data needs to stay valid and 
+	   unchanged until the submitted ticket reaches the ticket that is returned, or until the buffer's uploads are discarded */
+	uint64_t QueueBorrowedBufferUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data, 
+		VkDeviceSize size);
+
+	//Drops the uploads to a buffer that have not been submitted yet, needs to be called before the buffer is destroyed
+	void DiscardBufferUploads(const VkBuffer& vk_dstBuffer);
+
+	/* Called once per frame, after the fence of the frame slot has signaled and its graphics command buffer has begun, outside 
+	   of a render pass. Submits the copies queued since the previous frame and records the barriers that make them visible to 
+	   vertex input and the fragment shader. Returns the semaphore that the graphics submission needs to wait on, or VK_NULL_HANDLE if there is none */
+	VkSemaphore Flush(const VkCommandBuffer& vk_graphicsCommandBuffer, uint32_t frameIndex);
+
+	/* Every upload with a ticket up to this one has been submitted by the latest flush, so a frame that is recorded after
+	   that flush can read its data */
+	inline uint64_t GetSubmittedTicket() const { return m_submittedTicket; }
+
+	inline bool HasPendingUploads() const { return !m_pendingUploads.empty(); }
+
+	inline bool UsesDedicatedTransferQueue() const { return m_dedicatedTransferQueue; }
+
+	void Cleanup();
+private:
+	/* An upload that did not fit in the ring, the part of it that has not been copied into the ring yet is streamed later.
+	   The data is either a copy that the upload owns or borrowed from the caller, in which case the copy stays empty */
+	struct PendingUpload
+	{
+		VkBuffer vk_dstBuffer;
+		VkDeviceSize dstOffset;
+		std::vector<char> ownedData;
+		const char* borrowedData;
+		VkDeviceSize size;
+		VkDeviceSize uploadedBytes;
+		uint64_t ticket;
+	};
+
+	//A copy from the staging ring to a destination buffer that will be recorded by the next flush
+	struct UploadRegion
+	{
+		VkBuffer vk_dstBuffer;
+		VkBufferCopy vk_copy;
+	};
+
+	//The objects that the uploads of a frame slot use, and the part of the ring that its copies read from
+	struct UploadFrame
+	{
+		VkCommandBuffer vk_commandBuffer = VK_NULL_HANDLE;
+		VkSemaphore vk_uploadFinishedSemaphore = VK_NULL_HANDLE;
+		VkDeviceSize ringBytes = 0;
+	};
+
+	uint64_t QueueUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size, 
+		bool borrowData);
+
+	//Reserves a contiguous range of the ring, returns false if it won't fit until a frame slot gives its range back
+	bool ReserveRingRange(VkDeviceSize size, VkDeviceSize& ringOffset);
+
+	//Copies as much of the pending uploads into the ring as fits, in the order they were queued
+	void StreamPendingUploads();
+
+	void RecordCopies(const VkCommandBuffer& vk_commandBuffer);
+
+	/* Fills a barrier for each copy region. With a dedicated transfer queue the same barriers release the ranges from the 
+	   transfer family and acquire them on the graphics family */
+	void CreateUploadBarriers(std::vector<VkBufferMemoryBarrier>& barriers, VkAccessFlags vk_srcAccess, 
+		VkAccessFlags vk_dstAccess);
+private:
+	VkDevice vk_device;
+	VulkanMemoryAllocator* m_memoryAllocator;
+
+	uint32_t m_graphicsQueueFamily;
+	uint32_t m_transferQueueFamily;
+	bool m_dedicatedTransferQueue;
+	VkQueue vk_transferQueue;
+	VkCommandPool vk_transferCommandPool;
+	std::vector<UploadFrame> m_frames;
+
+	VulkanBuffer m_stagingRing;
+	//The largest range a single copy takes from the ring, so that a large upload can't take up the whole ring
+	VkDeviceSize m_maxChunkSize;
+	VkDeviceSize m_ringHead;
+	VkDeviceSize m_ringUsedBytes;
+	//The bytes reserved since the last flush, they are given back when the slot of the next flush is reused
+	VkDeviceSize m_unflushedRingBytes;
+
+	std::vector<UploadRegion> m_regions;
+	std::deque<PendingUpload> m_pendingUploads;
+	uint64_t m_nextTicket;
+	uint64_t m_submittedTicket;
+};
+
+
+//The amount of objects that each invocation group of the culling shader tests, needs to match the shader's local size
+constexpr uint32_t CULLING_GROUP_SIZE = 64;
+
+//The push constants of the culling shader, the frustum planes are stored as a normal pointing inside and a distance
+struct CullingPushConstants
+{
+	float frustumPlanes[6][4];
+	uint32_t objectCount;
+	float meshRadius;
+};
+
+/* Compute pre-pass that tests the bounding sphere of every instance against the view frustum and compacts the visible ones
+   into a separate instance buffer, writing their amount into the arguments of an indirect draw. The CPU never looks at
+   individual objects, so the cost of a frame on the CPU does not depend on the amount of objects. Each frame slot has its
+   own descriptor set, visible instance buffer and draw arguments */
+class VulkanCullingPass
+{
+public:
+	VulkanCullingPass();
+	~VulkanCullingPass();
+
+	//Creates the pipeline layout and the descriptor sets and draw arguments of every frame slot
+	void Init(const VkDevice& vk_device, VulkanMemoryAllocator& memoryAllocator, uint32_t framesInFlight);
+
+	/* Compiles the compute pipeline from the SPIR-V code of the culling shader and returns it. Only reads the device and the
+	   pipeline layout, so it can run on a worker thread while the pass is used for something else */
+	VkPipeline CompilePipeline(const VkPipelineCache& vk_pipelineCache, const ShaderCode& cullingShaderCode) const;
+
+	/* Hands the compiled pipeline to the pass, which destroys it on cleanup. The pass can't record before it has one. 
+	   Returns the pipeline it replaces, which the frames in flight may still be using */
+	inline VulkanPipelineHandle SetPipeline(VulkanPipelineHandle&& pipeline) 
+	{ 
+		std::swap(vk_cullingPipeline, pipeline);
+		return std::move(pipeline);
+	}
+
+	inline bool IsReady() const { return vk_cullingPipeline != VK_NULL_HANDLE; }
+
+	/* Creates the visible instance buffers with the capacity passed and points the descriptor set of each slot at the slot's 
+	   instance buffer. None of the frames in flight can be using the pass when this is called */
+	void SetInstanceBuffers(const std::vector<VulkanBuffer>& instanceBuffers, uint32_t instanceCapacity);
+
+	/* Records the culling of the slot's instances into a command buffer, outside of a render pass. Resets the draw arguments 
+	   and dispatches the culling shader, the render graph makes its results visible to the passes that read them */
+	void RecordCulling(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t instanceCount,
+		uint32_t indexCount, float meshRadius, const float viewTransform[4]);
+
+	inline const VkBuffer& GetVisibleInstanceBuffer(uint32_t frameIndex) const 
+	{ return m_frames[frameIndex].visibleInstances.vk_buffer; }
+
+	inline const VkBuffer& GetDrawArgumentsBuffer(uint32_t frameIndex) const 
+	{ return m_frames[frameIndex].drawArguments.vk_buffer; }
+
+	void Cleanup();
+private:
+	struct CullingFrame
+	{
+		VkDescriptorSet vk_descriptorSet = VK_NULL_HANDLE;
+		VulkanBuffer visibleInstances;
+		VulkanBuffer drawArguments;
+	};
+private:
+	VkDevice vk_device;
+	VulkanMemoryAllocator* m_memoryAllocator;
+
+	VkDescriptorSetLayout vk_descriptorSetLayout;
+	VkDescriptorPool vk_descriptorPool;
+	VkPipelineLayout vk_pipelineLayout;
+	VulkanPipelineHandle vk_cullingPipeline;
+	std::vector<CullingFrame> m_frames;
+};
+
+
+//The size of each frame slot's part of the frame constant ring, unless the graphics are told otherwise
+constexpr VkDeviceSize DEFAULT_FRAME_CONSTANTS_SIZE = 64ull * 1024;
+
+/* Gets per frame constant data to the shaders without allocating or updating descriptors while recording. The data is 
+   copied into a persistently mapped ring and bound with the dynamic offset of a VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+   descriptor, whose single set covers the whole ring and is never written again after Init. Each frame slot has its own 
+   part of the ring, which is recycled when the slot is reused (after its fence has signaled) */
+class VulkanFrameConstants
+{
+public:
+	VulkanFrameConstants();
+	~VulkanFrameConstants();
+
+	/* Creates the ring with the size passed for each frame slot, and the descriptor set that binds blocks of up to the 
+	   block size passed */
+	void Init(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard, VulkanMemoryAllocator& memoryAllocator,
+		uint32_t framesInFlight, VkDeviceSize frameSize, uint32_t blockSize);
+
+	//Starts writing the slot's part of the ring from its beginning, the GPU needs to be done with the frame that last used it
+	void BeginFrame(uint32_t frameIndex);
+
+	/* Copies a block of constants into the slot's part of the ring and returns the dynamic offset to bind it with. A block
+	   costs one memcpy, the first block of a frame always lands at the start of the slot's part of the ring */
+	uint32_t Write(uint32_t frameIndex, const void* data, uint32_t size);
+
+	template<typename T>
+	inline uint32_t Write(uint32_t frameIndex, const T& data) { return Write(frameIndex, &data, sizeof(T)); }
+
+	inline const VkDescriptorSetLayout& GetDescriptorSetLayout() const { return vk_descriptorSetLayout; }
+
+	inline const VkDescriptorSet& GetDescriptorSet() const { return vk_descriptorSet; }
+
+	void Cleanup();
+private:
+	struct ConstantsFrame
+	{
+		//The offset in the ring where the next block of the frame is written
+		VkDeviceSize writeOffset = 0;
+	};
+private:
+	VkDevice vk_device;
+	VulkanMemoryAllocator* m_memoryAllocator;
+
+	VulkanBuffer m_ring;
+	VkDeviceSize m_frameSize;
+	VkDeviceSize m_blockAlignment;
+	uint32_t m_blockSize;
+
+	VkDescriptorSetLayout vk_descriptorSetLayout;
+	VkDescriptorPool vk_descriptorPool;
+	VkDescriptorSet vk_descriptorSet;
+	std::vector<ConstantsFrame> m_frames;
+};
+
+
+//The most descriptors of each type that the bindless resource table holds, fewer if the graphics card's limits are lower
+constexpr uint32_t MAX_BINDLESS_BUFFERS = 4096;
+constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+//The buffer handle that the table registers its default buffer with, unused buffer descriptors point to it as well
+constexpr uint32_t DEFAULT_BINDLESS_BUFFER = 0;
+
+/* A single descriptor set that holds every storage buffer (binding 0) and every texture (binding 1) that the shaders use,
+   in large arrays that the shaders index with handles passed in push constants. The set is bound once with the rest of 
+   the draw state, so draws that use different resources don't bind anything in between and can be batched together.
+   With descriptor indexing the arrays are partially bound and updated after bind, so registering a resource writes its
+   descriptor right away, even while the set is used by frames in flight. Without it the arrays are only as large as the
+   per stage limits allow, every unused buffer descriptor points to the default buffer and the caller needs to wait for
+   the frames in flight before registering or releasing. Released handles are only handed out again once the frames that 
+   were in flight when they were released have finished */
+class VulkanBindlessResources
+{
+public:
+	VulkanBindlessResources();
+	~VulkanBindlessResources();
+
+	/* Creates the set with arrays as large as the graphics card allows, with update after bind if descriptor indexing was 
+	   enabled on the device, and registers the default buffer as the first buffer */
+	void Init(const VkDevice& vk_device, const VkInstance& vk_instance, const VkPhysicalDevice& vk_graphicsCard, 
+		bool descriptorIndexing, uint32_t framesInFlight, const VkBuffer& vk_defaultBuffer);
+
+	//Hands the released handles of the slot back out, the GPU needs to be done with the frame that last used the slot
+	void BeginFrame(uint32_t frameIndex);
+
+	//Writes the descriptor of a storage buffer range into a free element of the array and returns its handle
+	uint32_t RegisterBuffer(const VkBuffer& vk_buffer, VkDeviceSize offset, VkDeviceSize range);
+
+	//Writes the descriptor of a sampled texture into a free element of the array and returns its handle
+	uint32_t RegisterTexture(const VkImageView& vk_imageView, const VkSampler& vk_sampler);
+
+	/* Frees the handle, the resource itself can be destroyed once no frame in flight uses it. Without descriptor indexing
+	   the buffer's descriptor is pointed back to the default buffer */
+	void ReleaseBuffer(uint32_t handle);
+
+	void ReleaseTexture(uint32_t handle);
+
+	inline const VkDescriptorSetLayout& GetDescriptorSetLayout() const { return vk_descriptorSetLayout; }
+
+	inline const VkDescriptorSet& GetDescriptorSet() const { return vk_descriptorSet; }
+
+	//The size of the buffer array, the shaders get it as a specialization constant
+	inline uint32_t GetBufferCapacity() const { return m_buffers.capacity; }
+
+	inline bool UsesDescriptorIndexing() const { return m_descriptorIndexing; }
+
+	void Cleanup();
+private:
+	//The handles of one of the arrays, handles that were never used are handed out from the end
+	struct HandleArray
+	{
+		uint32_t capacity = 0;
+		uint32_t nextHandle = 0;
+		std::vector<uint32_t> freeHandles;
+		//The handles released while each frame slot was the last one to begin, reused when the slot begins again
+		std::vector<std::vector<uint32_t>> releasedHandles;
+	};
+
+	static uint32_t AllocateHandle(HandleArray& handles);
+
+	void WriteBufferDescriptor(uint32_t handle, const VkBuffer& vk_buffer, VkDeviceSize offset, VkDeviceSize range);
+private:
+	VkDevice vk_device;
+	bool m_descriptorIndexing;
+
+	VkDescriptorSetLayout vk_descriptorSetLayout;
+	VkDescriptorPool vk_descriptorPool;
+	VkDescriptorSet vk_descriptorSet;
+
+	VkBuffer vk_defaultBuffer;
+	HandleArray m_buffers;
+	HandleArray m_textures;
+	uint32_t m_currentFrame;
+};
+
+
+/* Pool of worker threads that record secondary command buffers for the render pass of a frame in parallel. Each worker owns
+   a command pool for every frame slot, since a command pool can only be used by one thread at a time, and the whole pool
+   is reset when its slot is reused instead of resetting the command buffers one by one */
+class VulkanRecordingWorkers
+{
+public:
+	//Records the jobs in the range passed into a secondary command buffer that has already begun
+	using RecordFunction = std::function<void(const VkCommandBuffer& vk_commandBuffer, uint32_t firstJob, uint32_t jobCount)>;
+
+	VulkanRecordingWorkers();
+	~VulkanRecordingWorkers();
+
+	void Init(const VkDevice& vk_device, uint32_t graphicsQueueFamilyIndex, uint32_t threadCount, uint32_t framesInFlight);
+
+	/* Splits the jobs evenly across the workers and waits for them to record their share. Every secondary command buffer
+	   continues the render pass of the inheritance info. The ones that hold commands are written to the array passed,
+	   in job order, so that the primary command buffer can execute them */
+	void Record(uint32_t frameIndex, const VkCommandBufferInheritanceInfo& vk_inheritanceInfo, uint32_t jobCount,
+		const RecordFunction& recordJobs, std::vector<VkCommandBuffer>& recordedCommandBuffers);
+
+	//Stops the worker threads, no recording can be in progress
+	void Cleanup();
+
+	inline bool IsEnabled() const { return !m_workers.empty(); }
+
+	inline uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+private:
+	struct RecordingWorker
+	{
+		std::thread thread;
+		std::vector<VkCommandPool> commandPools;
+		std::vector<VkCommandBuffer> commandBuffers;
+		uint32_t firstJob = 0;
+		uint32_t jobCount = 0;
+	};
+
+	void WorkerLoop(uint32_t workerIndex);
+private:
+	VkDevice vk_device;
+	std::vector<RecordingWorker> m_workers;
+
+	//Wakes the workers when the generation changes, and wakes the recording thread when the last worker is done
+	std::mutex m_mutex;
+	std::condition_variable m_workAvailable;
+	std::condition_variable m_workFinished;
+	uint64_t m_workGeneration;
+	uint32_t m_busyWorkers;
+	bool m_stopping;
+
+	//The work of the current generation, only changed while every worker is idle
+	uint32_t m_frameIndex;
+	const VkCommandBufferInheritanceInfo* m_inheritanceInfo;
+	const RecordFunction* m_recordJobs;
+};
+
+
+
+/* Header that the application writes in front of the pipeline cache data on disk. Vulkan stores the vendor, the device 
+   and the cache UUID in the data as well, but the driver version is also needed since a driver update invalidates the cache */
+struct PipelineCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t dataSize;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+/* Owns the pipeline cache that every pipeline creation call of the application shares. The cache is loaded from disk 
+   when the application starts and written back when it shuts down, so that pipelines do not get recompiled on each launch */
+class VulkanPipelineCache
+{
+public:
+	VulkanPipelineCache();
+	~VulkanPipelineCache();
+
+	/* Creates the pipeline cache from the file passed, if the file exists and was written for the same graphics card
+	   and driver. Otherwise the pipeline cache starts out empty */
+	void CreatePipelineCache(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard, const char* cacheFilename);
+
+	//Writes the contents of the cache back to the file it was loaded from
+	void SavePipelineCache(const VkDevice& vk_device);
+
+	void Cleanup(const VkDevice& vk_device);
+
+	//Returns true if the cache was created from valid data on disk instead of starting out empty
+	inline bool WasLoadedFromDisk() const { return m_loadedFromDisk; }
+private:
+	//Reads the cache file and validates its header against the graphics card, returns false if the data can't be used
+	bool ReadPipelineCacheFile(std::vector<char>& cacheData);
+public:
+	VkPipelineCache vk_pipelineCache;
+private:
+	std::string m_cacheFilename;
+	VkPhysicalDeviceProperties m_gpuProperties;
+	bool m_loadedFromDisk;
+};
+
+//How long the low latency wait waits for a present to be displayed before giving up, in nanoseconds
+constexpr uint64_t PRESENT_WAIT_TIMEOUT = 100'000'000;
+//How long before its deadline the frame limiter stops sleeping and spins instead
+constexpr std::chrono::microseconds FRAME_LIMITER_SPIN_TIME(1000);
+
+/* How the frames are paced against the display. Batch runs want every frame as soon as possible, interactive ones want 
+   as little time as possible between sampling input and the frame reaching the screen */
+struct FramePacingSettings
+{
+	//The present mode the swapchain uses if the surface supports it, otherwise mailbox or fifo are used
+	VkPresentModeKHR vk_presentMode;
+	//The amount of swapchain images to ask for, clamped to what the surface allows. 0 asks for one more than the minimum
+	uint32_t swapchainImageCount;
+	//The frame rate that the CPU side limiter holds the frames to, 0 leaves it uncapped
+	double targetFrameRate;
+	/* Waits before the next frame samples its input until the previous frame has been presented (with VK_KHR_present_wait 
+	   where the graphics card supports it) or at least finished on the GPU, so that no more than one frame is queued */
+	bool lowLatency;
+};
+
+//Tearing is allowed and nothing waits on the display, so the frame rate is only bound by the CPU and the GPU
+inline FramePacingSettings ThroughputFramePacing() { return { VK_PRESENT_MODE_IMMEDIATE_KHR, 0, 0.0, false }; }
+
+/* Mailbox replaces a queued image instead of waiting behind it, and with the low latency wait each frame starts from input 
+   sampled after the previous one was presented */
+inline FramePacingSettings LowLatencyFramePacing(double targetFrameRate = 0.0) 
+{ 
+	return { VK_PRESENT_MODE_MAILBOX_KHR, 3, targetFrameRate, true }; 
+}
+
+//The time in milliseconds that the different phases of initializing the graphics took
+struct VulkanStartupTimings
+{
+	//Creating the instance, picking a graphics card and creating the logical device
+	double deviceCreation;
+	//Creating the swapchain or the offscreen render targets and their image views
+	double renderTargetCreation;
+	/* Loading the pipeline cache and creating the pipeline layouts and the render pass on the main thread. The pipelines 
+	   themselves are compiled on worker threads from here on, while the render targets are created */
+	double pipelineCreation;
+	//Everything from the start of Init until the application is ready to draw its first frame
+	double total;
+	/* When the SPIR-V of the graphics pipeline was read and its shader modules created, and when each pipeline finished
+	   compiling (this is where the pipeline cache helps), in milliseconds since the start of Init. They are filled in when 
+	   the pipelines are published, and can come after the total since the first frames don't wait for them */
+	double shadersLoaded;
+	double graphicsPipelineReady;
+	double cullingPipelineReady;
+};
+
+//A pipeline compiled on a worker thread, with the times of its startup phases in milliseconds since the start of Init
+struct CompiledPipeline
+{
+	VkPipeline vk_pipeline;
+	double shadersLoaded;
+	double ready;
+};
+
+
+//The maximum amount of scopes that can be profiled in a single frame
+constexpr uint32_t GPU_PROFILER_MAX_SCOPES = 32;
+//The amount of recent samples of each scope that the rolling statistics are computed over
+constexpr uint32_t GPU_PROFILER_HISTORY_SIZE = 512;
+
+//Rolling GPU time statistics of a named scope, in milliseconds
+struct GpuScopeStatistics
+{
+	std::string name;
+	uint32_t sampleCount;
+	double lastMs;
+	double minMs;
+	double avgMs;
+	double p50Ms;
+	double p95Ms;
+	double p99Ms;
+};
+
+//The pipeline statistics of the render pass of the most recent frame that the profiler read back
+struct GpuPipelineStatistics
+{
+	uint64_t inputAssemblyPrimitives;
+	uint64_t vertexShaderInvocations;
+	uint64_t clippingPrimitives;
+	uint64_t fragmentShaderInvocations;
+};
+
+/* Brackets parts of a frame's command buffer with timestamp queries (and optionally pipeline statistics queries) to find
+   out where the GPU time goes. Each slot of the frame ring has its own query pools, and the results of a slot are read
+   back when the slot is reused, after its fence has signaled, so reading them never stalls */
+class VulkanGpuProfiler
+{
+public:
+	VulkanGpuProfiler();
+	~VulkanGpuProfiler();
+
+	/* Creates the query pools of every frame slot. If the queue family does not support timestamps the profiler is
+	   left disabled. Pipeline statistics need the pipelineStatisticsQuery feature to be enabled on the device */
+	void CreateQueryPools(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard, uint32_t queueFamilyIndex,
+		uint32_t framesInFlight, bool pipelineStatistics);
+
+	/* Called at the start of recording a frame, outside of a render pass. Reads back the results that the slot wrote the
+	   last time it was used and resets its queries */
+	void BeginFrame(const VkDevice& vk_device, const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex);
+
+	//Writes the timestamp that starts a named scope and returns the slot that needs to be passed to EndScope
+	uint32_t BeginScope(const VkCommandBuffer& vk_commandBuffer, const char* scopeName, uint32_t frameIndex);
+
+	void EndScope(const VkCommandBuffer& vk_commandBuffer, uint32_t scopeSlot, uint32_t frameIndex);
+
+	void BeginPipelineStatistics(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex);
+
+	void EndPipelineStatistics(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex);
+
+	//Retrieves the min/avg/p50/p95/p99 GPU times of every scope that has been read back at least once
+	void GetScopeStatistics(std::vector<GpuScopeStatistics>& scopeStatistics) const;
+
+	/* Retrieves the most recent GPU time of a scope and the amount of times the scope has been read back in total, so that
+	   a caller polling every frame can tell whether the time is new. Returns false if the scope was never read back */
+	bool GetLastScopeSample(const char* scopeName, double& milliseconds, uint64_t& readbackCount) const;
+
+	//The results of a frame are read back when its frame slot is used again, this many frames after it was recorded
+	inline uint32_t GetReadbackLatency() const { return static_cast<uint32_t>(m_frames.size()); }
+
+	inline const GpuPipelineStatistics& GetLastPipelineStatistics() const { return m_lastPipelineStatistics; }
+
+	//Writes the statistics of every scope to a csv file, one scope per row
+	bool DumpCsv(const char* filename) const;
+
+	void Cleanup(const VkDevice& vk_device);
+
+	inline bool IsEnabled() const { return m_enabled; }
+private:
+	//The query pools of a single frame slot and the scopes that were written to them
+	struct ProfilerFrameQueries
+	{
+		VkQueryPool vk_timestampPool = VK_NULL_HANDLE;
+		VkQueryPool vk_statisticsPool = VK_NULL_HANDLE;
+		//Holds the id of the scope that each pair of timestamps belongs to
+		std::vector<uint32_t> scopes;
+		bool statisticsWritten = false;
+	};
+
+	//The most recent GPU times of a scope, stored in a ring
+	struct GpuScopeHistory
+	{
+		std::string name;
+		std::vector<double> samples;
+		uint32_t nextSample = 0;
+		uint32_t sampleCount = 0;
+		double lastSample = 0.0;
+		uint64_t totalSampleCount = 0;
+	};
+
+	void CollectFrameResults(const VkDevice& vk_device, ProfilerFrameQueries& frame);
+
+	void AddScopeSample(GpuScopeHistory& scope, double milliseconds);
+private:
+	bool m_enabled;
+	bool m_pipelineStatisticsEnabled;
+	//The nanoseconds it takes for a timestamp to be incremented by 1
+	float m_timestampPeriod;
+	uint64_t m_timestampMask;
+
+	std::vector<ProfilerFrameQueries> m_frames;
+	std::vector<GpuScopeHistory> m_scopes;
+	GpuPipelineStatistics m_lastPipelineStatistics;
+};
 
 
 struct GraphicsPipelineFixedState
@@ -177,21 +1479,288 @@ public:
 	~VulkanGraphics();
 
 	/* Initializes all the necessary vulkan object wrappers and sets them so that the main loop of the class
-	can run properly and allow the other main loops to function as well   */
+	can run properly and allow the other main loops to function as well. The window is only used during Init, afterwards
+	the graphics only see the window state that is passed to SetWindowState   */
 	void Init(const WindowHandle& window);
 
+	/* Hands the graphics the latest state of the window, after its events have been processed. The graphics never read the
+	   window handle after Init, so that they can run on a different thread than the one that owns the window */
+	inline void SetWindowState(const WindowState& windowState) { m_windowState = windowState; }
+
+	/* Initializes vulkan without a window, surface or swapchain. The application renders into device local images
+	   of the given size instead, which is useful for batch rendering on machines without a display */
+	void InitHeadless(uint32_t width, uint32_t height);
+
 	void Cleanup();
 
+	/* Sets how many frames the CPU is allowed to record while the GPU is still executing previous ones. 
+	   Needs to be called before Init to take effect */
+	inline void SetFramesInFlight(uint32_t framesInFlight) { m_framesInFlight = framesInFlight ? framesInFlight : 1; }
+
+	/* Names the graphics card to use, by a part of its name or by its UUID, instead of the one with the highest score. Takes
+	   precedence over the environment variable. Needs to be called before Init to take effect */
+	inline void SetGraphicsCardOverride(const std::string& graphicsCardOverride) { m_graphicsCardOverride = graphicsCardOverride; }
+
+	//Sets the file that the pipeline cache is loaded from and saved to. Needs to be called before Init to take effect
+	inline void SetPipelineCacheFilename(const std::string& cacheFilename) { m_pipelineCacheFilename = cacheFilename; }
+
+	/* Reads the compiled shaders from the .spv files in the directory passed instead of using the embedded ones. Takes 
+	   precedence over the environment variable. Needs to be called before Init to take effect */
+	inline void SetShaderDirectoryOverride(const std::string& shaderDirectory) { m_shaderDirectoryOverride = shaderDirectory; }
+
+	inline const VulkanStartupTimings& GetStartupTimings() const { return m_startupTimings; }
+
+	inline bool WasPipelineCacheLoadedFromDisk() const { return m_pipelineCache.WasLoadedFromDisk(); }
+
+	/* Blocks until the pipelines that are compiling on worker threads are done and publishes them. Frames that are drawn 
+	   before then only clear the render target, or draw without culling if only the culling pipeline is missing */
+	void WaitForPipelines();
+
+	/* Enables the GPU profiler that times each frame and its render pass on the GPU, optionally with pipeline statistics. 
+	   Needs to be called before Init to take effect */
+	inline void SetGpuProfiling(bool enabled, bool pipelineStatistics) 
+	{ 
+		m_gpuProfilingEnabled = enabled; 
+		m_pipelineStatisticsEnabled = pipelineStatistics; 
+	}
+
+	/* Sets the present mode, the swapchain image count, the frame limiter and the low latency wait. Can be called at any time,
+	   the swapchain is recreated before the next frame if its present mode or image count changed */
+	void SetFramePacing(const FramePacingSettings& framePacing);
+
+	inline const FramePacingSettings& GetFramePacing() const { return m_framePacing; }
+
+	//Whether the low latency wait uses VK_KHR_present_wait, which needs the graphics card to support it and a window
+	inline bool IsPresentWaitEnabled() const { return vk_waitForPresent != nullptr; }
+
+	/* Whether the bindless resource table uses descriptor indexing, which needs the graphics card to support it. Without it
+	   creating or destroying a material waits for the frames in flight */
+	inline bool IsDescriptorIndexingEnabled() const { return m_bindlessResources.UsesDescriptorIndexing(); }
+
+	/* Creates a material with the color passed and returns its bindless handle. The material is streamed through the upload
+	   queue, it can be drawn with from the first frame recorded after it was created */
+	uint32_t CreateMaterial(const MaterialData& material);
+
+	/* Destroys the material once the frames in flight that could still be reading it are done. Without descriptor indexing
+	   its descriptor is overwritten right away, so the frames in flight are waited for first */
+	void DestroyMaterial(uint32_t materialHandle);
+
+	/* Draws the instances with the material of the handle passed, which only changes the push constants of the draw. The
+	   default material, which leaves the colors as they are, has the handle DEFAULT_BINDLESS_BUFFER */
+	inline void SetMaterial(uint32_t materialHandle) 
+	{ 
+		m_drawConstants.materialHandle = materialHandle; 
+		MarkStaticContentDirty();
+	}
+
+	/* Waits until it is time to start the next frame, according to the frame pacing. The application calls this right before
+	   sampling input, so that the time spent waiting doesn't add to the latency of that input. MainLoop calls it itself if
+	   the application didn't */
+	void WaitForNextFrame();
+
+	/* Replaces the instances of the mesh that are drawn each frame with a single instanced draw. If there are more 
+	   instances than the instance buffers can hold, the buffers are replaced with bigger ones */
+	void SetInstances(const std::vector<InstanceData>& instances);
+
+	//Lays out the amount of instances passed in a grid that covers the render target, used to scale the GPU workload
+	void SetInstanceCount(uint32_t instanceCount);
+
+	/* Returns the instances so that they can be changed in place. The changes are written to the instance buffer of each 
+	   frame slot the next time the slot is recorded, so they need to be done before the next call to MainLoop */
+	inline InstanceData* EditInstances() { ++m_instanceGeneration; return m_instances.data(); }
+
+	inline uint32_t GetInstanceCount() const { return static_cast<uint32_t>(m_instances.size()); }
+
+	/* Culls the instances against the view on the GPU before drawing them with an indirect draw. Needs to be called before 
+	   Init to take effect */
+	inline void SetGpuCulling(bool enabled) { m_gpuCullingEnabled = enabled; }
+
+	/* Sets the layout the vertex buffer stores the mesh in, the quantized one by default. Needs to be called before Init to
+	   take effect */
+	inline void SetVertexFormat(VertexFormat format) { m_vertexFormat = format; }
+
+	inline VertexFormat GetVertexFormat() const { return m_vertexFormat; }
+
+	/* Replaces the mesh that is drawn each frame. The vertices are converted to the vertex format, and they and the indices
+	   are streamed to device local buffers through the upload queue. The mesh is drawn from the first frame that is 
+	   recorded after its upload has been submitted. OptimizeMesh can reorder the mesh for the GPU's caches beforehand */
+	void SetMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+	/* Replaces the mesh with the one in a mesh file. The file is mapped and its sections are copied into the staging ring 
+	   straight from the mapping, which stays open until the upload has been submitted. Returns false, and keeps drawing the
+	   current mesh, if the file can't be opened, fails its checks or doesn't hold vertices of the vertex format */
+	bool LoadMesh(const char* filename);
+
+	//Whether the upload of the mesh has been submitted, so that the frames recorded from now on draw it
+	inline bool IsMeshUploaded() const { return m_uploadQueue.GetSubmittedTicket() >= m_meshUploadTicket; }
+
+	/* Records the render pass on the amount of worker threads passed, each into its own secondary command buffer, with the
+	   instances split into draws of up to the amount of instances passed. GPU culling is bypassed for the split draws, and
+	   pipeline statistics while recording in parallel. A thread count of 0 records the same draws on the calling thread.
+	   Needs to be called before Init */
+	inline void SetParallelRecording(uint32_t threadCount, uint32_t instancesPerDraw) 
+	{ 
+		m_recordingThreadCount = threadCount; 
+		m_instancesPerDraw = instancesPerDraw ? instancesPerDraw : 1; 
+	}
+
+	/* Records the draws of the render pass once into a secondary command buffer for each frame slot and swapchain image, and 
+	   only records them again when the static content is marked dirty. Each frame then only records the render pass around
+	   them. Takes precedence over parallel recording, and pipeline statistics are not collected. Needs to be called before
+	   Init to take effect */
+	inline void SetStaticCommandBuffers(bool enabled) { m_staticCommandBuffersEnabled = enabled; }
+
+	/* Renders with the amount of samples per pixel passed, lowered to the most that the graphics card supports for color
+	   attachments. The samples live in a transient attachment that is resolved into the render target within the render 
+	   pass and never stored. Needs to be called before Init to take effect */
+	inline void SetMsaaSamples(VkSampleCountFlagBits vk_samples) { m_msaaSamples = vk_samples; }
+
+	//The amount of samples per pixel the graphics render with, known once they are initialized
+	inline VkSampleCountFlagBits GetMsaaSamples() const { return m_msaaSamples; }
+
+	/* Makes every static command buffer record its draws again the next time it is used. The graphics call this themselves
+	   when the swapchain, the pipeline, the mesh or the amount of instances change. Editing the instances in place does not
+	   need it, since the draws read them from the instance buffers */
+	inline void MarkStaticContentDirty() { ++m_staticContentVersion; }
+
+	/* Makes the next frame needed even though nothing that the graphics track has changed, for changes that they can't see.
+	   Only matters when the application renders on demand */
+	inline void RequestRedraw() { m_redrawRequested = true; }
+
+	//While something is animating every frame is needed, so rendering on demand falls back to rendering continuously
+	inline void SetAnimating(bool animating) { m_animating = animating; }
+
+	/* Whether the next frame would look different from the last one that was drawn: the scene, the instances, the window 
+	   or the swapchain changed, uploads or pipeline compilations are in progress, a redraw was requested or something is 
+	   animating. Always true when rendering headless */
+	bool NeedsRedraw();
+
+	/* Moves and scales the whole scene after the instances are placed, in clip space. Passed to the shaders as push 
+	   constants, and taken into account when culling. Scales closer to zero than MIN_VIEW_SCALE are clamped to it */
+	void SetViewTransform(float offsetX, float offsetY, float scaleX, float scaleY);
+
+	//Multiplies the color of every fragment, passed to the shaders through the frame constant ring
+	inline void SetColorScale(float red, float green, float blue, float alpha) 
+	{ 
+		m_frameUniforms.colorScale[0] = red;
+		m_frameUniforms.colorScale[1] = green;
+		m_frameUniforms.colorScale[2] = blue;
+		m_frameUniforms.colorScale[3] = alpha;
+		RequestRedraw();
+	}
+
+	//The time it took the CPU to record the commands of the last frame, in milliseconds
+	inline double GetLastFrameRecordingMs() const { return m_lastRecordingMs; }
+
+	//The profiler can be queried for the rolling GPU times of each scope, or dumped to a csv file
+	inline const VulkanGpuProfiler& GetGpuProfiler() const { return m_gpuProfiler; }
+
+	inline void GetMemoryStatistics(VulkanMemoryStatistics& statistics) const { m_memoryAllocator.GetStatistics(statistics); }
+
 	/* Called repeatedly by the application to for standard graphics operations until certain conditions are met which 
 	stop the application   */
 	void MainLoop();
 private:
 	//Called in the main loop to draw graphics
 	void Draw();
+
+	//Called in the main loop instead of Draw when the application renders offscreen
+	void DrawHeadless();
+
+	/* Records the commands of a frame into the command buffer of its slot in the ring, targeting the render target image 
+	   passed. Returns the semaphore of the frame's uploads that the submission needs to wait on, or VK_NULL_HANDLE */
+	VkSemaphore RecordFrame(FrameInFlightData& frame, uint32_t imageIndex);
+
+	/* Declares the passes of a frame to the render graph and compiles it: the culling pre-pass and the main pass that draws
+	   into the render target. The main pass only reads the results of the culling pass if the way the draws are recorded
+	   uses them, otherwise the graph culls the culling pass */
+	void BuildRenderGraph();
+
+	/* The passes of the render graph. They take the mesh of the frame being recorded, and the culling pass points it at the
+	   visible instances and the arguments of the indirect draw */
+	void RecordCullingPass(const RenderGraphPassContext& context);
+	void RecordMainPass(const RenderGraphPassContext& context);
+
+	//Records the render pass with the draws of the mesh recorded by the worker threads into secondary command buffers
+	void RecordParallelRenderPass(const VkRenderPassBeginInfo& vk_renderPassBegin, const VkCommandBuffer& vk_commandBuffer,
+		uint32_t frameIndex, uint32_t imageIndex, const MeshBuffers& mesh);
+
+	/* Records the render pass around the static command buffer of the slot and swapchain image, which is recorded first if
+	   it is dirty */
+	void RecordStaticRenderPass(const VkRenderPassBeginInfo& vk_renderPassBegin, const VkCommandBuffer& vk_commandBuffer,
+		uint32_t frameIndex, uint32_t imageIndex, const MeshBuffers& mesh);
+
+	/* Allocates a static command buffer for every frame slot and swapchain image. The previous ones are freed through the
+	   deletion queue, since the frames in flight may still be executing them */
+	void AllocateStaticCommandBuffers();
+
+	/* Waits for the fences of every slot in the ring, so that nothing the frames in flight use is still being read, and 
+	   destroys everything that was retired to the deletion queue */
+	void WaitForFramesInFlight();
+
+	/* Destroys the buffers of the current mesh once no frame in flight draws from them and closes its mesh file. Their 
+	   uploads that have not been submitted yet are dropped, so the upload queue does not copy into destroyed buffers */
+	void DestroyMeshBuffers();
+
+	//The buffers are only written by copies, so they live in device local memory that the CPU can't see
+	void CreateMeshBuffers(VkDeviceSize vertexBufferSize, VkDeviceSize indexBufferSize);
+
+	/* Creates the swapchain with the extent of the window's framebuffer and retrieves its images. If a swapchain already 
+	   exists it is passed as the old swapchain and retired afterwards */
+	void CreateSwapchain();
+
+	/* Recreates the swapchain, the extent dependent image views and the attachments of the render graph. The previous ones 
+	   are retired to the deletion queue instead of waiting for the frames in flight that use them. Returns false if the 
+	   window is minimized, in which case nothing should be drawn */
+	bool RecreateSwapchain();
+
+	//Creates the device local images that are used instead of swapchain images when the application is headless
+	void CreateOffscreenRenderTargets();
+
+	//Creates an image view for each of the render target images (swapchain images or offscreen images)
+	void CreateRenderTargetImageViews();
+
+	/* Creates the pipeline layout, the render graph with its render passes and the graphics pipeline. These do not depend
+	   on whether the application renders to a swapchain or offscreen */
+	void CreateGraphicsPipelineObjects();
+
+	//Starts reading the SPIR-V of every shader on worker threads, before there is a device to create shader modules with
+	void StartShaderLoads();
+
+	/* Creates the shader modules from the SPIR-V that the loads read and compiles the graphics pipeline with them. Runs on a 
+	   worker thread, the render pass and the pipeline layout need to exist already */
+	CompiledPipeline CompileGraphicsPipeline();
+
+	/* Takes the pipelines whose compilation has finished (or waits for them) and starts using them. The static command 
+	   buffers are marked dirty, since they were recorded without them */
+	void PublishCompiledPipelines(bool wait);
+
+	//Creates the framebuffers and transient attachments of the render graph for the render target images
+	void CreateFramebuffers();
+
+	//Creates the command pool and the ring of frames in flight with their command buffers, as well as the upload queue
+	void CreateCommandObjects();
+
+	//Uploads the triangle that the application draws until it is given a different mesh
+	void CreateDefaultMesh();
+
+	/* Creates a persistently mapped instance buffer for every frame slot, big enough for the capacity passed. Existing 
+	   buffers are retired to the deletion queue. With GPU culling the frames in flight are waited for, since the descriptor
+	   sets of the culling pass that point at the buffers are rewritten */
+	void CreateInstanceBuffers(uint32_t instanceCapacity);
+
+	//Copies the instances into the instance buffer of the slot, if they changed since the slot was last written
+	void UpdateInstanceBuffer(uint32_t frameIndex);
 	
 	//Creates a default VkInstanceCreateInfo that is used to create the vulkan instance when the application starts
 	void CreateAppDefaultVkInstanceInfo(VkInstanceCreateInfo& vk_instanceInfo, VkApplicationInfo& vk_appInfo);
 
+	//Adds the device extensions that the application can use but does not need, if the graphics card supports them
+	void AddOptionalDeviceExtensions();
+
+	//Adds the instance extensions that the optional device extensions depend on, if the implementation supports them
+	void AddOptionalInstanceExtensions(std::vector<const char*>& instanceExtensions);
+
 	//Creates a default VkDeviceCreateInfo that is used to create the logical device when the application starts
 	void CreateAppDefaultVkDeviceInfo(VkDeviceCreateInfo& vk_deviceInfo, const QueueFamilyIndices& gpuQueueFamilyIndices,
 		const std::vector<const char*>& requiredDeviceExtensions, std::vector<VkDeviceQueueCreateInfo>& queueCreateInfo);
@@ -202,13 +1771,10 @@ private:
 
 	/* Default info functions needed to create the objects that need to be passed into the graphics pipeline in order to 
 	   properly create one */
-	//Creates the default VkPipelineLayoutCreateInfo that is used to create the pipeline layout when the application starts
-	void CreateAppDefaultPipelineLayoutInfo(VkPipelineLayoutCreateInfo& vk_pipelineLayoutInfo);
-
-	//Creates the default VkRenderPassCreateInfo that is used to create the render pass when the application starts
-	void CreateAppDefaultRenderPassInfo(VkRenderPassCreateInfo& vk_renderPassInfo, VkAttachmentDescription& vk_attachmentInfo,
-		VkAttachmentReference& vk_attachmentRef, VkSubpassDescription& vk_subpassInfo, 
-		VkSubpassDependency& vk_subpassDependency);
+	/* Creates the default VkPipelineLayoutCreateInfo that is used to create the pipeline layout when the application starts,
+	   with the set of the frame constants, the bindless set and the range of the draw's push constants */
+	void CreateAppDefaultPipelineLayoutInfo(VkPipelineLayoutCreateInfo& vk_pipelineLayoutInfo, 
+		std::vector<VkDescriptorSetLayout>& setLayouts, VkPushConstantRange& vk_pushConstantRange);
 
 	void CreateAppDefaultVkPipelineInfo(VkGraphicsPipelineCreateInfo& vk_pipelineInfo,
 		const VkPipelineShaderStageCreateInfo* shaderStageInfos,const VkPipelineVertexInputStateCreateInfo& vk_vertexInputStateInfo, 
@@ -221,18 +1787,22 @@ private:
 		VkPipelineColorBlendStateCreateInfo& vk_colorBlendInfo, GraphicsPipelineFixedState& fixedState);
 
 	//Takes the filename of a file and reads the byte code into the array passed in as the 1st argument
-	void ReadShaderFile(std::vector<char>& shaderCode, const char* shaderFilename);
+	void ReadShaderFile(std::vector<uint32_t>& shaderWords, const char* shaderFilename);
+
+	/* Gets the code of a shader of the registry. Embedded shaders are returned right away without a thread, while a file is
+	   read on a thread of its own if the shader directory is overridden */
+	std::future<ShaderCode> LoadShaderCode(const EmbeddedShader& shader, const std::string& shaderDirectory);
 
 	//Creates a shader stage for each of the shaders(the vertex and the fragment). I needs to be passed to the pipeline
 	void CreateShaderStages(VkShaderModule& vk_vertexShaderModule, VkShaderModule& vk_fragShaderModule,
 		VkPipelineShaderStageCreateInfo& vk_vertexShaderStageInfo, VkPipelineShaderStageCreateInfo& vk_fragShaderStageInfo,
-		std::vector<char>& vertexShaderCode, std::vector<char>& fragShaderCode, const VkDevice& vk_device);
-
-	//Creates a default vertex input info that specifies the format of the vertex data that is passed
-	void CreateAppDefaultVkVertexInputInfo(VkPipelineVertexInputStateCreateInfo& vk_vertexInputInfo);
+		const ShaderCode& vertexShaderCode, const ShaderCode& fragShaderCode, const VkDevice& vk_device);
 
-	//Creates a default framebuffer info used to create the default framebuffers of the application
-	void CreateAppDefaultFramebufferInfo(VkFramebufferCreateInfo& vk_framebufferInfo, uint32_t imageViewIndex);
+	/* Creates a default vertex input info that specifies the format of the vertex data that is passed. The descriptions
+	   are filled in the arrays passed, which need to outlive the info */
+	void CreateAppDefaultVkVertexInputInfo(VkPipelineVertexInputStateCreateInfo& vk_vertexInputInfo,
+		std::vector<VkVertexInputBindingDescription>& bindingDescriptions,
+		std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
 
 	//Creates a default command pool info used to create the command pool which will allocate the command buffers
 	void CreateAppDefaultVkCommandPoolInfo(VkCommandPoolCreateInfo& vk_commandPoolInfo, uint32_t graphicsQueueFamilyIndex);
@@ -251,41 +1821,173 @@ private:
 	VkPhysicalDevice vk_graphicsCard;
 	QueueFamilyIndices m_gpuQueueFamilies;
 	SwapchainSupportDetails m_gpuSwapchainSupport;
+	std::string m_graphicsCardOverride;
 	std::vector<const char*> requiredDeviceExtensions;
 
 	//The vulkan device objects and its queues
 	VkDevice vk_device;
 	VkQueue vk_graphicsQueue;
 	VkQueue vk_presentQueue;
+	//The dedicated transfer queue, or the graphics queue if the graphics card does not have one
+	VkQueue vk_transferQueue;
+
+	//Sub-allocates the device memory of every buffer and image that the application creates
+	VulkanMemoryAllocator m_memoryAllocator;
 
 	//The vulkan swapchain object which will own the framebuffers that the app will render to
-	VkSwapchainKHR vk_swapchain;
+	VulkanSwapchainHandle vk_swapchain;
 	std::vector<VkImage> swapchainImages;
 	VkFormat vk_imageFormat;
 	VkExtent2D vk_imageExtent;
+	VkSurfaceFormatKHR vk_surfaceFormat;
+	VkPresentModeKHR vk_swapchainPresentMode;
+
+	/* The frame pacing, and the deadline of the next frame when the frame rate is limited. With present wait, every present
+	   gets an id and the low latency wait waits for the id of the last present. A recreated swapchain starts with nothing
+	   to wait for */
+	FramePacingSettings m_framePacing;
+	std::chrono::steady_clock::time_point m_nextFrameDeadline;
+	bool m_waitedForFrame;
+	bool m_physicalDeviceProperties2Enabled;
+	VkPhysicalDevicePresentIdFeaturesKHR m_presentIdFeatures;
+	VkPhysicalDevicePresentWaitFeaturesKHR m_presentWaitFeatures;
+	//Only holds the features that the bindless resource table uses, and only if the graphics card supports all of them
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT m_descriptorIndexingFeatures;
+	PFN_vkWaitForPresentKHR vk_waitForPresent;
+	uint64_t m_nextPresentId;
+	uint64_t m_lastPresentId;
+
+	/* The last state of the window the swapchain presents to. The swapchain is recreated when the window's resize count 
+	   changes or when acquiring or presenting reports that the swapchain is out of date */
+	WindowState m_windowState;
+	uint32_t m_windowResizeCount;
+	bool m_swapchainOutdated;
+
+	/* The versions of the content and the window damage that the last drawn frame saw, rendering on demand compares them
+	   with the current ones to find out if there is anything new to draw */
+	uint64_t m_drawnContentVersion;
+	uint64_t m_drawnInstanceGeneration;
+	uint32_t m_drawnWindowDamageCount;
+	bool m_redrawRequested;
+	bool m_animating;
+
+	/* When the application is headless, the swapchain images array holds offscreen images that the application
+	   created itself, backed by the memory below */
+	bool m_headless;
+	std::vector<VulkanAllocation> offscreenImageAllocations;
 
 	/*The image views created by the application will allow it to view the details of 
 	  the image objects retrieved from the swapchain */
-	std::vector<VkImageView> imageViews;
+	std::vector<VulkanImageViewHandle> imageViews;
 
 	//The pipeline layout allows the application side of the program to pass uniform variables to the shaders 
-	VkPipelineLayout vk_pipelineLayout;
-
-	//The render pass specifies the framebuffer attachments that will be used during rendering operations
-	VkRenderPass vk_renderPass;
-
-	//Holds the graphics pipeline which will draw our triangle
-	VkPipeline vk_graphicsPipeline;
-
-	//Holds the framebuffer which wrap around the attachments specified in the render pass
-	std::vector<VkFramebuffer>framebuffers;
+	VulkanPipelineLayoutHandle vk_pipelineLayout;
+
+	/* Records the passes of a frame with the barriers between them and owns their render passes, framebuffers and 
+	   transient attachments. The graphics pipeline is compiled against the render pass of the main pass */
+	VulkanRenderGraph m_renderGraph;
+	uint32_t m_renderTargetResource;
+	uint32_t m_mainRenderGraphPass;
+	//The samples per pixel of the main pass, which the graphics pipeline is compiled with
+	VkSampleCountFlagBits m_msaaSamples;
+
+	//Holds the graphics pipeline which will draw our triangle. Stays null until its compilation is published
+	VulkanPipelineHandle vk_graphicsPipeline;
+
+	/* The SPIR-V reads start as soon as Init is called, and the pipelines are compiled on their own worker threads as soon
+	   as the render graph is compiled. Every future is consumed once, by the compilation or by publishing the pipeline */
+	std::chrono::steady_clock::time_point m_initStart;
+	std::future<ShaderCode> m_vertexShaderCode;
+	std::future<ShaderCode> m_fragShaderCode;
+	std::future<ShaderCode> m_cullingShaderCode;
+	std::string m_shaderDirectoryOverride;
+	std::future<CompiledPipeline> m_graphicsPipelineCompilation;
+	std::future<CompiledPipeline> m_cullingPipelineCompilation;
+
+	//The pipeline cache shared by every pipeline the application creates, persisted to disk between launches
+	VulkanPipelineCache m_pipelineCache;
+	std::string m_pipelineCacheFilename;
 
 	//Holds the command pool which can allocate the command buffers used to execute vulkan commands
-	VkCommandPool vk_commandPool;
-
-	//Holds a coomand buffer which records all the vulkan commands which our application needs
-	VkCommandBuffer vk_commandBuffer;
+	VulkanCommandPoolHandle vk_commandPool;
 
+	/* Holds the ring of frames in flight. Each frame owns the command buffer which records all the vulkan commands 
+	   that our application needs, as well as the semaphores and the fence that synchronize it */
 	VulkanSyncObjects m_syncObjects;
+	uint32_t m_framesInFlight;
+
+	//Destroys the resources that are replaced while frames in flight may still be using them, once those frames are done
+	VulkanDeletionQueue m_deletionQueue;
+
+	//Streams vertex and index data to the device local buffers through a staging ring, batched per frame
+	VulkanUploadQueue m_uploadQueue;
+
+	//The mesh drawn each frame. It is drawn once the upload queue has submitted the upload with the mesh's ticket
+	VertexFormat m_vertexFormat;
+	VulkanBuffer m_vertexBuffer;
+	VulkanBuffer m_indexBuffer;
+	uint32_t m_indexCount;
+	uint64_t m_meshUploadTicket;
+	//The file of a mesh loaded with LoadMesh, mapped until the upload queue has copied all of it into the staging ring
+	MeshFile m_meshFile;
+
+	//Times the frames and the named scopes inside them on the GPU
+	VulkanGpuProfiler m_gpuProfiler;
+	bool m_gpuProfilingEnabled;
+	bool m_pipelineStatisticsEnabled;
+
+	/* The instances drawn each frame. Each frame slot has its own instance buffer, so the CPU writes the buffer of the slot
+	   it is recording while the GPU reads the buffers of the other slots. The generation is incremented every time the 
+	   instances change, and each slot remembers the generation it last wrote so that unchanged instances are not copied */
+	std::vector<InstanceData> m_instances;
+	std::vector<VulkanBuffer> m_instanceBuffers;
+	std::vector<uint64_t> m_instanceBufferGenerations;
+	uint32_t m_instanceCapacity;
+	uint64_t m_instanceGeneration;
+
+	/* Culls the instances on the GPU against the bounding sphere of the mesh, whose radius is found when the mesh is set.
+	   The count variant of the indirect draw comes from an extension and is null if the device does not support it */
+	VulkanCullingPass m_cullingPass;
+	bool m_gpuCullingEnabled;
+	float m_meshBoundingRadius;
+	PFN_vkCmdDrawIndexedIndirectCountKHR vk_drawIndexedIndirectCount;
+
+	/* The per frame constants of the graphics pipeline go through the frame constant ring and the per draw ones are pushed.
+	   The frame's uniforms are the first block written in a frame, so they are always at the start of the slot's part of 
+	   the ring and the static command buffers of the slot can keep the dynamic offset they were recorded with */
+	VulkanFrameConstants m_frameConstants;
+	DrawPushConstants m_drawConstants;
+	FrameUniforms m_frameUniforms;
+	//The mesh that the passes of the frame being recorded draw
+	MeshBuffers m_recordedMesh;
+
+	/* The resources that the shaders index with handles. The default material lives in host visible memory, since it is 
+	   created before the upload queue, and the buffers of the other materials are stored at the index of their handle */
+	VulkanBindlessResources m_bindlessResources;
+	VulkanBuffer m_defaultMaterialBuffer;
+	std::vector<VulkanBuffer> m_materialBuffers;
+
+	/* Worker threads that record the render pass in parallel when enabled. The array holds the secondary command buffers
+	   that were recorded for the current frame, and is kept around so that it isn't reallocated every frame */
+	VulkanRecordingWorkers m_recordingWorkers;
+	uint32_t m_recordingThreadCount;
+	//0 draws every instance with a single draw, otherwise the instances are split into draws of up to this many
+	uint32_t m_instancesPerDraw;
+	std::vector<VkCommandBuffer> m_recordedSecondaryCommandBuffers;
+	double m_lastRecordingMs;
+
+	/* The static command buffers are laid out by frame slot and then by swapchain image, since the draws read the instance and
+	   culling buffers of the slot. Each one remembers the version of the static content it was recorded with, and the
+	   index count of the last recording marks the content dirty when the mesh finishes uploading */
+	bool m_staticCommandBuffersEnabled;
+	std::vector<VkCommandBuffer> m_staticCommandBuffers;
+	std::vector<uint64_t> m_staticCommandBufferVersions;
+	uint64_t m_staticContentVersion;
+	uint32_t m_staticContentIndexCount;
+
+	//The features that the logical device was created with
+	VkPhysicalDeviceFeatures m_enabledFeatures;
+
+	VulkanStartupTimings m_startupTimings;
 };
 
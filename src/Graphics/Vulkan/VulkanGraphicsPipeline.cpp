@@ -1,9 +1,9 @@
 #include "VulkanGraphics.h"
 
 void CreateVulkanGraphicsPipeline(VkPipeline& vk_graphicsPipeline, const VkGraphicsPipelineCreateInfo& vk_pipelineInfo,
-	const VkDevice& vk_device)
+	const VkDevice& vk_device, const VkPipelineCache& vk_pipelineCache)
 {
-	VkResult vk_pipelineCreationResult = vkCreateGraphicsPipelines(vk_device, nullptr, 1, &vk_pipelineInfo, nullptr,
+	VkResult vk_pipelineCreationResult = vkCreateGraphicsPipelines(vk_device, vk_pipelineCache, 1, &vk_pipelineInfo, nullptr,
 		&vk_graphicsPipeline);
 	if (vk_pipelineCreationResult != VK_SUCCESS)
 	{
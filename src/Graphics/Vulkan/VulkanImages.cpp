@@ -0,0 +1,18 @@
+#include "VulkanGraphics.h"
+
+void CreateVulkanImage(VkImage& vk_image, VulkanAllocation& imageAllocation, const VkImageCreateInfo& vk_imageInfo,
+	VkMemoryPropertyFlags vk_memoryProperties, bool dedicated, const VkDevice& vk_device, 
+	VulkanMemoryAllocator& memoryAllocator)
+{
+	VkResult vk_imageCreationResult = vkCreateImage(vk_device, &vk_imageInfo, nullptr, &vk_image);
+	if (vk_imageCreationResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+
+	//The allocator picks a memory type with the properties we asked for, allocates the memory and binds it to the image
+	if (!memoryAllocator.AllocateForImage(vk_image, vk_memoryProperties, 0, dedicated, imageAllocation))
+	{
+		__debugbreak();
+	}
+}
\ No newline at end of file
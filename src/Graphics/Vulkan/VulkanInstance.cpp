@@ -1,10 +1,12 @@
 #include "VulkanGraphics.h"
 #include <vector>
 #include <iostream>
+#include <cstring>
 
 
 
-void CreateVulkanInstance(VkInstance* vk_instance, VkInstanceCreateInfo& vk_instanceInfo)
+void CreateVulkanInstance(VkInstance* vk_instance, VkInstanceCreateInfo& vk_instanceInfo,
+	const std::vector<const char*>& requiredInstanceExtensions)
 {
 	//Retrieving and printing available extensions
 	uint32_t instanceExtensionCount = 0;
@@ -17,16 +19,29 @@ void CreateVulkanInstance(VkInstance* vk_instance, VkInstanceCreateInfo& vk_inst
 		std::cout << extension.extensionName << '\n';
 	}
 
-	//Enabling required extensions
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-	vk_instanceInfo.enabledExtensionCount = glfwExtensionCount;
-	vk_instanceInfo.ppEnabledExtensionNames = glfwExtensions;
+	//Enabling required extensions, a headless application does not need any window system extensions
+	vk_instanceInfo.enabledExtensionCount = static_cast<uint32_t>(requiredInstanceExtensions.size());
+	vk_instanceInfo.ppEnabledExtensionNames = requiredInstanceExtensions.data();
 	
 	VkResult vk_instanceCreationResult = vkCreateInstance(&vk_instanceInfo, nullptr, vk_instance);
 	if (vk_instanceCreationResult != VK_SUCCESS)
 	{
 		__debugbreak();
 	}
+}
+
+bool CheckInstanceExtensionSupport(const char* instanceExtension)
+{
+	uint32_t instanceExtensionCount = 0;
+	vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, nullptr);
+	std::vector<VkExtensionProperties> availableExtensions(instanceExtensionCount);
+	vkEnumerateInstanceExtensionProperties(nullptr, &instanceExtensionCount, availableExtensions.data());
+	for (const VkExtensionProperties& extension : availableExtensions)
+	{
+		if (!strcmp(extension.extensionName, instanceExtension))
+		{
+			return true;
+		}
+	}
+	return false;
 }
\ No newline at end of file
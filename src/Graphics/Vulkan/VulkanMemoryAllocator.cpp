@@ -0,0 +1,367 @@
+#include "VulkanMemoryAllocator.h"
+#include <algorithm>
+
+VulkanMemoryAllocator::VulkanMemoryAllocator()
+	:vk_device(VK_NULL_HANDLE), vk_memoryProperties(), m_maxAllocationCount(0), m_blockSize(0), m_buddyOrderCount(0),
+	m_pools(), m_deviceAllocationCount(0), m_dedicatedAllocationCount(0), m_dedicatedBytes(0)
+{
+
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator()
+{
+
+}
+
+void VulkanMemoryAllocator::Init(const VkDevice& device, const VkPhysicalDevice& vk_graphicsCard, VkDeviceSize blockSize)
+{
+	vk_device = device;
+	vkGetPhysicalDeviceMemoryProperties(vk_graphicsCard, &vk_memoryProperties);
+	VkPhysicalDeviceProperties vk_gpuProperties;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &vk_gpuProperties);
+	m_maxAllocationCount = vk_gpuProperties.limits.maxMemoryAllocationCount;
+
+	//The buddy strategy needs the block size to be a power of two multiple of the smallest range
+	m_blockSize = MIN_BUDDY_ALLOCATION_SIZE;
+	m_buddyOrderCount = 1;
+	while (m_blockSize < blockSize)
+	{
+		m_blockSize <<= 1;
+		++m_buddyOrderCount;
+	}
+}
+
+uint32_t VulkanMemoryAllocator::FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags vk_requiredProperties,
+	VkMemoryPropertyFlags vk_preferredProperties) const
+{
+	//Memory types are ordered by the driver from the most to the least performant, so the first match is the best one
+	VkMemoryPropertyFlags vk_wantedProperties[] = { vk_requiredProperties | vk_preferredProperties, vk_requiredProperties };
+	for (VkMemoryPropertyFlags vk_properties : vk_wantedProperties)
+	{
+		for (uint32_t i = 0; i < vk_memoryProperties.memoryTypeCount; ++i)
+		{
+			if ((memoryTypeBits & (1 << i)) &&
+				(vk_memoryProperties.memoryTypes[i].propertyFlags & vk_properties) == vk_properties)
+			{
+				return i;
+			}
+		}
+	}
+	return UINT32_MAX;
+}
+
+bool VulkanMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory& vk_memory,
+	void*& mappedData)
+{
+	if (m_deviceAllocationCount >= m_maxAllocationCount)
+	{
+		return false;
+	}
+
+	VkMemoryAllocateInfo vk_memoryAllocInfo{};
+	vk_memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	vk_memoryAllocInfo.allocationSize = size;
+	vk_memoryAllocInfo.memoryTypeIndex = memoryTypeIndex;
+	if (vkAllocateMemory(vk_device, &vk_memoryAllocInfo, nullptr, &vk_memory) != VK_SUCCESS)
+	{
+		return false;
+	}
+	++m_deviceAllocationCount;
+
+	//Host visible memory is mapped once and stays mapped, so that writing to it never needs a map call
+	mappedData = nullptr;
+	if (vk_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+	{
+		vkMapMemory(vk_device, vk_memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+	}
+	return true;
+}
+
+bool VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& vk_memoryRequirements, 
+	VkMemoryPropertyFlags vk_requiredProperties, VkMemoryPropertyFlags vk_preferredProperties, bool linearResource, 
+	bool dedicated, VulkanAllocationStrategy strategy, VulkanAllocation& allocation)
+{
+	uint32_t memoryTypeIndex = FindMemoryType(vk_memoryRequirements.memoryTypeBits, vk_requiredProperties, 
+		vk_preferredProperties);
+	if (memoryTypeIndex == UINT32_MAX)
+	{
+		return false;
+	}
+
+	//Resources that would take up most of a block get their own device allocation
+	if (dedicated || vk_memoryRequirements.size > m_blockSize / 2)
+	{
+		allocation = {};
+		if (!AllocateDeviceMemory(vk_memoryRequirements.size, memoryTypeIndex, allocation.vk_memory, allocation.mappedData))
+		{
+			return false;
+		}
+		allocation.size = vk_memoryRequirements.size;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+		++m_dedicatedAllocationCount;
+		m_dedicatedBytes += allocation.size;
+		return true;
+	}
+
+	uint32_t poolIndex = 0;
+	while (poolIndex < m_pools.size() && (m_pools[poolIndex].memoryTypeIndex != memoryTypeIndex ||
+		m_pools[poolIndex].linearResources != linearResource || m_pools[poolIndex].strategy != strategy))
+	{
+		++poolIndex;
+	}
+	if (poolIndex == m_pools.size())
+	{
+		MemoryPool pool{};
+		pool.memoryTypeIndex = memoryTypeIndex;
+		pool.linearResources = linearResource;
+		pool.strategy = strategy;
+		m_pools.push_back(pool);
+	}
+	MemoryPool& pool = m_pools[poolIndex];
+
+	for (uint32_t i = 0; i < pool.blocks.size(); ++i)
+	{
+		if (AllocateFromBlock(pool, pool.blocks[i], vk_memoryRequirements, allocation))
+		{
+			allocation.poolIndex = poolIndex;
+			allocation.blockIndex = i;
+			return true;
+		}
+	}
+
+	//None of the existing blocks had room, so a new one is allocated from the device
+	if (!CreateBlock(pool) || !AllocateFromBlock(pool, pool.blocks.back(), vk_memoryRequirements, allocation))
+	{
+		return false;
+	}
+	allocation.poolIndex = poolIndex;
+	allocation.blockIndex = static_cast<uint32_t>(pool.blocks.size() - 1);
+	return true;
+}
+
+bool VulkanMemoryAllocator::CreateBlock(MemoryPool& pool)
+{
+	MemoryBlock block{};
+	if (!AllocateDeviceMemory(m_blockSize, pool.memoryTypeIndex, block.vk_memory, block.mappedData))
+	{
+		return false;
+	}
+	block.size = m_blockSize;
+	//A new block starts out as one free range of the highest order
+	block.freeRanges.resize(m_buddyOrderCount);
+	block.freeRanges[m_buddyOrderCount - 1].push_back(0);
+	pool.blocks.push_back(block);
+	return true;
+}
+
+bool VulkanMemoryAllocator::AllocateFromBlock(MemoryPool& pool, MemoryBlock& block, 
+	const VkMemoryRequirements& vk_memoryRequirements, VulkanAllocation& allocation)
+{
+	allocation = {};
+	if (pool.strategy == VulkanAllocationStrategy::Buddy)
+	{
+		if (!AllocateBuddy(block, vk_memoryRequirements.size, vk_memoryRequirements.alignment, allocation))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		VkDeviceSize offset = (block.linearHead + vk_memoryRequirements.alignment - 1) & 
+			~(vk_memoryRequirements.alignment - 1);
+		if (offset + vk_memoryRequirements.size > block.size)
+		{
+			return false;
+		}
+		block.linearHead = offset + vk_memoryRequirements.size;
+		allocation.offset = offset;
+		allocation.size = vk_memoryRequirements.size;
+	}
+
+	allocation.vk_memory = block.vk_memory;
+	allocation.memoryTypeIndex = pool.memoryTypeIndex;
+	allocation.mappedData = block.mappedData ? static_cast<char*>(block.mappedData) + allocation.offset : nullptr;
+	++block.allocationCount;
+	block.usedBytes += allocation.size;
+	return true;
+}
+
+bool VulkanMemoryAllocator::AllocateBuddy(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment,
+	VulkanAllocation& allocation)
+{
+	/* Buddy ranges are aligned to their own size, so rounding the request up to a power of two that is at least 
+	   the alignment satisfies the alignment as well */
+	VkDeviceSize rangeSize = MIN_BUDDY_ALLOCATION_SIZE;
+	uint32_t order = 0;
+	while (rangeSize < size || rangeSize < alignment)
+	{
+		rangeSize <<= 1;
+		++order;
+	}
+	if (order >= m_buddyOrderCount)
+	{
+		return false;
+	}
+
+	//Finding the smallest free range that is big enough and splitting it in halves until it has the size we need
+	uint32_t freeOrder = order;
+	while (freeOrder < m_buddyOrderCount && block.freeRanges[freeOrder].empty())
+	{
+		++freeOrder;
+	}
+	if (freeOrder == m_buddyOrderCount)
+	{
+		return false;
+	}
+	VkDeviceSize offset = block.freeRanges[freeOrder].back();
+	block.freeRanges[freeOrder].pop_back();
+	while (freeOrder > order)
+	{
+		--freeOrder;
+		block.freeRanges[freeOrder].push_back(offset + (MIN_BUDDY_ALLOCATION_SIZE << freeOrder));
+	}
+
+	allocation.offset = offset;
+	allocation.size = rangeSize;
+	allocation.buddyOrder = order;
+	return true;
+}
+
+void VulkanMemoryAllocator::FreeBuddy(MemoryBlock& block, VkDeviceSize offset, uint32_t order)
+{
+	//Merging the range with its buddy for as long as the buddy is free as well
+	while (order + 1 < m_buddyOrderCount)
+	{
+		VkDeviceSize buddyOffset = offset ^ (MIN_BUDDY_ALLOCATION_SIZE << order);
+		std::vector<VkDeviceSize>& freeRanges = block.freeRanges[order];
+		std::vector<VkDeviceSize>::iterator buddy = std::find(freeRanges.begin(), freeRanges.end(), buddyOffset);
+		if (buddy == freeRanges.end())
+		{
+			break;
+		}
+		freeRanges.erase(buddy);
+		offset = (std::min)(offset, buddyOffset);
+		++order;
+	}
+	block.freeRanges[order].push_back(offset);
+}
+
+bool VulkanMemoryAllocator::AllocateForBuffer(const VkBuffer& vk_buffer, VkMemoryPropertyFlags vk_requiredProperties,
+	VkMemoryPropertyFlags vk_preferredProperties, VulkanAllocationStrategy strategy, VulkanAllocation& allocation)
+{
+	VkMemoryRequirements vk_memoryRequirements;
+	vkGetBufferMemoryRequirements(vk_device, vk_buffer, &vk_memoryRequirements);
+	if (!Allocate(vk_memoryRequirements, vk_requiredProperties, vk_preferredProperties, true, false, strategy, allocation))
+	{
+		return false;
+	}
+	vkBindBufferMemory(vk_device, vk_buffer, allocation.vk_memory, allocation.offset);
+	return true;
+}
+
+bool VulkanMemoryAllocator::AllocateForImage(const VkImage& vk_image, VkMemoryPropertyFlags vk_requiredProperties,
+	VkMemoryPropertyFlags vk_preferredProperties, bool dedicated, VulkanAllocation& allocation)
+{
+	VkMemoryRequirements vk_memoryRequirements;
+	vkGetImageMemoryRequirements(vk_device, vk_image, &vk_memoryRequirements);
+	if (!Allocate(vk_memoryRequirements, vk_requiredProperties, vk_preferredProperties, false, dedicated,
+		VulkanAllocationStrategy::Buddy, allocation))
+	{
+		return false;
+	}
+	vkBindImageMemory(vk_device, vk_image, allocation.vk_memory, allocation.offset);
+	return true;
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation)
+{
+	if (allocation.vk_memory == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	if (allocation.poolIndex == UINT32_MAX)
+	{
+		vkFreeMemory(vk_device, allocation.vk_memory, nullptr);
+		--m_deviceAllocationCount;
+		--m_dedicatedAllocationCount;
+		m_dedicatedBytes -= allocation.size;
+	}
+	else
+	{
+		MemoryPool& pool = m_pools[allocation.poolIndex];
+		MemoryBlock& block = pool.blocks[allocation.blockIndex];
+		--block.allocationCount;
+		block.usedBytes -= allocation.size;
+		if (pool.strategy == VulkanAllocationStrategy::Buddy)
+		{
+			FreeBuddy(block, allocation.offset, allocation.buddyOrder);
+		}
+		else if (!block.allocationCount)
+		{
+			//The linear strategy can only reuse a block once everything in it has been freed
+			block.linearHead = 0;
+		}
+	}
+	allocation = {};
+}
+
+void VulkanMemoryAllocator::GetStatistics(VulkanMemoryStatistics& statistics) const
+{
+	statistics = {};
+	statistics.dedicatedAllocationCount = m_dedicatedAllocationCount;
+	statistics.allocationCount = m_dedicatedAllocationCount;
+	statistics.reservedBytes = m_dedicatedBytes;
+	statistics.usedBytes = m_dedicatedBytes;
+
+	VkDeviceSize blockFreeBytes = 0;
+	for (const MemoryPool& pool : m_pools)
+	{
+		for (const MemoryBlock& block : pool.blocks)
+		{
+			++statistics.blockCount;
+			statistics.allocationCount += block.allocationCount;
+			statistics.reservedBytes += block.size;
+			statistics.usedBytes += block.usedBytes;
+			blockFreeBytes += block.size - block.usedBytes;
+
+			VkDeviceSize largestFreeRange = 0;
+			if (pool.strategy == VulkanAllocationStrategy::Buddy)
+			{
+				for (uint32_t order = 0; order < block.freeRanges.size(); ++order)
+				{
+					if (!block.freeRanges[order].empty())
+					{
+						largestFreeRange = MIN_BUDDY_ALLOCATION_SIZE << order;
+					}
+				}
+			}
+			else
+			{
+				largestFreeRange = block.allocationCount ? block.size - block.linearHead : block.size;
+			}
+			statistics.largestFreeRange = (std::max)(statistics.largestFreeRange, largestFreeRange);
+		}
+	}
+
+	if (blockFreeBytes)
+	{
+		statistics.fragmentation = 1.0f - static_cast<float>(statistics.largestFreeRange) / 
+			static_cast<float>(blockFreeBytes);
+	}
+}
+
+void VulkanMemoryAllocator::Cleanup()
+{
+	for (MemoryPool& pool : m_pools)
+	{
+		for (MemoryBlock& block : pool.blocks)
+		{
+			vkFreeMemory(vk_device, block.vk_memory, nullptr);
+		}
+	}
+	m_pools.clear();
+	m_deviceAllocationCount = 0;
+	m_dedicatedAllocationCount = 0;
+	m_dedicatedBytes = 0;
+}
\ No newline at end of file
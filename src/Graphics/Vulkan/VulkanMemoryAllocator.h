@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include "glfwVulkan.h"
+
+//The size of the device memory blocks that allocations are carved from, unless the allocator is told otherwise
+constexpr VkDeviceSize DEFAULT_MEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+//The smallest range the buddy strategy hands out, smaller requests are rounded up to it
+constexpr VkDeviceSize MIN_BUDDY_ALLOCATION_SIZE = 256;
+
+/* How allocations are carved out of a memory block
+   - Buddy splits the block into power of two ranges and merges them back when they are freed, it suits resources
+     that live for a long and different amount of time
+   - Linear only moves a head forward and resets the whole block once every allocation in it has been freed, it suits
+     resources that are created and destroyed together, like per frame or upload data */
+enum class VulkanAllocationStrategy
+{
+	Buddy,
+	Linear
+};
+
+//A range of device memory handed out by the allocator
+struct VulkanAllocation
+{
+	VkDeviceMemory vk_memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	//Points to the start of the range if the memory is host visible, host visible memory is kept persistently mapped
+	void* mappedData = nullptr;
+	uint32_t memoryTypeIndex = 0;
+
+	//Where the allocation came from so that it can be freed, dedicated allocations don't belong to a pool
+	uint32_t poolIndex = UINT32_MAX;
+	uint32_t blockIndex = 0;
+	//The size of a buddy range is MIN_BUDDY_ALLOCATION_SIZE << order
+	uint32_t buddyOrder = 0;
+};
+
+//Usage statistics of the allocator, used to tune the block size and to catch fragmentation
+struct VulkanMemoryStatistics
+{
+	uint32_t blockCount;
+	uint32_t dedicatedAllocationCount;
+	uint32_t allocationCount;
+	//The memory allocated from the device, with vkAllocateMemory
+	VkDeviceSize reservedBytes;
+	//The memory that is handed out to resources, including the padding needed for alignment
+	VkDeviceSize usedBytes;
+	VkDeviceSize largestFreeRange;
+	//0 when all the free memory is in one range, close to 1 when the free memory is split into many small ranges
+	float fragmentation;
+};
+
+/* Sub-allocates resources from large blocks of device memory so that the application does not call vkAllocateMemory for
+   every resource (the amount of device allocations is limited by maxMemoryAllocationCount). Blocks are grouped in pools by
+   memory type and by whether the resources are linear (buffers) or optimal (images), so that a buffer and an image never
+   share a bufferImageGranularity page */
+class VulkanMemoryAllocator
+{
+public:
+	VulkanMemoryAllocator();
+	~VulkanMemoryAllocator();
+
+	void Init(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard,
+		VkDeviceSize blockSize = DEFAULT_MEMORY_BLOCK_SIZE);
+
+	/* Allocates memory that satisfies the requirements passed. The memory type needs to have the required property flags
+	   and is preferred to have the preferred ones as well. Large resources (or the ones that ask for it) get a dedicated
+	   device allocation instead of being carved from a block. Returns false if the memory could not be allocated */
+	bool Allocate(const VkMemoryRequirements& vk_memoryRequirements, VkMemoryPropertyFlags vk_requiredProperties,
+		VkMemoryPropertyFlags vk_preferredProperties, bool linearResource, bool dedicated, VulkanAllocationStrategy strategy,
+		VulkanAllocation& allocation);
+
+	//Allocates memory for a buffer and binds it to the buffer
+	bool AllocateForBuffer(const VkBuffer& vk_buffer, VkMemoryPropertyFlags vk_requiredProperties,
+		VkMemoryPropertyFlags vk_preferredProperties, VulkanAllocationStrategy strategy, VulkanAllocation& allocation);
+
+	//Allocates memory for an image with optimal tiling and binds it to the image
+	bool AllocateForImage(const VkImage& vk_image, VkMemoryPropertyFlags vk_requiredProperties,
+		VkMemoryPropertyFlags vk_preferredProperties, bool dedicated, VulkanAllocation& allocation);
+
+	void Free(VulkanAllocation& allocation);
+
+	void GetStatistics(VulkanMemoryStatistics& statistics) const;
+
+	//Frees every block, all the allocations need to have been freed (or their resources destroyed) before this is called
+	void Cleanup();
+
+	inline const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return vk_memoryProperties; }
+private:
+	//A single device allocation that resources are carved from
+	struct MemoryBlock
+	{
+		VkDeviceMemory vk_memory = VK_NULL_HANDLE;
+		void* mappedData = nullptr;
+		VkDeviceSize size = 0;
+		//The offsets of the free ranges of each buddy order
+		std::vector<std::vector<VkDeviceSize>> freeRanges;
+		//The head of the linear strategy, everything before it is in use
+		VkDeviceSize linearHead = 0;
+		uint32_t allocationCount = 0;
+		VkDeviceSize usedBytes = 0;
+	};
+
+	struct MemoryPool
+	{
+		uint32_t memoryTypeIndex;
+		bool linearResources;
+		VulkanAllocationStrategy strategy;
+		std::vector<MemoryBlock> blocks;
+	};
+
+	//Returns the index of a memory type, UINT32_MAX if none of the allowed types has the required properties
+	uint32_t FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags vk_requiredProperties,
+		VkMemoryPropertyFlags vk_preferredProperties) const;
+
+	//Allocates device memory and maps it if the memory type is host visible
+	bool AllocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, VkDeviceMemory& vk_memory, void*& mappedData);
+
+	bool CreateBlock(MemoryPool& pool);
+
+	bool AllocateFromBlock(MemoryPool& pool, MemoryBlock& block, const VkMemoryRequirements& vk_memoryRequirements,
+		VulkanAllocation& allocation);
+
+	bool AllocateBuddy(MemoryBlock& block, VkDeviceSize size, VkDeviceSize alignment, VulkanAllocation& allocation);
+
+	void FreeBuddy(MemoryBlock& block, VkDeviceSize offset, uint32_t order);
+private:
+	VkDevice vk_device;
+	VkPhysicalDeviceMemoryProperties vk_memoryProperties;
+	uint32_t m_maxAllocationCount;
+	VkDeviceSize m_blockSize;
+	uint32_t m_buddyOrderCount;
+
+	std::vector<MemoryPool> m_pools;
+	//The amount of live device allocations (blocks and dedicated allocations), limited by maxMemoryAllocationCount
+	uint32_t m_deviceAllocationCount;
+	uint32_t m_dedicatedAllocationCount;
+	VkDeviceSize m_dedicatedBytes;
+};
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "VulkanGraphics.h"
+#include <filesystem>
+#include <cstring>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+//Written at the start of every cache file so that files that were not written by the application are rejected
+constexpr uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43505456;
+
+static int CurrentProcessId()
+{
+#ifdef _WIN32
+	return _getpid();
+#else
+	return static_cast<int>(getpid());
+#endif
+}
+
+VulkanPipelineCache::VulkanPipelineCache()
+	:vk_pipelineCache(VK_NULL_HANDLE), m_cacheFilename(), m_gpuProperties(), m_loadedFromDisk(false)
+{
+
+}
+
+VulkanPipelineCache::~VulkanPipelineCache()
+{
+
+}
+
+void VulkanPipelineCache::CreatePipelineCache(const VkDevice& vk_device, const VkPhysicalDevice& vk_graphicsCard,
+	const char* cacheFilename)
+{
+	m_cacheFilename = cacheFilename;
+	vkGetPhysicalDeviceProperties(vk_graphicsCard, &m_gpuProperties);
+
+	std::vector<char> cacheData;
+	m_loadedFromDisk = ReadPipelineCacheFile(cacheData);
+
+	VkPipelineCacheCreateInfo vk_pipelineCacheInfo{};
+	vk_pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	//If the file was missing or was written for a different graphics card or driver, the cache starts out empty
+	vk_pipelineCacheInfo.initialDataSize = m_loadedFromDisk ? cacheData.size() : 0;
+	vk_pipelineCacheInfo.pInitialData = m_loadedFromDisk ? cacheData.data() : nullptr;
+	VkResult vk_pipelineCacheCreationResult = vkCreatePipelineCache(vk_device, &vk_pipelineCacheInfo, nullptr,
+		&vk_pipelineCache);
+	if (vk_pipelineCacheCreationResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+}
+
+bool VulkanPipelineCache::ReadPipelineCacheFile(std::vector<char>& cacheData)
+{
+	std::ifstream cacheFile(m_cacheFilename, std::ios::ate | std::ios::binary);
+	if (!cacheFile.is_open())
+	{
+		return false;
+	}
+
+	size_t filesize = static_cast<size_t>(cacheFile.tellg());
+	if (filesize < sizeof(PipelineCacheFileHeader))
+	{
+		return false;
+	}
+	cacheFile.seekg(0);
+	PipelineCacheFileHeader fileHeader{};
+	cacheFile.read(reinterpret_cast<char*>(&fileHeader), sizeof(PipelineCacheFileHeader));
+
+	//The cache is only valid for the exact graphics card and driver version that created it
+	if (fileHeader.magic != PIPELINE_CACHE_FILE_MAGIC || 
+		fileHeader.dataSize != filesize - sizeof(PipelineCacheFileHeader) ||
+		fileHeader.vendorID != m_gpuProperties.vendorID || fileHeader.deviceID != m_gpuProperties.deviceID ||
+		fileHeader.driverVersion != m_gpuProperties.driverVersion ||
+		memcmp(fileHeader.pipelineCacheUUID, m_gpuProperties.pipelineCacheUUID, VK_UUID_SIZE))
+	{
+		return false;
+	}
+
+	cacheData.resize(fileHeader.dataSize);
+	cacheFile.read(cacheData.data(), fileHeader.dataSize);
+	if (!cacheFile)
+	{
+		return false;
+	}
+
+	//The data itself starts with the header that vulkan writes, which is checked as well in case the file was tampered with
+	VkPipelineCacheHeaderVersionOne vk_cacheHeader{};
+	if (cacheData.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+	{
+		return false;
+	}
+	memcpy(&vk_cacheHeader, cacheData.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+	return vk_cacheHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		vk_cacheHeader.vendorID == m_gpuProperties.vendorID && vk_cacheHeader.deviceID == m_gpuProperties.deviceID &&
+		!memcmp(vk_cacheHeader.pipelineCacheUUID, m_gpuProperties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+void VulkanPipelineCache::SavePipelineCache(const VkDevice& vk_device)
+{
+	size_t cacheDataSize = 0;
+	vkGetPipelineCacheData(vk_device, vk_pipelineCache, &cacheDataSize, nullptr);
+	std::vector<char> cacheData(cacheDataSize);
+	if (vkGetPipelineCacheData(vk_device, vk_pipelineCache, &cacheDataSize, cacheData.data()) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	PipelineCacheFileHeader fileHeader{};
+	fileHeader.magic = PIPELINE_CACHE_FILE_MAGIC;
+	fileHeader.dataSize = static_cast<uint32_t>(cacheDataSize);
+	fileHeader.vendorID = m_gpuProperties.vendorID;
+	fileHeader.deviceID = m_gpuProperties.deviceID;
+	fileHeader.driverVersion = m_gpuProperties.driverVersion;
+	memcpy(fileHeader.pipelineCacheUUID, m_gpuProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	/* The cache is written to a temporary file which then replaces the old one, so that a crash or a second instance 
+	   of the application never leaves a half written cache behind. Each process writes its own temporary file, so two
+	   instances saving at the same time don't write into the same one, and a failed write removes it again */
+	std::string temporaryFilename = m_cacheFilename + "." + std::to_string(CurrentProcessId()) + ".tmp";
+	bool written = false;
+	{
+		std::ofstream cacheFile(temporaryFilename, std::ios::binary | std::ios::trunc);
+		if (!cacheFile.is_open())
+		{
+			return;
+		}
+		cacheFile.write(reinterpret_cast<const char*>(&fileHeader), sizeof(PipelineCacheFileHeader));
+		cacheFile.write(cacheData.data(), cacheDataSize);
+		cacheFile.close();
+		written = !cacheFile.fail();
+	}
+	std::error_code renameError;
+	if (!written)
+	{
+		std::filesystem::remove(temporaryFilename, renameError);
+		return;
+	}
+	std::filesystem::rename(temporaryFilename, m_cacheFilename, renameError);
+	if (renameError)
+	{
+		std::filesystem::remove(temporaryFilename, renameError);
+	}
+}
+
+void VulkanPipelineCache::Cleanup(const VkDevice& vk_device)
+{
+	vkDestroyPipelineCache(vk_device, vk_pipelineCache, nullptr);
+	vk_pipelineCache = VK_NULL_HANDLE;
+}
\ No newline at end of file
@@ -15,7 +15,7 @@ void CreateVulkanSubmitInfo(VkSubmitInfo& vk_submitInfo, uint32_t waitSemaphoreC
 }
 
 void CreateVulkanPresentInfo(VkPresentInfoKHR& vk_presentInfo, uint32_t waitSemaphoreCount, VkSemaphore* vk_waitSemaphores,
-	uint32_t swapchainCount, VkSwapchainKHR* vk_swapchains, uint32_t imageIndex)
+	uint32_t swapchainCount, VkSwapchainKHR* vk_swapchains, const uint32_t& imageIndex)
 {
 	vk_presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	vk_presentInfo.waitSemaphoreCount = waitSemaphoreCount;
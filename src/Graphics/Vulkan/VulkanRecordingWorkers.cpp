@@ -0,0 +1,165 @@
+#include "VulkanGraphics.h"
+
+VulkanRecordingWorkers::VulkanRecordingWorkers()
+	:vk_device(VK_NULL_HANDLE), m_workers(), m_mutex(), m_workAvailable(), m_workFinished(), m_workGeneration(0),
+	m_busyWorkers(0), m_stopping(false), m_frameIndex(0), m_inheritanceInfo(nullptr), m_recordJobs(nullptr)
+{
+
+}
+
+VulkanRecordingWorkers::~VulkanRecordingWorkers()
+{
+
+}
+
+void VulkanRecordingWorkers::Init(const VkDevice& device, uint32_t graphicsQueueFamilyIndex, uint32_t threadCount, 
+	uint32_t framesInFlight)
+{
+	vk_device = device;
+	m_stopping = false;
+	m_workGeneration = 0;
+	m_busyWorkers = 0;
+
+	/* The whole pool is reset every time its slot comes around again, so the command buffers don't need to be reset
+	   one by one and the pool can be told that its memory is short lived */
+	VkCommandPoolCreateInfo vk_commandPoolInfo{};
+	vk_commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	vk_commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	vk_commandPoolInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
+
+	//The workers are all created before any thread starts, the threads keep referencing their entry of the array
+	m_workers.resize(threadCount);
+	for (RecordingWorker& worker : m_workers)
+	{
+		worker.commandPools.resize(framesInFlight);
+		worker.commandBuffers.resize(framesInFlight);
+		for (uint32_t i = 0; i < framesInFlight; ++i)
+		{
+			CreateVulkanCommandPool(worker.commandPools[i], vk_commandPoolInfo, vk_device);
+
+			VkCommandBufferAllocateInfo vk_commandBufferInfo{};
+			vk_commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			vk_commandBufferInfo.commandPool = worker.commandPools[i];
+			vk_commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			vk_commandBufferInfo.commandBufferCount = 1;
+			AllocateVulkanCommandBuffer(worker.commandBuffers[i], vk_device, vk_commandBufferInfo);
+		}
+	}
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		m_workers[i].thread = std::thread(&VulkanRecordingWorkers::WorkerLoop, this, i);
+	}
+}
+
+void VulkanRecordingWorkers::Record(uint32_t frameIndex, const VkCommandBufferInheritanceInfo& vk_inheritanceInfo, 
+	uint32_t jobCount, const RecordFunction& recordJobs, std::vector<VkCommandBuffer>& recordedCommandBuffers)
+{
+	recordedCommandBuffers.clear();
+	if (m_workers.empty() || !jobCount)
+	{
+		return;
+	}
+
+	//Every worker gets a contiguous range of the jobs, the first ones take one extra job each when they don't divide evenly
+	uint32_t workerCount = static_cast<uint32_t>(m_workers.size());
+	uint32_t jobsPerWorker = jobCount / workerCount;
+	uint32_t remainingJobs = jobCount % workerCount;
+	uint32_t firstJob = 0;
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			m_workers[i].firstJob = firstJob;
+			m_workers[i].jobCount = jobsPerWorker + (i < remainingJobs ? 1 : 0);
+			firstJob += m_workers[i].jobCount;
+		}
+		m_frameIndex = frameIndex;
+		m_inheritanceInfo = &vk_inheritanceInfo;
+		m_recordJobs = &recordJobs;
+		m_busyWorkers = workerCount;
+		++m_workGeneration;
+		m_workAvailable.notify_all();
+
+		m_workFinished.wait(lock, [this]() { return m_busyWorkers == 0; });
+		m_inheritanceInfo = nullptr;
+		m_recordJobs = nullptr;
+	}
+
+	for (RecordingWorker& worker : m_workers)
+	{
+		if (worker.jobCount)
+		{
+			recordedCommandBuffers.push_back(worker.commandBuffers[frameIndex]);
+		}
+	}
+}
+
+void VulkanRecordingWorkers::WorkerLoop(uint32_t workerIndex)
+{
+	RecordingWorker& worker = m_workers[workerIndex];
+	uint64_t recordedGeneration = 0;
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_workAvailable.wait(lock, [this, recordedGeneration]() 
+			{ return m_stopping || m_workGeneration != recordedGeneration; });
+		if (m_stopping)
+		{
+			return;
+		}
+		recordedGeneration = m_workGeneration;
+		uint32_t frameIndex = m_frameIndex;
+		const VkCommandBufferInheritanceInfo* vk_inheritanceInfo = m_inheritanceInfo;
+		const RecordFunction* recordJobs = m_recordJobs;
+		lock.unlock();
+
+		if (worker.jobCount)
+		{
+			//The fence of the slot has been waited on, so nothing that was allocated from this pool is still in use
+			vkResetCommandPool(vk_device, worker.commandPools[frameIndex], 0);
+
+			VkCommandBuffer vk_commandBuffer = worker.commandBuffers[frameIndex];
+			VkCommandBufferBeginInfo vk_commandBufferBegin{};
+			CreateVulkanCommandBufferBeginInfo(vk_commandBufferBegin, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+				VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, const_cast<VkCommandBufferInheritanceInfo*>(vk_inheritanceInfo));
+			if (vkBeginCommandBuffer(vk_commandBuffer, &vk_commandBufferBegin) != VK_SUCCESS)
+			{
+				__debugbreak();
+			}
+			(*recordJobs)(vk_commandBuffer, worker.firstJob, worker.jobCount);
+			if (vkEndCommandBuffer(vk_commandBuffer) != VK_SUCCESS)
+			{
+				__debugbreak();
+			}
+		}
+
+		lock.lock();
+		if (--m_busyWorkers == 0)
+		{
+			m_workFinished.notify_one();
+		}
+	}
+}
+
+void VulkanRecordingWorkers::Cleanup()
+{
+	if (m_workers.empty())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_workAvailable.notify_all();
+	for (RecordingWorker& worker : m_workers)
+	{
+		worker.thread.join();
+		//Destroying the pools frees the command buffers that were allocated from them
+		for (VkCommandPool& vk_commandPool : worker.commandPools)
+		{
+			vkDestroyCommandPool(vk_device, vk_commandPool, nullptr);
+		}
+	}
+	m_workers.clear();
+}
\ No newline at end of file
@@ -0,0 +1,807 @@
+#include "VulkanGraphics.h"
+#include <algorithm>
+
+//The accesses that write to memory, a later access only has to wait for these to be made available
+constexpr VkAccessFlags RENDER_GRAPH_WRITE_ACCESS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+	VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+//The usage an image needs to be created with to be used in the layout passed
+static VkImageUsageFlags GetImageUsage(VkImageLayout vk_layout)
+{
+	switch (vk_layout)
+	{
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+		return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+		return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		return VK_IMAGE_USAGE_SAMPLED_BIT;
+	case VK_IMAGE_LAYOUT_GENERAL:
+		return VK_IMAGE_USAGE_STORAGE_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+		return VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+		return VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	default:
+		return 0;
+	}
+}
+
+static bool IsAttachmentLayout(VkImageLayout vk_layout)
+{
+	return vk_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL || vk_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+}
+
+RenderGraphAccessInfo GetRenderGraphAccessInfo(RenderGraphAccess access)
+{
+	//The accesses that only buffers are used with leave the layout undefined
+	switch (access)
+	{
+	case RenderGraphAccess::ColorAttachment:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true };
+	case RenderGraphAccess::DepthStencilAttachment:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true };
+	case RenderGraphAccess::FragmentShaderRead:
+		return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			false };
+	case RenderGraphAccess::ComputeShaderRead:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			false };
+	case RenderGraphAccess::ComputeShaderWrite:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_IMAGE_LAYOUT_GENERAL, true };
+	case RenderGraphAccess::IndirectCommandRead:
+		return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+	case RenderGraphAccess::VertexAttributeRead:
+		return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, false };
+	case RenderGraphAccess::TransferRead:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false };
+	case RenderGraphAccess::TransferWrite:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true };
+	}
+	__debugbreak();
+	return {};
+}
+
+VulkanRenderGraph::VulkanRenderGraph()
+	:vk_device(VK_NULL_HANDLE), m_memoryAllocator(nullptr), m_resources(), m_passes(), m_memorySlots(), m_finalBarriers(),
+	vk_extent(), m_barrierCount(0), m_transientMemorySize(0), m_imageBarriers()
+{
+
+}
+
+VulkanRenderGraph::~VulkanRenderGraph()
+{
+
+}
+
+void VulkanRenderGraph::Init(const VkDevice& device, VulkanMemoryAllocator& memoryAllocator)
+{
+	vk_device = device;
+	m_memoryAllocator = &memoryAllocator;
+}
+
+uint32_t VulkanRenderGraph::AddTransientImage(const char* name, const RenderGraphImageInfo& imageInfo)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.imageInfo = imageInfo;
+	m_resources.push_back(std::move(resource));
+	return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+uint32_t VulkanRenderGraph::ImportImage(const char* name, const RenderGraphImageInfo& imageInfo,
+	VkImageLayout vk_finalLayout, VkPipelineStageFlags vk_initialStages)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.image = true;
+	resource.imported = true;
+	resource.output = true;
+	resource.imageInfo = imageInfo;
+	resource.vk_finalLayout = vk_finalLayout;
+	resource.vk_initialStages = vk_initialStages;
+	m_resources.push_back(std::move(resource));
+	return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+uint32_t VulkanRenderGraph::ImportBuffer(const char* name)
+{
+	Resource resource{};
+	resource.name = name;
+	resource.imported = true;
+	m_resources.push_back(std::move(resource));
+	return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+void VulkanRenderGraph::MarkOutput(uint32_t resource)
+{
+	m_resources[resource].output = true;
+}
+
+uint32_t VulkanRenderGraph::AddPass(const char* name, bool graphics, RecordFunction record)
+{
+	Pass pass{};
+	pass.name = name;
+	pass.graphics = graphics;
+	pass.record = std::move(record);
+	m_passes.push_back(std::move(pass));
+	return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+void VulkanRenderGraph::Use(uint32_t passIndex, uint32_t resource, RenderGraphAccess access)
+{
+	RenderGraphAccessInfo accessInfo = GetRenderGraphAccessInfo(access);
+	//The accesses without a layout can only be made to buffers
+	if (m_resources[resource].image && accessInfo.vk_layout == VK_IMAGE_LAYOUT_UNDEFINED)
+	{
+		__debugbreak();
+	}
+
+	Pass& pass = m_passes[passIndex];
+	for (PassUse& use : pass.uses)
+	{
+		if (use.resource != resource)
+		{
+			continue;
+		}
+		//An image stays in the same layout for the whole pass
+		if (m_resources[resource].image && use.accessInfo.vk_layout != accessInfo.vk_layout)
+		{
+			__debugbreak();
+		}
+		use.accessInfo.vk_stages |= accessInfo.vk_stages;
+		use.accessInfo.vk_access |= accessInfo.vk_access;
+		use.accessInfo.write = use.accessInfo.write || accessInfo.write;
+		return;
+	}
+	pass.uses.push_back({ resource, accessInfo, false, {}, UINT32_MAX });
+}
+
+void VulkanRenderGraph::ClearAttachment(uint32_t passIndex, uint32_t resource, const VkClearValue& vk_clearValue)
+{
+	for (PassUse& use : m_passes[passIndex].uses)
+	{
+		if (use.resource == resource && IsAttachmentLayout(use.accessInfo.vk_layout) && use.resolveSource == UINT32_MAX)
+		{
+			use.clear = true;
+			use.vk_clearValue = vk_clearValue;
+			return;
+		}
+	}
+	//Only the attachments of the pass can be cleared, so the resource needs to be used as one first
+	__debugbreak();
+}
+
+void VulkanRenderGraph::ResolveAttachment(uint32_t passIndex, uint32_t source, uint32_t destination)
+{
+	//A resolve goes from a multisampled image to a single sampled one of the same format
+	const RenderGraphImageInfo& sourceInfo = m_resources[source].imageInfo;
+	const RenderGraphImageInfo& destinationInfo = m_resources[destination].imageInfo;
+	if (sourceInfo.vk_samples == VK_SAMPLE_COUNT_1_BIT || destinationInfo.vk_samples != VK_SAMPLE_COUNT_1_BIT ||
+		sourceInfo.vk_format != destinationInfo.vk_format)
+	{
+		__debugbreak();
+	}
+
+	Pass& pass = m_passes[passIndex];
+	auto findUse = [&pass](uint32_t resource) -> PassUse*
+		{
+			for (PassUse& use : pass.uses)
+			{
+				if (use.resource == resource && use.accessInfo.vk_layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+				{
+					return &use;
+				}
+			}
+			return nullptr;
+		};
+	PassUse* sourceUse = findUse(source);
+	PassUse* destinationUse = findUse(destination);
+	//Both need to be color attachments of the pass, and the destination can't be cleared or resolved into twice
+	if (!sourceUse || !destinationUse || destinationUse->clear || destinationUse->resolveSource != UINT32_MAX)
+	{
+		__debugbreak();
+	}
+	destinationUse->resolveSource = source;
+}
+
+void VulkanRenderGraph::Compile()
+{
+	CullPasses();
+	AssignTransientImages();
+	for (uint32_t i = 0; i < m_passes.size(); ++i)
+	{
+		if (!m_passes[i].culled && m_passes[i].graphics)
+		{
+			CreateRenderPass(i);
+		}
+	}
+	DeriveBarriers();
+}
+
+void VulkanRenderGraph::CullPasses()
+{
+	//Whether the contents of each resource, as they are before the pass being visited, are needed by an output
+	std::vector<bool> needed(m_resources.size());
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		needed[i] = m_resources[i].output;
+	}
+
+	for (uint32_t i = static_cast<uint32_t>(m_passes.size()); i-- > 0;)
+	{
+		Pass& pass = m_passes[i];
+		pass.culled = std::none_of(pass.uses.begin(), pass.uses.end(),
+			[&needed](const PassUse& use) { return use.accessInfo.write && needed[use.resource]; });
+		if (pass.culled)
+		{
+			continue;
+		}
+		/* The pass needs whatever it reads, and whatever it writes without clearing first, since it may only write to
+		   part of it. A cleared or resolved into attachment does not depend on the passes that wrote to it before */
+		for (const PassUse& use : pass.uses)
+		{
+			needed[use.resource] = !use.clear && use.resolveSource == UINT32_MAX;
+		}
+	}
+}
+
+void VulkanRenderGraph::AssignTransientImages()
+{
+	for (Resource& resource : m_resources)
+	{
+		resource.vk_usage = 0;
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = 0;
+	}
+	for (uint32_t i = 0; i < m_passes.size(); ++i)
+	{
+		if (m_passes[i].culled)
+		{
+			continue;
+		}
+		for (const PassUse& use : m_passes[i].uses)
+		{
+			Resource& resource = m_resources[use.resource];
+			resource.firstPass = std::min(resource.firstPass, i);
+			resource.lastPass = i;
+			resource.vk_usage |= GetImageUsage(use.accessInfo.vk_layout);
+		}
+	}
+
+	std::vector<uint32_t> transientImages;
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		Resource& resource = m_resources[i];
+		if (!resource.image || resource.imported || resource.firstPass == UINT32_MAX)
+		{
+			continue;
+		}
+		/* An image that only a single pass uses as an attachment is neither loaded nor stored by its render pass, so it
+		   never has to leave tile memory and can be a transient attachment */
+		VkImageUsageFlags vk_attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		if (!(resource.vk_usage & ~vk_attachmentUsage) && resource.firstPass == resource.lastPass && !resource.output)
+		{
+			resource.vk_usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+		transientImages.push_back(i);
+	}
+
+	/* Each image takes the memory of an image that is no longer used by the time it is first used. Only images with the
+	   same usage (and the same format for depth images) share memory, since they are guaranteed the same memory types */
+	std::stable_sort(transientImages.begin(), transientImages.end(),
+		[this](uint32_t a, uint32_t b) { return m_resources[a].firstPass < m_resources[b].firstPass; });
+	m_memorySlots.clear();
+	for (uint32_t resourceIndex : transientImages)
+	{
+		Resource& resource = m_resources[resourceIndex];
+		uint32_t slotIndex = 0;
+		for (; slotIndex < m_memorySlots.size(); ++slotIndex)
+		{
+			const Resource& previous = m_resources[m_memorySlots[slotIndex].resources.back()];
+			bool sameFormat = previous.imageInfo.vk_format == resource.imageInfo.vk_format ||
+				resource.imageInfo.vk_aspect == VK_IMAGE_ASPECT_COLOR_BIT;
+			if (previous.vk_usage == resource.vk_usage && sameFormat && previous.lastPass < resource.firstPass)
+			{
+				break;
+			}
+		}
+		if (slotIndex == m_memorySlots.size())
+		{
+			m_memorySlots.push_back(MemorySlot{});
+		}
+		m_memorySlots[slotIndex].resources.push_back(resourceIndex);
+		resource.memorySlot = slotIndex;
+	}
+}
+
+void VulkanRenderGraph::CreateRenderPass(uint32_t passIndex)
+{
+	Pass& pass = m_passes[passIndex];
+	//Whether a pass that was not culled uses the resource, or writes to it if asked to
+	auto passUses = [this](uint32_t otherPass, uint32_t resource, bool write)
+		{
+			const Pass& other = m_passes[otherPass];
+			return !other.culled && std::any_of(other.uses.begin(), other.uses.end(), [resource, write](const PassUse& use)
+				{ return use.resource == resource && (use.accessInfo.write || !write); });
+		};
+
+	/* The barriers of the graph move the attachments into the layouts they are used in before the render pass begins, so
+	   the attachments start and end the render pass in those layouts and the render pass needs no dependencies */
+	std::vector<VkAttachmentDescription> attachmentInfos;
+	std::vector<VkAttachmentReference> colorAttachmentRefs;
+	VkAttachmentReference vk_depthAttachmentRef{};
+	bool hasDepthAttachment = false;
+	pass.attachments.clear();
+	pass.clearValues.clear();
+	for (const PassUse& use : pass.uses)
+	{
+		const Resource& resource = m_resources[use.resource];
+		if (!resource.image || !IsAttachmentLayout(use.accessInfo.vk_layout))
+		{
+			continue;
+		}
+		//The contents are loaded if an earlier pass wrote them and stored if a later pass or the end of the frame needs them
+		bool writtenBefore = false;
+		for (uint32_t i = 0; i < passIndex && !writtenBefore; ++i)
+		{
+			writtenBefore = passUses(i, use.resource, true);
+		}
+		bool usedAfter = resource.output;
+		for (uint32_t i = passIndex + 1; i < m_passes.size() && !usedAfter; ++i)
+		{
+			usedAfter = passUses(i, use.resource, false);
+		}
+
+		VkAttachmentDescription vk_attachmentInfo{};
+		vk_attachmentInfo.format = resource.imageInfo.vk_format;
+		vk_attachmentInfo.samples = resource.imageInfo.vk_samples;
+		//The resolve overwrites the whole render area of a resolve attachment, so there is nothing to load into it
+		vk_attachmentInfo.loadOp = use.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR :
+			(writtenBefore && use.resolveSource == UINT32_MAX ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+		vk_attachmentInfo.storeOp = usedAfter ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		bool hasStencil = (resource.imageInfo.vk_aspect & VK_IMAGE_ASPECT_STENCIL_BIT) != 0;
+		vk_attachmentInfo.stencilLoadOp = hasStencil ? vk_attachmentInfo.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		vk_attachmentInfo.stencilStoreOp = hasStencil ? vk_attachmentInfo.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		vk_attachmentInfo.initialLayout = use.accessInfo.vk_layout;
+		vk_attachmentInfo.finalLayout = use.accessInfo.vk_layout;
+
+		VkAttachmentReference vk_attachmentRef{ static_cast<uint32_t>(attachmentInfos.size()), use.accessInfo.vk_layout };
+		if (use.accessInfo.vk_layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+		{
+			//A subpass has a single depth attachment
+			if (hasDepthAttachment)
+			{
+				__debugbreak();
+			}
+			vk_depthAttachmentRef = vk_attachmentRef;
+			hasDepthAttachment = true;
+		}
+		else if (use.resolveSource == UINT32_MAX)
+		{
+			colorAttachmentRefs.push_back(vk_attachmentRef);
+		}
+		attachmentInfos.push_back(vk_attachmentInfo);
+		pass.attachments.push_back(use.resource);
+		pass.clearValues.push_back(use.clear ? use.vk_clearValue : VkClearValue{});
+	}
+
+	/* The resolve attachments are matched to the color attachments by their index, the color attachments that are not 
+	   resolved have an unused reference. A multisampled attachment that is only resolved is not stored, so with the resolve
+	   in the subpass its samples never have to leave the tile memory of the graphics card */
+	std::vector<VkAttachmentReference> resolveAttachmentRefs;
+	for (const PassUse& use : pass.uses)
+	{
+		if (use.resolveSource == UINT32_MAX)
+		{
+			continue;
+		}
+		if (resolveAttachmentRefs.empty())
+		{
+			resolveAttachmentRefs.resize(colorAttachmentRefs.size(), { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+		}
+		uint32_t sourceAttachment = static_cast<uint32_t>(
+			std::find(pass.attachments.begin(), pass.attachments.end(), use.resolveSource) - pass.attachments.begin());
+		uint32_t destinationAttachment = static_cast<uint32_t>(
+			std::find(pass.attachments.begin(), pass.attachments.end(), use.resource) - pass.attachments.begin());
+		for (uint32_t i = 0; i < colorAttachmentRefs.size(); ++i)
+		{
+			if (colorAttachmentRefs[i].attachment == sourceAttachment)
+			{
+				resolveAttachmentRefs[i] = { destinationAttachment, use.accessInfo.vk_layout };
+			}
+		}
+	}
+
+	VkSubpassDescription vk_subpassInfo{};
+	vk_subpassInfo.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	vk_subpassInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentRefs.size());
+	vk_subpassInfo.pColorAttachments = colorAttachmentRefs.data();
+	vk_subpassInfo.pResolveAttachments = resolveAttachmentRefs.empty() ? nullptr : resolveAttachmentRefs.data();
+	vk_subpassInfo.pDepthStencilAttachment = hasDepthAttachment ? &vk_depthAttachmentRef : nullptr;
+
+	VkRenderPassCreateInfo vk_renderPassInfo{};
+	vk_renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	vk_renderPassInfo.attachmentCount = static_cast<uint32_t>(attachmentInfos.size());
+	vk_renderPassInfo.pAttachments = attachmentInfos.data();
+	vk_renderPassInfo.subpassCount = 1;
+	vk_renderPassInfo.pSubpasses = &vk_subpassInfo;
+	VkRenderPass vk_renderPass;
+	CreateVulkanRenderPass(vk_renderPass, vk_renderPassInfo, vk_device);
+	pass.vk_renderPass = VulkanRenderPassHandle(vk_device, vk_renderPass);
+}
+
+void VulkanRenderGraph::DeriveBarriers()
+{
+	//The first use of an imported image waits for the stages that the semaphore guarding it is waited on with
+	std::vector<ResourceState> states(m_resources.size());
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		if (m_resources[i].imported && m_resources[i].image)
+		{
+			states[i].vk_writeStages = m_resources[i].vk_initialStages;
+		}
+	}
+
+	/* A transient image takes its memory over from the image that used the slot before it, which for the first image of a
+	   slot is the last one of the previous frame, so its first use waits for the last accesses of that image. The contents
+	   are discarded, so its layout starts out undefined */
+	std::vector<ResourceState> finalStates = states;
+	ApplyAccesses(finalStates, false);
+	for (const MemorySlot& slot : m_memorySlots)
+	{
+		for (uint32_t i = 0; i < slot.resources.size(); ++i)
+		{
+			uint32_t previous = slot.resources[(i + slot.resources.size() - 1) % slot.resources.size()];
+			states[slot.resources[i]].vk_writeStages = finalStates[previous].vk_writeStages | finalStates[previous].vk_readStages;
+			states[slot.resources[i]].vk_writeAccess = finalStates[previous].vk_writeAccess;
+		}
+	}
+	ApplyAccesses(states, true);
+
+	//The imported images are left in their final layouts for whatever comes after the frame, like presenting
+	m_finalBarriers = BarrierBatch{};
+	for (uint32_t i = 0; i < m_resources.size(); ++i)
+	{
+		const Resource& resource = m_resources[i];
+		if (!resource.imported || !resource.image || resource.firstPass == UINT32_MAX ||
+			states[i].vk_layout == resource.vk_finalLayout)
+		{
+			continue;
+		}
+		m_finalBarriers.vk_srcStages |= states[i].vk_writeStages | states[i].vk_readStages;
+		m_finalBarriers.vk_dstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		m_finalBarriers.imageTransitions.push_back({ i, states[i].vk_layout, resource.vk_finalLayout,
+			states[i].vk_writeAccess, 0 });
+	}
+
+	m_barrierCount = m_finalBarriers.vk_dstStages ? 1 : 0;
+	for (const Pass& pass : m_passes)
+	{
+		if (!pass.culled && pass.barriers.vk_dstStages)
+		{
+			++m_barrierCount;
+		}
+	}
+}
+
+void VulkanRenderGraph::ApplyAccesses(std::vector<ResourceState>& states, bool addBarriers)
+{
+	for (Pass& pass : m_passes)
+	{
+		if (pass.culled)
+		{
+			continue;
+		}
+		if (addBarriers)
+		{
+			pass.barriers = BarrierBatch{};
+		}
+		for (const PassUse& use : pass.uses)
+		{
+			ApplyAccess(states[use.resource], use.resource, use.accessInfo, addBarriers ? &pass.barriers : nullptr);
+		}
+	}
+}
+
+void VulkanRenderGraph::ApplyAccess(ResourceState& state, uint32_t resource, const RenderGraphAccessInfo& accessInfo,
+	BarrierBatch* batch)
+{
+	bool image = m_resources[resource].image;
+	bool layoutChange = image && state.vk_layout != accessInfo.vk_layout;
+	bool needsBarrier = false;
+	VkPipelineStageFlags vk_srcStages = 0;
+	if (accessInfo.write || layoutChange)
+	{
+		//Writing (or changing the layout) has to wait for every access since the last write, reads included
+		vk_srcStages = state.vk_writeStages | state.vk_readStages;
+		needsBarrier = layoutChange || vk_srcStages != 0;
+	}
+	else if (state.vk_writeStages && ((accessInfo.vk_stages & ~state.vk_visibleStages) ||
+		(accessInfo.vk_access & ~state.vk_visibleAccess)))
+	{
+		//Reading only has to wait for the last write, and only if it was not already made visible to the read
+		vk_srcStages = state.vk_writeStages;
+		needsBarrier = true;
+	}
+
+	if (needsBarrier && batch)
+	{
+		//Nothing has to be waited for by the first use of a resource that only needs its layout set
+		batch->vk_srcStages |= vk_srcStages;
+		if (!vk_srcStages)
+		{
+			batch->vk_srcStages |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		}
+		batch->vk_dstStages |= accessInfo.vk_stages;
+		if (image && (layoutChange || state.vk_writeAccess))
+		{
+			batch->imageTransitions.push_back({ resource, state.vk_layout, accessInfo.vk_layout, state.vk_writeAccess,
+				accessInfo.vk_access });
+		}
+		else if (!image && state.vk_writeAccess)
+		{
+			batch->vk_srcAccess |= state.vk_writeAccess;
+			batch->vk_dstAccess |= accessInfo.vk_access;
+		}
+	}
+
+	if (accessInfo.write || layoutChange)
+	{
+		/* A layout transition is a write as well, the accesses after it have to wait for the access it was made for. Until
+		   a write is followed by a barrier, no access has seen it */
+		state.vk_layout = image ? accessInfo.vk_layout : state.vk_layout;
+		state.vk_writeStages = accessInfo.vk_stages;
+		state.vk_writeAccess = accessInfo.write ? (accessInfo.vk_access & RENDER_GRAPH_WRITE_ACCESS) : 0;
+		state.vk_readStages = accessInfo.write ? 0 : accessInfo.vk_stages;
+		state.vk_visibleStages = accessInfo.write ? 0 : accessInfo.vk_stages;
+		state.vk_visibleAccess = accessInfo.write ? 0 : accessInfo.vk_access;
+	}
+	else
+	{
+		state.vk_readStages |= accessInfo.vk_stages;
+		if (needsBarrier)
+		{
+			state.vk_visibleStages |= accessInfo.vk_stages;
+			state.vk_visibleAccess |= accessInfo.vk_access;
+		}
+	}
+}
+
+void VulkanRenderGraph::SetImportedImages(uint32_t resource, const std::vector<VkImage>& images,
+	const std::vector<VkImageView>& imageViews)
+{
+	m_resources[resource].importedImages = images;
+	m_resources[resource].importedViews = imageViews;
+}
+
+void VulkanRenderGraph::CreateAttachments(const VkExtent2D& vk_attachmentExtent)
+{
+	vk_extent = vk_attachmentExtent;
+	m_transientMemorySize = 0;
+	for (MemorySlot& slot : m_memorySlots)
+	{
+		//The memory of the slot needs to satisfy the requirements of every image that uses it
+		VkMemoryRequirements vk_slotRequirements{ 0, 1, UINT32_MAX };
+		for (uint32_t resourceIndex : slot.resources)
+		{
+			Resource& resource = m_resources[resourceIndex];
+			VkImageCreateInfo vk_imageInfo{};
+			vk_imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			vk_imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			vk_imageInfo.format = resource.imageInfo.vk_format;
+			vk_imageInfo.extent = { vk_extent.width, vk_extent.height, 1 };
+			vk_imageInfo.mipLevels = 1;
+			vk_imageInfo.arrayLayers = 1;
+			vk_imageInfo.samples = resource.imageInfo.vk_samples;
+			vk_imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			vk_imageInfo.usage = resource.vk_usage;
+			vk_imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			vk_imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkImage vk_image;
+			if (vkCreateImage(vk_device, &vk_imageInfo, nullptr, &vk_image) != VK_SUCCESS)
+			{
+				__debugbreak();
+			}
+			resource.vk_image = VulkanImageHandle(vk_device, vk_image);
+
+			VkMemoryRequirements vk_imageRequirements;
+			vkGetImageMemoryRequirements(vk_device, vk_image, &vk_imageRequirements);
+			vk_slotRequirements.size = std::max(vk_slotRequirements.size, vk_imageRequirements.size);
+			vk_slotRequirements.alignment = std::max(vk_slotRequirements.alignment, vk_imageRequirements.alignment);
+			vk_slotRequirements.memoryTypeBits &= vk_imageRequirements.memoryTypeBits;
+		}
+
+		/* Transient attachments go into lazily allocated memory where the device has it, which a tiled GPU only backs with
+		   memory if the attachment has to leave tile memory after all. The other devices use device local memory. The
+		   attachments are sized like the render target, so every slot gets a dedicated allocation */
+		bool transientAttachments = (m_resources[slot.resources.front()].vk_usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+		bool allocated = transientAttachments && m_memoryAllocator->Allocate(vk_slotRequirements,
+			VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, 0, false, true, VulkanAllocationStrategy::Buddy, slot.allocation);
+		if (!allocated && !m_memoryAllocator->Allocate(vk_slotRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, false,
+			true, VulkanAllocationStrategy::Buddy, slot.allocation))
+		{
+			__debugbreak();
+		}
+		m_transientMemorySize += slot.allocation.size;
+
+		for (uint32_t resourceIndex : slot.resources)
+		{
+			Resource& resource = m_resources[resourceIndex];
+			vkBindImageMemory(vk_device, resource.vk_image, slot.allocation.vk_memory, slot.allocation.offset);
+
+			VkImageViewCreateInfo vk_imageViewInfo{};
+			vk_imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			vk_imageViewInfo.image = resource.vk_image;
+			vk_imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			vk_imageViewInfo.format = resource.imageInfo.vk_format;
+			vk_imageViewInfo.subresourceRange = { resource.imageInfo.vk_aspect, 0, 1, 0, 1 };
+			VkImageView vk_imageView;
+			CreateVulkanSwapchainImageViews(vk_imageView, vk_imageViewInfo, vk_device);
+			resource.vk_imageView = VulkanImageViewHandle(vk_device, vk_imageView);
+		}
+	}
+
+	for (Pass& pass : m_passes)
+	{
+		if (pass.culled || !pass.graphics)
+		{
+			continue;
+		}
+		//A framebuffer is created for each image of the imported attachments, like one for each swapchain image
+		size_t framebufferCount = 1;
+		for (uint32_t resourceIndex : pass.attachments)
+		{
+			if (m_resources[resourceIndex].imported)
+			{
+				framebufferCount = std::max(framebufferCount, m_resources[resourceIndex].importedViews.size());
+			}
+		}
+		pass.framebuffers.resize(framebufferCount);
+		std::vector<VkImageView> attachmentViews(pass.attachments.size());
+		for (size_t i = 0; i < framebufferCount; ++i)
+		{
+			for (size_t j = 0; j < pass.attachments.size(); ++j)
+			{
+				const Resource& resource = m_resources[pass.attachments[j]];
+				attachmentViews[j] = resource.imported ? resource.importedViews[i % resource.importedViews.size()] :
+					resource.vk_imageView.Get();
+			}
+			VkFramebufferCreateInfo vk_framebufferInfo{};
+			vk_framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			vk_framebufferInfo.renderPass = pass.vk_renderPass;
+			vk_framebufferInfo.attachmentCount = static_cast<uint32_t>(attachmentViews.size());
+			vk_framebufferInfo.pAttachments = attachmentViews.data();
+			vk_framebufferInfo.width = vk_extent.width;
+			vk_framebufferInfo.height = vk_extent.height;
+			vk_framebufferInfo.layers = 1;
+			VkFramebuffer vk_framebuffer;
+			CreateVulkanFramebuffer(vk_framebuffer, vk_framebufferInfo, vk_device);
+			pass.framebuffers[i] = VulkanFramebufferHandle(vk_device, vk_framebuffer);
+		}
+	}
+}
+
+void VulkanRenderGraph::ReleaseAttachments(VulkanDeletionQueue& deletionQueue)
+{
+	//The framebuffers go first since they use the image views, and the memory last since the images are bound to it
+	for (Pass& pass : m_passes)
+	{
+		deletionQueue.Retire(pass.framebuffers);
+	}
+	for (Resource& resource : m_resources)
+	{
+		deletionQueue.Retire(std::move(resource.vk_imageView));
+		deletionQueue.Retire(std::move(resource.vk_image));
+	}
+	for (MemorySlot& slot : m_memorySlots)
+	{
+		if (slot.allocation.vk_memory == VK_NULL_HANDLE)
+		{
+			continue;
+		}
+		VulkanMemoryAllocator* memoryAllocator = m_memoryAllocator;
+		VulkanAllocation allocation = slot.allocation;
+		slot.allocation = VulkanAllocation{};
+		deletionQueue.Retire([memoryAllocator, allocation]() mutable { memoryAllocator->Free(allocation); });
+	}
+	m_transientMemorySize = 0;
+}
+
+void VulkanRenderGraph::Execute(const VkCommandBuffer& vk_commandBuffer, uint32_t frameIndex, uint32_t imageIndex)
+{
+	for (Pass& pass : m_passes)
+	{
+		if (pass.culled)
+		{
+			continue;
+		}
+		RecordBarriers(vk_commandBuffer, pass.barriers, imageIndex);
+		RenderGraphPassContext context{ vk_commandBuffer, frameIndex, imageIndex, {} };
+		if (pass.graphics)
+		{
+			VkOffset2D vk_renderAreaOffset{ 0, 0 };
+			CreateVulkanRenderPassBeginInfo(context.vk_renderPassBegin, pass.framebuffers[imageIndex % pass.framebuffers.size()],
+				pass.vk_renderPass, vk_extent, vk_renderAreaOffset, static_cast<uint32_t>(pass.clearValues.size()),
+				pass.clearValues.data());
+		}
+		pass.record(context);
+	}
+	RecordBarriers(vk_commandBuffer, m_finalBarriers, imageIndex);
+}
+
+void VulkanRenderGraph::RecordBarriers(const VkCommandBuffer& vk_commandBuffer, const BarrierBatch& batch,
+	uint32_t imageIndex)
+{
+	if (!batch.vk_dstStages)
+	{
+		return;
+	}
+
+	m_imageBarriers.clear();
+	for (const ImageTransition& transition : batch.imageTransitions)
+	{
+		VkImageMemoryBarrier vk_imageBarrier{};
+		vk_imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		vk_imageBarrier.srcAccessMask = transition.vk_srcAccess;
+		vk_imageBarrier.dstAccessMask = transition.vk_dstAccess;
+		vk_imageBarrier.oldLayout = transition.vk_oldLayout;
+		vk_imageBarrier.newLayout = transition.vk_newLayout;
+		vk_imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vk_imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		vk_imageBarrier.image = GetImage(transition.resource, imageIndex);
+		vk_imageBarrier.subresourceRange = { m_resources[transition.resource].imageInfo.vk_aspect, 0, 1, 0, 1 };
+		m_imageBarriers.push_back(vk_imageBarrier);
+	}
+
+	//The buffers share a single memory barrier, since a barrier covers every buffer in the stages it waits for anyway
+	VkMemoryBarrier vk_memoryBarrier{};
+	vk_memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	vk_memoryBarrier.srcAccessMask = batch.vk_srcAccess;
+	vk_memoryBarrier.dstAccessMask = batch.vk_dstAccess;
+	vkCmdPipelineBarrier(vk_commandBuffer, batch.vk_srcStages, batch.vk_dstStages, 0, batch.vk_srcAccess ? 1 : 0,
+		&vk_memoryBarrier, 0, nullptr, static_cast<uint32_t>(m_imageBarriers.size()), m_imageBarriers.data());
+}
+
+VkImage VulkanRenderGraph::GetImage(uint32_t resource, uint32_t imageIndex) const
+{
+	const Resource& imageResource = m_resources[resource];
+	if (imageResource.imported)
+	{
+		return imageResource.importedImages[imageIndex % imageResource.importedImages.size()];
+	}
+	return imageResource.vk_image;
+}
+
+void VulkanRenderGraph::Cleanup()
+{
+	//The frames in flight need to have finished, the attachments and render passes are destroyed right away
+	for (Pass& pass : m_passes)
+	{
+		pass.framebuffers.clear();
+		pass.vk_renderPass.Reset();
+	}
+	for (Resource& resource : m_resources)
+	{
+		resource.vk_imageView.Reset();
+		resource.vk_image.Reset();
+	}
+	for (MemorySlot& slot : m_memorySlots)
+	{
+		if (slot.allocation.vk_memory != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->Free(slot.allocation);
+		}
+	}
+	m_passes.clear();
+	m_resources.clear();
+	m_memorySlots.clear();
+	m_finalBarriers = BarrierBatch{};
+	m_transientMemorySize = 0;
+}
\ No newline at end of file
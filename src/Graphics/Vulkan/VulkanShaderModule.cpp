@@ -0,0 +1,15 @@
+#include "VulkanGraphics.h"
+
+void CreateVulkanShaderModule(VkShaderModule& vk_shaderModule, const ShaderCode& shaderCode, const VkDevice& vk_device)
+{
+	VkShaderModuleCreateInfo vk_shaderModuleInfo{};
+	vk_shaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	vk_shaderModuleInfo.codeSize = shaderCode.GetSize();
+	vk_shaderModuleInfo.pCode = shaderCode.GetWords();
+	VkResult vk_shaderModuleCreationResult = vkCreateShaderModule(vk_device, &vk_shaderModuleInfo, nullptr, 
+		&vk_shaderModule);
+	if (vk_shaderModuleCreationResult != VK_SUCCESS)
+	{
+		__debugbreak();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "glfwVulkan.h"
+
+/* The SPIR-V of the shaders, compiled by Shaders/compileShaders into the lists of words in Shaders/Generated that are 
+   embedded here as constexpr arrays, so creating the shader modules doesn't touch the disk. The lists are committed, and
+   need to be generated again whenever a shader changes. Only VulkanGraphics.cpp includes this header, so the words are
+   only embedded once */
+#if !__has_include("../../../Shaders/Generated/shader.vert.inc")
+#error "Shaders/Generated/shader.vert.inc is missing, run Shaders/compileShaders to generate it"
+#endif
+constexpr uint32_t SHADER_VERT_SPIRV[] =
+{
+#include "../../../Shaders/Generated/shader.vert.inc"
+};
+constexpr size_t SHADER_VERT_WORD_COUNT = sizeof(SHADER_VERT_SPIRV) / sizeof(uint32_t);
+
+#if !__has_include("../../../Shaders/Generated/shader.frag.inc")
+#error "Shaders/Generated/shader.frag.inc is missing, run Shaders/compileShaders to generate it"
+#endif
+constexpr uint32_t SHADER_FRAG_SPIRV[] =
+{
+#include "../../../Shaders/Generated/shader.frag.inc"
+};
+constexpr size_t SHADER_FRAG_WORD_COUNT = sizeof(SHADER_FRAG_SPIRV) / sizeof(uint32_t);
+
+#if !__has_include("../../../Shaders/Generated/cull.comp.inc")
+#error "Shaders/Generated/cull.comp.inc is missing, run Shaders/compileShaders to generate it"
+#endif
+constexpr uint32_t CULL_COMP_SPIRV[] =
+{
+#include "../../../Shaders/Generated/cull.comp.inc"
+};
+constexpr size_t CULL_COMP_WORD_COUNT = sizeof(CULL_COMP_SPIRV) / sizeof(uint32_t);
+
+//A shader of the registry, found by its name and stage
+struct EmbeddedShader
+{
+	const char* name;
+	VkShaderStageFlagBits vk_stage;
+	const uint32_t* words;
+	size_t wordCount;
+	//The compiled file of the shader inside the shader directory, read instead of the words when it is overridden
+	const char* filename;
+};
+
+constexpr EmbeddedShader EMBEDDED_SHADERS[] =
+{
+	{ "shader", VK_SHADER_STAGE_VERTEX_BIT, SHADER_VERT_SPIRV, SHADER_VERT_WORD_COUNT, "vert.spv" },
+	{ "shader", VK_SHADER_STAGE_FRAGMENT_BIT, SHADER_FRAG_SPIRV, SHADER_FRAG_WORD_COUNT, "frag.spv" },
+	{ "cull", VK_SHADER_STAGE_COMPUTE_BIT, CULL_COMP_SPIRV, CULL_COMP_WORD_COUNT, "cull.spv" }
+};
+
+constexpr bool ShaderNamesMatch(const char* name, const char* otherName)
+{
+	while (*name && *name == *otherName)
+	{
+		++name;
+		++otherName;
+	}
+	return *name == *otherName;
+}
+
+//Returns null if the registry has no shader with the name and stage, which fails to compile where a constant is needed
+constexpr const EmbeddedShader* FindEmbeddedShader(const char* name, VkShaderStageFlagBits vk_stage)
+{
+	for (const EmbeddedShader& shader : EMBEDDED_SHADERS)
+	{
+		if (shader.vk_stage == vk_stage && ShaderNamesMatch(shader.name, name))
+		{
+			return &shader;
+		}
+	}
+	return nullptr;
+}
+
+//The shaders the application uses, looked up while compiling so that a name or stage that is wrong is a compile error
+constexpr const EmbeddedShader& APP_VERTEX_SHADER = *FindEmbeddedShader("shader", VK_SHADER_STAGE_VERTEX_BIT);
+constexpr const EmbeddedShader& APP_FRAGMENT_SHADER = *FindEmbeddedShader("shader", VK_SHADER_STAGE_FRAGMENT_BIT);
+constexpr const EmbeddedShader& CULLING_SHADER = *FindEmbeddedShader("cull", VK_SHADER_STAGE_COMPUTE_BIT);
\ No newline at end of file
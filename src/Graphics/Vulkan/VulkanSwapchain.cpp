@@ -29,8 +29,18 @@ void ChooseVulkanSurfaceFormat(VkSurfaceFormatKHR& vk_surfaceFormat,
 }
 
 void ChooseVulkanSwapchainPresentMode(VkPresentModeKHR& vk_swapchainPresentMode,
-    const std::vector<VkPresentModeKHR>& availablePresentModes)
+    const std::vector<VkPresentModeKHR>& availablePresentModes, VkPresentModeKHR vk_preferredPresentMode)
 {
+    //The present mode the application asked for is used if the surface supports it
+    for (uint32_t i = 0; i < availablePresentModes.size(); ++i)
+    {
+        if (availablePresentModes[i] == vk_preferredPresentMode)
+        {
+            vk_swapchainPresentMode = availablePresentModes[i];
+            return;
+        }
+    }
+
     for (uint32_t i = 0; i < availablePresentModes.size(); ++i)
     {
         if (availablePresentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)
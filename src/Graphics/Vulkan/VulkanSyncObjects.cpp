@@ -1,7 +1,7 @@
 #include "VulkanGraphics.h"
 
 VulkanSyncObjects::VulkanSyncObjects()
-	:vk_imageAvailableSemaphore(), vk_renderFinishedSemaphore(), vk_framesInFlightFence()
+	:frames(), imagesInFlight(), currentFrame(0)
 {
 
 }
@@ -11,26 +11,39 @@ VulkanSyncObjects::~VulkanSyncObjects()
 
 }
 
-void VulkanSyncObjects::CreateSyncObjects(const VkDevice& vk_device)
+void VulkanSyncObjects::CreateSyncObjects(const VkDevice& vk_device, uint32_t framesInFlight, uint32_t swapchainImageCount)
 {
+	frames.resize(framesInFlight);
+	//No frame is using any of the swapchain images when the application starts
+	imagesInFlight.assign(swapchainImageCount, VK_NULL_HANDLE);
+	currentFrame = 0;
+
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	vkCreateSemaphore(vk_device, &semaphoreInfo, nullptr, &vk_imageAvailableSemaphore);
-	vkCreateSemaphore(vk_device, &semaphoreInfo, nullptr, &vk_renderFinishedSemaphore);
-
 	VkFenceCreateInfo fenceInfo{};
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	//The fence will start as already signaled since we do not want to wait for it on the first draw command
+	//The fences will start as already signaled since we do not want to wait for them on the first draw command of each slot
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-	vkCreateFence(vk_device, &fenceInfo, nullptr, &vk_framesInFlightFence);
+	for (FrameInFlightData& frame : frames)
+	{
+		VkSemaphore vk_imageAvailableSemaphore;
+		VkSemaphore vk_renderFinishedSemaphore;
+		vkCreateSemaphore(vk_device, &semaphoreInfo, nullptr, &vk_imageAvailableSemaphore);
+		vkCreateSemaphore(vk_device, &semaphoreInfo, nullptr, &vk_renderFinishedSemaphore);
+		frame.vk_imageAvailableSemaphore = VulkanSemaphoreHandle(vk_device, vk_imageAvailableSemaphore);
+		frame.vk_renderFinishedSemaphore = VulkanSemaphoreHandle(vk_device, vk_renderFinishedSemaphore);
+
+		VkFence vk_framesInFlightFence;
+		vkCreateFence(vk_device, &fenceInfo, nullptr, &vk_framesInFlightFence);
+		frame.vk_framesInFlightFence = VulkanFenceHandle(vk_device, vk_framesInFlightFence);
+	}
 }
 
 void VulkanSyncObjects::Cleanup(const VkDevice& vk_device)
 {
-	vkDestroySemaphore(vk_device, vk_imageAvailableSemaphore, nullptr);
-	vkDestroySemaphore(vk_device, vk_renderFinishedSemaphore, nullptr);
-
-	vkDestroyFence(vk_device, vk_framesInFlightFence, nullptr);
+	//The semaphores and the fence of each slot are destroyed with it
+	frames.clear();
+	imagesInFlight.clear();
 }
\ No newline at end of file
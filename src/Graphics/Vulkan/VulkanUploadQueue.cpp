@@ -0,0 +1,283 @@
+#include "VulkanGraphics.h"
+#include <algorithm>
+#include <cstring>
+
+//Ranges of the ring start at this alignment so that the copies out of it stay efficient
+constexpr VkDeviceSize STAGING_RING_ALIGNMENT = 16;
+
+/* The uploaded buffers are read as vertex and index buffers, and as storage buffers by the fragment shader (the bindless
+   materials), so the copies are made visible to both */
+constexpr VkPipelineStageFlags UPLOAD_READ_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | 
+	VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+constexpr VkAccessFlags UPLOAD_READ_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | 
+	VK_ACCESS_SHADER_READ_BIT;
+
+VulkanUploadQueue::VulkanUploadQueue()
+	:vk_device(VK_NULL_HANDLE), m_memoryAllocator(nullptr), m_graphicsQueueFamily(0), m_transferQueueFamily(0),
+	m_dedicatedTransferQueue(false), vk_transferQueue(VK_NULL_HANDLE), vk_transferCommandPool(VK_NULL_HANDLE), m_frames(),
+	m_stagingRing(), m_maxChunkSize(0), m_ringHead(0), m_ringUsedBytes(0), m_unflushedRingBytes(0), m_regions(),
+	m_pendingUploads(), m_nextTicket(1), m_submittedTicket(0)
+{
+
+}
+
+VulkanUploadQueue::~VulkanUploadQueue()
+{
+
+}
+
+void VulkanUploadQueue::Init(const VkDevice& device, VulkanMemoryAllocator& memoryAllocator, 
+	const QueueFamilyIndices& gpuQueueFamilies, const VkQueue& transferQueue, uint32_t framesInFlight, VkDeviceSize ringSize)
+{
+	vk_device = device;
+	m_memoryAllocator = &memoryAllocator;
+	m_graphicsQueueFamily = gpuQueueFamilies.graphics;
+	m_transferQueueFamily = gpuQueueFamilies.transfer;
+	m_dedicatedTransferQueue = gpuQueueFamilies.transfer != gpuQueueFamilies.graphics;
+	vk_transferQueue = transferQueue;
+
+	//The staging ring is only written by the CPU and read by copies, it stays mapped for as long as it lives
+	CreateVulkanBuffer(m_stagingRing, ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 0, VulkanAllocationStrategy::Linear,
+		vk_device, memoryAllocator);
+	if (!m_stagingRing.allocation.mappedData)
+	{
+		__debugbreak();
+	}
+	m_maxChunkSize = ringSize / 4;
+	m_ringHead = 0;
+	m_ringUsedBytes = 0;
+	m_unflushedRingBytes = 0;
+
+	m_frames.resize(framesInFlight);
+	//Without a dedicated transfer queue the copies are recorded in the graphics command buffer of the frame
+	if (!m_dedicatedTransferQueue)
+	{
+		return;
+	}
+
+	VkCommandPoolCreateInfo vk_commandPoolInfo{};
+	vk_commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	vk_commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	vk_commandPoolInfo.queueFamilyIndex = m_transferQueueFamily;
+	CreateVulkanCommandPool(vk_transferCommandPool, vk_commandPoolInfo, vk_device);
+
+	VkCommandBufferAllocateInfo vk_commandBufferInfo{};
+	vk_commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	vk_commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	vk_commandBufferInfo.commandPool = vk_transferCommandPool;
+	vk_commandBufferInfo.commandBufferCount = 1;
+	VkSemaphoreCreateInfo vk_semaphoreInfo{};
+	vk_semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	for (UploadFrame& frame : m_frames)
+	{
+		AllocateVulkanCommandBuffer(frame.vk_commandBuffer, vk_device, vk_commandBufferInfo);
+		vkCreateSemaphore(vk_device, &vk_semaphoreInfo, nullptr, &frame.vk_uploadFinishedSemaphore);
+	}
+}
+
+uint64_t VulkanUploadQueue::QueueBufferUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data,
+	VkDeviceSize size)
+{
+	return QueueUpload(vk_dstBuffer, dstOffset, data, size, false);
+}
+
+uint64_t VulkanUploadQueue::QueueBorrowedBufferUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data,
+	VkDeviceSize size)
+{
+	return QueueUpload(vk_dstBuffer, dstOffset, data, size, true);
+}
+
+uint64_t VulkanUploadQueue::QueueUpload(const VkBuffer& vk_dstBuffer, VkDeviceSize dstOffset, const void* data, 
+	VkDeviceSize size, bool borrowData)
+{
+	uint64_t ticket = m_nextTicket++;
+	if (size == 0)
+	{
+		return ticket;
+	}
+
+	//Uploads that are already waiting go first, so that uploads to the same range are applied in the order they were queued
+	VkDeviceSize ringOffset;
+	if (m_pendingUploads.empty() && size <= m_maxChunkSize && ReserveRingRange(size, ringOffset))
+	{
+		std::memcpy(static_cast<char*>(m_stagingRing.allocation.mappedData) + ringOffset, data, size);
+		m_regions.push_back({ vk_dstBuffer, { ringOffset, dstOffset, size } });
+		return ticket;
+	}
+
+	//The data does not fit in the ring right now, it is kept on the CPU instead of waiting for a frame slot to free its range
+	PendingUpload upload;
+	upload.vk_dstBuffer = vk_dstBuffer;
+	upload.dstOffset = dstOffset;
+	upload.borrowedData = borrowData ? static_cast<const char*>(data) : nullptr;
+	if (!borrowData)
+	{
+		upload.ownedData.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+	}
+	upload.size = size;
+	upload.uploadedBytes = 0;
+	upload.ticket = ticket;
+	m_pendingUploads.push_back(std::move(upload));
+	return ticket;
+}
+
+void VulkanUploadQueue::DiscardBufferUploads(const VkBuffer& vk_dstBuffer)
+{
+	//The ring ranges of the discarded regions stay reserved and are given back with the rest of the frame's ranges
+	m_regions.erase(std::remove_if(m_regions.begin(), m_regions.end(),
+		[&vk_dstBuffer](const UploadRegion& region) { return region.vk_dstBuffer == vk_dstBuffer; }), m_regions.end());
+	m_pendingUploads.erase(std::remove_if(m_pendingUploads.begin(), m_pendingUploads.end(),
+		[&vk_dstBuffer](const PendingUpload& upload) { return upload.vk_dstBuffer == vk_dstBuffer; }), m_pendingUploads.end());
+}
+
+VkSemaphore VulkanUploadQueue::Flush(const VkCommandBuffer& vk_graphicsCommandBuffer, uint32_t frameIndex)
+{
+	UploadFrame& frame = m_frames[frameIndex];
+
+	//The fence of the slot has signaled, so the copies it submitted the last time it was used are done reading the ring
+	m_ringUsedBytes -= frame.ringBytes;
+	StreamPendingUploads();
+	frame.ringBytes = m_unflushedRingBytes;
+	m_unflushedRingBytes = 0;
+	m_submittedTicket = m_pendingUploads.empty() ? m_nextTicket - 1 : m_pendingUploads.front().ticket - 1;
+
+	if (m_regions.empty())
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	VkSemaphore vk_uploadSemaphore = VK_NULL_HANDLE;
+	std::vector<VkBufferMemoryBarrier> barriers;
+	if (m_dedicatedTransferQueue)
+	{
+		/* The copies run on the transfer queue, the graphics queue only waits for them right before vertex input. The slot's 
+		   previous transfer submission is done since the graphics submission that waited for it has signaled its fence */
+		vkResetCommandBuffer(frame.vk_commandBuffer, 0);
+		VkCommandBufferBeginInfo vk_commandBufferBegin{};
+		CreateVulkanCommandBufferBeginInfo(vk_commandBufferBegin, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
+		vkBeginCommandBuffer(frame.vk_commandBuffer, &vk_commandBufferBegin);
+		RecordCopies(frame.vk_commandBuffer);
+		//Releasing the written ranges from the transfer family, the matching acquire is recorded on the graphics family
+		CreateUploadBarriers(barriers, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+		vkCmdPipelineBarrier(frame.vk_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+		vkEndCommandBuffer(frame.vk_commandBuffer);
+
+		VkSubmitInfo vk_submitInfo{};
+		CreateVulkanSubmitInfo(vk_submitInfo, 0, nullptr, nullptr, 1, frame.vk_commandBuffer, 1,
+			&frame.vk_uploadFinishedSemaphore);
+		vkQueueSubmit(vk_transferQueue, 1, &vk_submitInfo, VK_NULL_HANDLE);
+
+		/* The acquire waits on the semaphore at vertex input, so it is chained to the semaphore wait by using vertex input 
+		   as its first stage as well. The fragment shader runs after vertex input, so the wait covers its reads too */
+		CreateUploadBarriers(barriers, 0, UPLOAD_READ_ACCESS);
+		vkCmdPipelineBarrier(vk_graphicsCommandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, UPLOAD_READ_STAGES, 0, 0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+		vk_uploadSemaphore = frame.vk_uploadFinishedSemaphore;
+	}
+	else
+	{
+		//The copies are recorded at the start of the frame's own command buffer, before its render pass reads the buffers
+		RecordCopies(vk_graphicsCommandBuffer);
+		CreateUploadBarriers(barriers, VK_ACCESS_TRANSFER_WRITE_BIT, UPLOAD_READ_ACCESS);
+		vkCmdPipelineBarrier(vk_graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_READ_STAGES, 0, 0, nullptr,
+			static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+	}
+
+	m_regions.clear();
+	return vk_uploadSemaphore;
+}
+
+void VulkanUploadQueue::Cleanup()
+{
+	for (UploadFrame& frame : m_frames)
+	{
+		vkDestroySemaphore(vk_device, frame.vk_uploadFinishedSemaphore, nullptr);
+	}
+	m_frames.clear();
+	//Destroying the pool frees the command buffers that were allocated from it
+	vkDestroyCommandPool(vk_device, vk_transferCommandPool, nullptr);
+	vk_transferCommandPool = VK_NULL_HANDLE;
+	DestroyVulkanBuffer(m_stagingRing, vk_device, *m_memoryAllocator);
+
+	m_regions.clear();
+	m_pendingUploads.clear();
+}
+
+bool VulkanUploadQueue::ReserveRingRange(VkDeviceSize size, VkDeviceSize& ringOffset)
+{
+	VkDeviceSize offset = (m_ringHead + STAGING_RING_ALIGNMENT - 1) & ~(STAGING_RING_ALIGNMENT - 1);
+	VkDeviceSize padding = offset - m_ringHead;
+	//The range does not fit before the end of the ring, so it wraps around and the end of the ring is left unused
+	if (offset + size > m_stagingRing.size)
+	{
+		offset = 0;
+		padding = m_stagingRing.size - m_ringHead;
+	}
+
+	/* Frame slots give their ranges back in the order they reserved them, so the used bytes are always a single range 
+	   that ends at the head, and everything after the head up to the start of that range is free */
+	if (m_ringUsedBytes + padding + size > m_stagingRing.size)
+	{
+		return false;
+	}
+	m_ringUsedBytes += padding + size;
+	m_unflushedRingBytes += padding + size;
+	m_ringHead = offset + size;
+	ringOffset = offset;
+	return true;
+}
+
+void VulkanUploadQueue::StreamPendingUploads()
+{
+	char* ringData = static_cast<char*>(m_stagingRing.allocation.mappedData);
+	while (!m_pendingUploads.empty())
+	{
+		PendingUpload& upload = m_pendingUploads.front();
+		VkDeviceSize chunkSize = std::min(upload.size - upload.uploadedBytes, m_maxChunkSize);
+		VkDeviceSize ringOffset;
+		//The ring is full for this frame, the rest of the data will be streamed once the next slots give their ranges back
+		if (!ReserveRingRange(chunkSize, ringOffset))
+		{
+			return;
+		}
+
+		const char* uploadData = upload.borrowedData ? upload.borrowedData : upload.ownedData.data();
+		std::memcpy(ringData + ringOffset, uploadData + upload.uploadedBytes, chunkSize);
+		m_regions.push_back({ upload.vk_dstBuffer, { ringOffset, upload.dstOffset + upload.uploadedBytes, chunkSize } });
+		upload.uploadedBytes += chunkSize;
+		if (upload.uploadedBytes == upload.size)
+		{
+			m_pendingUploads.pop_front();
+		}
+	}
+}
+
+void VulkanUploadQueue::RecordCopies(const VkCommandBuffer& vk_commandBuffer)
+{
+	for (const UploadRegion& region : m_regions)
+	{
+		vkCmdCopyBuffer(vk_commandBuffer, m_stagingRing.vk_buffer, region.vk_dstBuffer, 1, &region.vk_copy);
+	}
+}
+
+void VulkanUploadQueue::CreateUploadBarriers(std::vector<VkBufferMemoryBarrier>& barriers, VkAccessFlags vk_srcAccess,
+	VkAccessFlags vk_dstAccess)
+{
+	barriers.resize(m_regions.size());
+	for (size_t i = 0; i < m_regions.size(); ++i)
+	{
+		VkBufferMemoryBarrier& barrier = barriers[i];
+		barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = vk_srcAccess;
+		barrier.dstAccessMask = vk_dstAccess;
+		//Without a dedicated transfer queue the ranges never change owner, so the barrier only makes the copies visible
+		barrier.srcQueueFamilyIndex = m_dedicatedTransferQueue ? m_transferQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = m_dedicatedTransferQueue ? m_graphicsQueueFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = m_regions[i].vk_dstBuffer;
+		barrier.offset = m_regions[i].vk_copy.dstOffset;
+		barrier.size = m_regions[i].vk_copy.size;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "VulkanGraphics.h"
+
+VertexLayout GetVertexLayout(VertexFormat format)
+{
+	if (format == VertexFormat::Quantized)
+	{
+		return { sizeof(QuantizedVertex), { VERTEX_ATTRIBUTE_LAYOUT(QuantizedVertex, position), 
+			VERTEX_ATTRIBUTE_LAYOUT(QuantizedVertex, color) } };
+	}
+	return { sizeof(Vertex), { VERTEX_ATTRIBUTE_LAYOUT(Vertex, position), VERTEX_ATTRIBUTE_LAYOUT(Vertex, color) } };
+}
+
+void QuantizeVertices(const std::vector<Vertex>& vertices, std::vector<QuantizedVertex>& quantizedVertices)
+{
+	quantizedVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const Vertex& vertex = vertices[i];
+		QuantizedVertex& quantizedVertex = quantizedVertices[i];
+		quantizedVertex.position[0].bits = FloatToHalf(vertex.position[0]);
+		quantizedVertex.position[1].bits = FloatToHalf(vertex.position[1]);
+		quantizedVertex.color[0].value = FloatToUnorm8(vertex.color[0]);
+		quantizedVertex.color[1].value = FloatToUnorm8(vertex.color[1]);
+		quantizedVertex.color[2].value = FloatToUnorm8(vertex.color[2]);
+		quantizedVertex.color[3].value = 255;
+	}
+}
\ No newline at end of file
@@ -1,8 +1,18 @@
 #pragma once
 
+#ifdef _WIN32
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 //GLFW will include its own definitions and automatically load the Vulkan header with it
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
-#include <GLFW/glfw3native.h>
\ No newline at end of file
+#include <GLFW/glfw3native.h>
+#endif
+
+//__debugbreak is an MSVC intrinsic, other compilers (like the ones on headless linux servers) raise a trap signal instead
+#ifndef _MSC_VER
+#include <csignal>
+#define __debugbreak() raise(SIGTRAP)
+#endif
\ No newline at end of file
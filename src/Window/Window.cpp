@@ -1,7 +1,7 @@
 #include "Window.h"
 
 WindowHandle::WindowHandle()
-	:glfw_window{nullptr}, m_width{0}, m_height{0}
+	:glfw_window{nullptr}, m_width{0}, m_height{0}, m_resizeCount{0}, m_damageCount{0}
 {
 
 }
@@ -26,6 +26,25 @@ void WindowHandle::Init()
 	glfw_window = glfwCreateWindow(m_width, m_height, "Vulkan", nullptr, nullptr);
 
 	glfwSetWindowUserPointer(glfw_window, this);
+	glfwSetFramebufferSizeCallback(glfw_window, FramebufferResizeCallback);
+	glfwSetWindowRefreshCallback(glfw_window, WindowRefreshCallback);
+	//The framebuffer size can differ from the window size on high dpi displays
+	glfwGetFramebufferSize(glfw_window, &m_width, &m_height);
+}
+
+void WindowHandle::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
+{
+	WindowHandle* windowHandle = reinterpret_cast<WindowHandle*>(glfwGetWindowUserPointer(window));
+	windowHandle->m_width = width;
+	windowHandle->m_height = height;
+	++windowHandle->m_resizeCount;
+	++windowHandle->m_damageCount;
+}
+
+void WindowHandle::WindowRefreshCallback(GLFWwindow* window)
+{
+	WindowHandle* windowHandle = reinterpret_cast<WindowHandle*>(glfwGetWindowUserPointer(window));
+	++windowHandle->m_damageCount;
 }
 
 void WindowHandle::CreateVulkanWindowSurface(const VkInstance& vk_instance, VkSurfaceKHR& vk_surface) const
@@ -37,9 +56,36 @@ void WindowHandle::CreateVulkanWindowSurface(const VkInstance& vk_instance, VkSu
 	}
 }
 
+void WindowHandle::GetRequiredVulkanInstanceExtensions(std::vector<const char*>& requiredInstanceExtensions) const
+{
+	uint32_t glfwExtensionCount = 0;
+	const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+	requiredInstanceExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+}
+
 void WindowHandle::MainLoop()
 {
-	glfwPollEvents();
+	//While the window is minimized nothing is rendered, so we sleep until an event (like restoring the window) arrives
+	if (IsMinimized())
+	{
+		glfwWaitEvents();
+	}
+	else
+	{
+		glfwPollEvents();
+	}
+}
+
+void WindowHandle::WaitForEvents(double timeoutSeconds)
+{
+	if (timeoutSeconds > 0.0)
+	{
+		glfwWaitEventsTimeout(timeoutSeconds);
+	}
+	else
+	{
+		glfwWaitEvents();
+	}
 }
 
 void WindowHandle::Cleanup()
@@ -1,7 +1,22 @@
 #pragma once
 
+#include <vector>
 #include "Graphics/Vulkan/glfwVulkan.h"
 
+/* The parts of the window that the graphics need every frame, copied out of the window handle so that they can be handed
+   to a renderer running on another thread */
+struct WindowState
+{
+	//The size of the window's framebuffer in pixels
+	int width;
+	int height;
+	//See WindowHandle::GetResizeCount and WindowHandle::GetDamageCount
+	uint32_t resizeCount;
+	uint32_t damageCount;
+
+	inline bool IsMinimized() const { return width == 0 || height == 0; }
+};
+
 class WindowHandle
 {
 public:
@@ -16,6 +31,9 @@ public:
 	// Called when initializing vulkan to create a window surface to interface with the window
 	void CreateVulkanWindowSurface(const VkInstance& vk_instance, VkSurfaceKHR& vk_surface) const;
 
+	//Called before creating the vulkan instance to retrieve the instance extensions that the window system needs
+	void GetRequiredVulkanInstanceExtensions(std::vector<const char*>& requiredInstanceExtensions) const;
+
 	void Cleanup();
 
 	//Getter functions....
@@ -23,19 +41,44 @@ public:
 
 	inline int GetHeight() const { return m_height; }
 
+	/* Incremented every time the framebuffer of the window is resized, so that the graphics can tell that the swapchain 
+	   needs to be recreated by comparing it with the value they saw last */
+	inline uint32_t GetResizeCount() const { return m_resizeCount; }
+
+	/* Incremented every time the window system asks for the contents of the window to be drawn again (like when it was 
+	   uncovered) or its framebuffer is resized, so that rendering on demand can tell that the last frame is stale */
+	inline uint32_t GetDamageCount() const { return m_damageCount; }
+
+	//A minimized window has a framebuffer with no area, there is nothing to render to until it is restored
+	inline bool IsMinimized() const { return m_width == 0 || m_height == 0; }
+
+	inline WindowState GetState() const { return { m_width, m_height, m_resizeCount, m_damageCount }; }
+
 	inline const GLFWwindow* GetGLFWwindow() { return glfw_window; }
 	//....End getter functions
 
 	//Calls any functions needed to update the window system
 	void MainLoop();
 
+	/* Sleeps until an event arrives or the timeout in seconds passes, instead of polling. Used when there is nothing new 
+	   to render, or by the event thread when the graphics render on their own thread. A timeout of 0 waits for an event */
+	void WaitForEvents(double timeoutSeconds);
+
 	inline bool ShouldClose() const { return glfwWindowShouldClose(glfw_window); }
 
 private:
+	//Called by glfw when the framebuffer of the window changes size, the window handle is retrieved from the user pointer
+	static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
+
+	//Called by glfw when the contents of the window need to be drawn again
+	static void WindowRefreshCallback(GLFWwindow* window);
 
 private:
 	GLFWwindow* glfw_window;
 
+	//The size of the window's framebuffer in pixels
 	int m_width;
 	int m_height;
+	uint32_t m_resizeCount;
+	uint32_t m_damageCount;
 };
\ No newline at end of file